@@ -21,6 +21,8 @@
 */
 
 #include "AcoustIDFingerprinter.h"
+#include "MappedAudioReader.h"
+#include "SpectralFingerprinter.h"
 
 #ifdef HAVE_CHROMAPRINT
 #include <chromaprint.h>
@@ -29,10 +31,12 @@
 //==============================================================================
 AcoustIDFingerprinter::AcoustIDFingerprinter()
 {
+    formatManager.registerBasicFormats();
 }
 
 AcoustIDFingerprinter::~AcoustIDFingerprinter()
 {
+    freeContext();
 }
 
 //==============================================================================
@@ -55,15 +59,12 @@ bool AcoustIDFingerprinter::processAudioFile(const juce::File& audioFile,
                                             int& duration)
 {
 #ifndef HAVE_CHROMAPRINT
-    // Generate a fallback fingerprint based on file metadata
-    // This allows the application to continue functioning even without Chromaprint
-    DBG("[AcoustIDFingerprinter] Chromaprint library not available - using fallback fingerprinting");
-    
-    // Create fallback fingerprint using file hash and basic audio properties
-    juce::AudioFormatManager formatManager;
-    formatManager.registerBasicFormats();
+    // Without Chromaprint, fall back to the built-in spectral fingerprint. It is
+    // not AcoustID-compatible, but it is computed from the audio itself, so copies
+    // of the same recording get the same fingerprint wherever they are stored
+    DBG("[AcoustIDFingerprinter] Chromaprint library not available - using spectral fingerprint");
     
-    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(audioFile));
+    auto reader = MappedAudioReader::createReaderFor(formatManager, audioFile);
     
     if (reader == nullptr)
     {
@@ -71,26 +72,55 @@ bool AcoustIDFingerprinter::processAudioFile(const juce::File& audioFile,
         return false;
     }
     
-    // Generate a simple fingerprint from audio properties
-    juce::String hashBase = audioFile.getFullPathName();
-    hashBase += juce::String(reader->sampleRate);
-    hashBase += juce::String(reader->numChannels);
-    hashBase += juce::String(reader->lengthInSamples);
-    hashBase += juce::String(audioFile.getSize());
+    SpectralFingerprinter spectralFingerprinter;
+    
+    if (!spectralFingerprinter.prepare(*reader))
+    {
+        lastError = "Invalid audio file for fallback fingerprinting: " + audioFile.getFileName();
+        return false;
+    }
+    
+    const int chunkSize = 4096;
+    juce::AudioBuffer<float> buffer(static_cast<int>(reader->numChannels), chunkSize);
+    
+    MappedAudioReader::prefetch(*reader, 0, juce::jmin(reader->lengthInSamples,
+                                                       (juce::int64) (SpectralFingerprinter::maxSeconds * reader->sampleRate)));
+    
+    for (juce::int64 position = 0; spectralFingerprinter.wantsMoreAudio(); position += chunkSize)
+    {
+        if (juce::Thread::currentThreadShouldExit())
+        {
+            lastError = "Fingerprinting cancelled: " + audioFile.getFileName();
+            DBG("[AcoustIDFingerprinter] " << lastError);
+            return false;
+        }
+        
+        const int samplesToRead = static_cast<int>(juce::jmin((juce::int64) chunkSize, reader->lengthInSamples - position));
+        
+        reader->read(&buffer, 0, samplesToRead, position, true, true);
+        spectralFingerprinter.processBlock(buffer, samplesToRead, position);
+    }
+    
+    if (!spectralFingerprinter.finish())
+    {
+        lastError = "Audio too short to fingerprint: " + audioFile.getFileName();
+        return false;
+    }
+    
+    // Words are stored little-endian, as in the AudioFingerprints table
+    juce::MemoryOutputStream bits;
+    
+    for (auto word : spectralFingerprinter.getFingerprint())
+        bits.writeInt(static_cast<int>(word));
     
-    // Use JUCE's hash function
-    fingerprint = "FALLBACK_" + juce::String(hashBase.hashCode64());
+    fingerprint = "SPECTRAL_" + juce::Base64::toBase64(bits.getData(), bits.getDataSize());
     duration = static_cast<int>(reader->lengthInSamples / reader->sampleRate);
     
-    DBG("[AcoustIDFingerprinter] Generated fallback fingerprint for: " << audioFile.getFileName());
+    DBG("[AcoustIDFingerprinter] Generated spectral fingerprint for: " << audioFile.getFileName());
     return true;
 #else
-    // Create audio format manager and register formats
-    juce::AudioFormatManager formatManager;
-    formatManager.registerBasicFormats();
-    
     // Try to read the file
-    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(audioFile));
+    auto reader = MappedAudioReader::createReaderFor(formatManager, audioFile);
     
     if (reader == nullptr)
     {
@@ -99,78 +129,138 @@ bool AcoustIDFingerprinter::processAudioFile(const juce::File& audioFile,
         return false;
     }
     
-    // Create chromaprint context
-    ChromaprintContext* ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_DEFAULT);
-    if (ctx == nullptr)
-    {
-        lastError = "Failed to create Chromaprint context";
-        DBG("[AcoustIDFingerprinter] " << lastError);
-        return false;
-    }
-    
-    // Initialize chromaprint with sample rate and number of channels
     int sampleRate = static_cast<int>(reader->sampleRate);
     int numChannels = static_cast<int>(reader->numChannels);
     
-    if (!chromaprint_start(ctx, sampleRate, numChannels))
-    {
-        lastError = "Failed to start Chromaprint";
-        DBG("[AcoustIDFingerprinter] " << lastError);
-        chromaprint_free(ctx);
+    if (!startStream(sampleRate, numChannels))
         return false;
-    }
     
     // Read audio data in chunks and feed to chromaprint
     const int chunkSize = 4096;
     juce::AudioBuffer<float> buffer(numChannels, chunkSize);
     
-    // Chromaprint expects 16-bit PCM, so we'll convert
-    std::vector<int16_t> int16Buffer(chunkSize * numChannels);
-    
     int64_t totalSamplesRead = 0;
-    int64_t maxSamplesToRead = reader->lengthInSamples;
+    int64_t maxSamplesToRead = juce::jmin(reader->lengthInSamples, (juce::int64) getMaxSamplesForFingerprint(sampleRate));
     
-    // Limit to first 2 minutes for performance (120 seconds)
-    const int64_t maxSamplesForFingerprint = sampleRate * 120;
-    if (maxSamplesToRead > maxSamplesForFingerprint)
-        maxSamplesToRead = maxSamplesForFingerprint;
+    // Two minutes of PCM is small enough to ask for in one go
+    MappedAudioReader::prefetch(*reader, 0, maxSamplesToRead);
     
     while (totalSamplesRead < maxSamplesToRead)
     {
+        // Callers on worker threads must be able to stop between chunks
+        if (juce::Thread::currentThreadShouldExit())
+        {
+            lastError = "Fingerprinting cancelled: " + audioFile.getFileName();
+            DBG("[AcoustIDFingerprinter] " << lastError);
+            return false;
+        }
+        
         int samplesToRead = static_cast<int>(juce::jmin((int64_t)chunkSize, maxSamplesToRead - totalSamplesRead));
         
         reader->read(&buffer, 0, samplesToRead, totalSamplesRead, true, true);
         
-        // Convert float samples to 16-bit integers
-        for (int sample = 0; sample < samplesToRead; ++sample)
-        {
-            for (int channel = 0; channel < numChannels; ++channel)
-            {
-                float floatSample = buffer.getSample(channel, sample);
-                // Clamp to [-1, 1] and convert to 16-bit
-                floatSample = juce::jlimit(-1.0f, 1.0f, floatSample);
-                int16Buffer[sample * numChannels + channel] = static_cast<int16_t>(floatSample * 32767.0f);
-            }
-        }
+        if (!feedStream(buffer, samplesToRead))
+            return false;
         
-        // Feed data to chromaprint
-        if (!chromaprint_feed(ctx, int16Buffer.data(), samplesToRead * numChannels))
+        totalSamplesRead += samplesToRead;
+    }
+    
+    if (!finishStream(fingerprint))
+        return false;
+    
+    // Calculate duration
+    duration = static_cast<int>(reader->lengthInSamples / reader->sampleRate);
+    
+    DBG("[AcoustIDFingerprinter] Successfully generated fingerprint for: " << audioFile.getFileName());
+    DBG("[AcoustIDFingerprinter] Duration: " << duration << " seconds");
+    DBG("[AcoustIDFingerprinter] Fingerprint length: " << fingerprint.length() << " characters");
+    
+    return true;
+#endif
+}
+
+//==============================================================================
+bool AcoustIDFingerprinter::startStream(int sampleRate, int numChannels)
+{
+#ifndef HAVE_CHROMAPRINT
+    juce::ignoreUnused(sampleRate, numChannels);
+    lastError = "Chromaprint library not available";
+    return false;
+#else
+    // Create the chromaprint context once; chromaprint_start() resets it for each file
+    if (context == nullptr)
+    {
+        context = chromaprint_new(CHROMAPRINT_ALGORITHM_DEFAULT);
+        
+        if (context == nullptr)
         {
-            lastError = "Failed to feed data to Chromaprint";
+            lastError = "Failed to create Chromaprint context";
             DBG("[AcoustIDFingerprinter] " << lastError);
-            chromaprint_free(ctx);
             return false;
         }
-        
-        totalSamplesRead += samplesToRead;
     }
     
+    // Chromaprint gets mono audio already at its own working rate
+    if (!chromaprint_start(static_cast<ChromaprintContext*>(context), FingerprintResampler::outputSampleRate, 1))
+    {
+        lastError = "Failed to start Chromaprint";
+        DBG("[AcoustIDFingerprinter] " << lastError);
+        streamActive = false;
+        return false;
+    }
+    
+    resampler.prepare(sampleRate, numChannels);
+    streamActive = true;
+    return true;
+#endif
+}
+
+bool AcoustIDFingerprinter::feedStream(const juce::AudioBuffer<float>& block, int numSamples)
+{
+#ifndef HAVE_CHROMAPRINT
+    juce::ignoreUnused(block, numSamples);
+    return false;
+#else
+    if (!streamActive)
+    {
+        lastError = "Fingerprint stream not started";
+        return false;
+    }
+    
+    const int numOutput = resampler.process(block, numSamples);
+    
+    if (numOutput > 0 && !chromaprint_feed(static_cast<ChromaprintContext*>(context), resampler.getOutput(), numOutput))
+    {
+        lastError = "Failed to feed data to Chromaprint";
+        DBG("[AcoustIDFingerprinter] " << lastError);
+        streamActive = false;
+        return false;
+    }
+    
+    return true;
+#endif
+}
+
+bool AcoustIDFingerprinter::finishStream(juce::String& fingerprint)
+{
+#ifndef HAVE_CHROMAPRINT
+    juce::ignoreUnused(fingerprint);
+    return false;
+#else
+    if (!streamActive)
+    {
+        lastError = "Fingerprint stream not started";
+        return false;
+    }
+    
+    auto* ctx = static_cast<ChromaprintContext*>(context);
+    streamActive = false;
+    
     // Finish and get the fingerprint
     if (!chromaprint_finish(ctx))
     {
         lastError = "Failed to finish Chromaprint processing";
         DBG("[AcoustIDFingerprinter] " << lastError);
-        chromaprint_free(ctx);
         return false;
     }
     
@@ -180,7 +270,6 @@ bool AcoustIDFingerprinter::processAudioFile(const juce::File& audioFile,
     {
         lastError = "Failed to get fingerprint from Chromaprint";
         DBG("[AcoustIDFingerprinter] " << lastError);
-        chromaprint_free(ctx);
         return false;
     }
     
@@ -188,16 +277,16 @@ bool AcoustIDFingerprinter::processAudioFile(const juce::File& audioFile,
     fingerprint = juce::String(fingerprintCStr);
     chromaprint_dealloc(fingerprintCStr);
     
-    // Calculate duration
-    duration = static_cast<int>(reader->lengthInSamples / reader->sampleRate);
-    
-    // Clean up
-    chromaprint_free(ctx);
-    
-    DBG("[AcoustIDFingerprinter] Successfully generated fingerprint for: " << audioFile.getFileName());
-    DBG("[AcoustIDFingerprinter] Duration: " << duration << " seconds");
-    DBG("[AcoustIDFingerprinter] Fingerprint length: " << fingerprint.length() << " characters");
-    
     return true;
 #endif
 }
+
+void AcoustIDFingerprinter::freeContext()
+{
+#ifdef HAVE_CHROMAPRINT
+    if (context != nullptr)
+        chromaprint_free(static_cast<ChromaprintContext*>(context));
+#endif
+    context = nullptr;
+    streamActive = false;
+}
@@ -24,12 +24,25 @@
 
 #include <juce_core/juce_core.h>
 #include <juce_audio_formats/juce_audio_formats.h>
+#include "FingerprintResampler.h"
+#include <vector>
 
 //==============================================================================
 /**
     AcoustIDFingerprinter provides functionality to generate acoustic fingerprints
     using the Chromaprint library. These fingerprints can be used to identify
     tracks via the AcoustID/MusicBrainz service or detect duplicates.
+
+    Audio reaches Chromaprint as 11025 Hz mono 16-bit PCM, already downmixed
+    and resampled by a FingerprintResampler, which is the rate Chromaprint
+    works at internally.
+
+    Without Chromaprint, generateFingerprint() falls back to the built-in
+    SpectralFingerprinter and returns its words as "SPECTRAL_" plus Base64.
+
+    An instance keeps its audio format manager and Chromaprint context for its
+    whole lifetime, so keep one per thread and reuse it for every file rather
+    than creating one per track.
 */
 class AcoustIDFingerprinter
 {
@@ -49,6 +62,22 @@ public:
                             juce::String& fingerprint,
                             int& duration);
     
+    /**
+     * Streaming interface, for callers that already have decoded audio (the
+     * analysis pipeline). Call startStream(), then feedStream() for consecutive
+     * blocks up to getMaxSamplesForFingerprint(), then finishStream().
+     * startStream() resets the existing Chromaprint context instead of creating
+     * a new one. All three return false if Chromaprint is not available.
+     */
+    bool startStream(int sampleRate, int numChannels);
+    bool feedStream(const juce::AudioBuffer<float>& block, int numSamples);
+    bool finishStream(juce::String& fingerprint);
+    
+    /**
+     * Only the first two minutes of audio are fingerprinted.
+     */
+    static int64_t getMaxSamplesForFingerprint(int sampleRate)  { return (int64_t) sampleRate * 120; }
+    
     /**
      * Get the last error message.
      */
@@ -70,6 +99,12 @@ public:
 private:
     //==============================================================================
     juce::String lastError;
+    juce::AudioFormatManager formatManager;
+    void* context = nullptr;  // ChromaprintContext, created on first use and reused
+    bool streamActive = false;
+    FingerprintResampler resampler;
+    
+    void freeContext();
     
     // Helper to read audio data and pass to chromaprint
     bool processAudioFile(const juce::File& audioFile,
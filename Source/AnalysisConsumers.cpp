@@ -0,0 +1,180 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+#include "AnalysisConsumers.h"
+
+//==============================================================================
+MetadataConsumer::MetadataConsumer(DatabaseManager::Track& trackToFill)
+    : track(trackToFill)
+{
+}
+
+bool MetadataConsumer::prepare(const juce::AudioFormatReader& reader)
+{
+    // Calculate duration
+    if (reader.sampleRate > 0)
+        track.duration = reader.lengthInSamples / reader.sampleRate;
+
+    // Extract metadata from the reader
+    const auto& metadata = reader.metadataValues;
+
+    auto readTag = [&metadata](const char* lower, const char* upper)
+    {
+        if (metadata.containsKey(lower))
+            return metadata[lower];
+
+        if (metadata.containsKey(upper))
+            return metadata[upper];
+
+        return juce::String();
+    };
+
+    // Tags already read by TagReader take precedence
+    auto fillIfEmpty = [&readTag](juce::String& field, const char* lower, const char* upper)
+    {
+        if (field.isEmpty())
+            field = readTag(lower, upper);
+    };
+
+    fillIfEmpty(track.title, "title", "TITLE");
+    fillIfEmpty(track.artist, "artist", "ARTIST");
+    fillIfEmpty(track.album, "album", "ALBUM");
+    fillIfEmpty(track.genre, "genre", "GENRE");
+
+    DBG("[MetadataConsumer] Extracted metadata - Title: " << track.title
+        << ", Artist: " << track.artist
+        << ", Duration: " << track.duration << "s");
+
+    return true;
+}
+
+//==============================================================================
+FingerprintConsumer::FingerprintConsumer()
+{
+}
+
+bool FingerprintConsumer::prepare(const juce::AudioFormatReader& reader)
+{
+    fingerprint.clear();
+    samplesFed = 0;
+
+    const int sampleRate = static_cast<int>(reader.sampleRate);
+    samplesWanted = juce::jmin(reader.lengthInSamples,
+                               (juce::int64) AcoustIDFingerprinter::getMaxSamplesForFingerprint(sampleRate));
+
+    streamOk = fingerprinter.startStream(sampleRate, static_cast<int>(reader.numChannels));
+    return streamOk;
+}
+
+void FingerprintConsumer::beginWindow(juce::int64 startSample, juce::int64)
+{
+    // A jump ahead would splice unrelated audio into the fingerprint
+    if (startSample != samplesFed)
+        samplesWanted = samplesFed;
+}
+
+void FingerprintConsumer::processBlock(const juce::AudioBuffer<float>& block, int numSamples, juce::int64)
+{
+    const int samplesToFeed = static_cast<int>(juce::jmin((juce::int64) numSamples, samplesWanted - samplesFed));
+
+    if (samplesToFeed <= 0)
+        return;
+
+    streamOk = fingerprinter.feedStream(block, samplesToFeed);
+    samplesFed += samplesToFeed;
+}
+
+bool FingerprintConsumer::wantsMoreAudio() const
+{
+    return streamOk && samplesFed < samplesWanted;
+}
+
+bool FingerprintConsumer::finish()
+{
+    if (!streamOk)
+        return false;
+
+    return fingerprinter.finishStream(fingerprint);
+}
+
+//==============================================================================
+WaveformOverviewConsumer::WaveformOverviewConsumer(int numBinsToUse)
+    : numBins(juce::jmax(1, numBinsToUse))
+{
+}
+
+bool WaveformOverviewConsumer::prepare(const juce::AudioFormatReader& reader)
+{
+    // Consumers are reused across files, so never leave the previous result behind
+    overview = {};
+
+    if (reader.lengthInSamples <= 0 || reader.sampleRate <= 0)
+        return false;
+
+    samplesPerBin = juce::jmax((juce::int64) 1, (reader.lengthInSamples + numBins - 1) / numBins);
+    binMin.assign((size_t) numBins, 0.0f);
+    binMax.assign((size_t) numBins, 0.0f);
+
+    overview.duration = reader.lengthInSamples / reader.sampleRate;
+    return true;
+}
+
+void WaveformOverviewConsumer::processBlock(const juce::AudioBuffer<float>& block, int numSamples, juce::int64 startSample)
+{
+    int offset = 0;
+
+    // Walk the block in runs that fall into the same bin
+    while (offset < numSamples)
+    {
+        const auto position = startSample + offset;
+        const auto bin = (size_t) juce::jmin((juce::int64) numBins - 1, position / samplesPerBin);
+        const auto binEnd = ((juce::int64) bin + 1) * samplesPerBin;
+        const int runLength = static_cast<int>(juce::jmin((juce::int64) (numSamples - offset), binEnd - position));
+
+        for (int channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            auto range = juce::FloatVectorOperations::findMinAndMax(block.getReadPointer(channel, offset), runLength);
+            binMin[bin] = juce::jmin(binMin[bin], range.getStart());
+            binMax[bin] = juce::jmax(binMax[bin], range.getEnd());
+        }
+
+        offset += runLength;
+    }
+}
+
+bool WaveformOverviewConsumer::finish()
+{
+    auto quantise = [](float value)
+    {
+        return static_cast<int8_t>(juce::roundToInt(juce::jlimit(-1.0f, 1.0f, value) * 127.0f));
+    };
+
+    overview.minMax.resize((size_t) numBins * 2);
+
+    for (size_t i = 0; i < (size_t) numBins; ++i)
+    {
+        overview.minMax[2 * i]     = quantise(binMin[i]);
+        overview.minMax[2 * i + 1] = quantise(binMax[i]);
+    }
+
+    return true;
+}
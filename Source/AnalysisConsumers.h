@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "AnalysisPipeline.h"
+#include "AcoustIDFingerprinter.h"
+#include "DatabaseManager.h"
+
+//==============================================================================
+/**
+    Reads duration from the reader, and fills in any tags (title, artist,
+    album, genre) the track does not have yet from the reader's metadata.
+    Needs no audio, so it never keeps the decoder running.
+*/
+class MetadataConsumer : public AnalysisConsumer
+{
+public:
+    /** Results are written straight into the given track. */
+    explicit MetadataConsumer(DatabaseManager::Track& trackToFill);
+
+    bool prepare(const juce::AudioFormatReader& reader) override;
+    void processBlock(const juce::AudioBuffer<float>&, int, juce::int64) override {}
+    bool wantsMoreAudio() const override { return false; }
+    bool finish() override { return true; }
+
+private:
+    DatabaseManager::Track& track;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MetadataConsumer)
+};
+
+//==============================================================================
+/**
+    Streams the first two minutes of audio into Chromaprint. The fingerprint
+    has to be continuous from the start of the file, so it ends at the first gap.
+*/
+class FingerprintConsumer : public AnalysisConsumer
+{
+public:
+    FingerprintConsumer();
+
+    bool prepare(const juce::AudioFormatReader& reader) override;
+    void beginWindow(juce::int64 startSample, juce::int64 numSamples) override;
+    void processBlock(const juce::AudioBuffer<float>& block, int numSamples, juce::int64 startSample) override;
+    bool wantsMoreAudio() const override;
+    bool finish() override;
+
+    /** The fingerprint of the last file, empty if fingerprinting failed. */
+    const juce::String& getFingerprint() const  { return fingerprint; }
+    juce::String getLastError() const           { return fingerprinter.getLastError(); }
+
+private:
+    AcoustIDFingerprinter fingerprinter;
+    juce::String fingerprint;
+    juce::int64 samplesWanted = 0;
+    juce::int64 samplesFed = 0;
+    bool streamOk = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FingerprintConsumer)
+};
+
+//==============================================================================
+/**
+    Builds the min/max waveform overview shown by WaveformComponent, so the UI
+    can draw a track without decoding it again. Every bin must come from real
+    audio, so the overview is only kept when the pipeline decoded the whole file.
+*/
+class WaveformOverviewConsumer : public AnalysisConsumer
+{
+public:
+    explicit WaveformOverviewConsumer(int numBins = defaultNumBins);
+
+    bool prepare(const juce::AudioFormatReader& reader) override;
+    void processBlock(const juce::AudioBuffer<float>& block, int numSamples, juce::int64 startSample) override;
+    bool wantsMoreAudio() const override { return true; }
+    bool finish() override;
+
+    /** The overview of the last file (trackId is left for the caller to fill in). */
+    const DatabaseManager::WaveformOverview& getOverview() const  { return overview; }
+
+    static constexpr int defaultNumBins = 1000;
+
+private:
+    const int numBins;
+    juce::int64 samplesPerBin = 1;
+    std::vector<float> binMin, binMax;
+    DatabaseManager::WaveformOverview overview;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveformOverviewConsumer)
+};
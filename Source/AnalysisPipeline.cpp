@@ -0,0 +1,237 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+#include "AnalysisPipeline.h"
+#include "MappedAudioReader.h"
+
+//==============================================================================
+AnalysisPipeline::AnalysisPipeline()
+{
+    formatManager.registerBasicFormats();
+}
+
+AnalysisPipeline::~AnalysisPipeline()
+{
+}
+
+//==============================================================================
+void AnalysisPipeline::addConsumer(AnalysisConsumer* consumer)
+{
+    if (consumer != nullptr)
+        consumers.push_back(consumer);
+}
+
+void AnalysisPipeline::clearConsumers()
+{
+    consumers.clear();
+}
+
+double AnalysisPipeline::getConsumerMs(const AnalysisConsumer* consumer) const
+{
+    for (size_t i = 0; i < consumers.size() && i < consumerMs.size(); ++i)
+    {
+        if (consumers[i] == consumer)
+            return consumerMs[i];
+    }
+
+    return 0.0;
+}
+
+bool AnalysisPipeline::process(const juce::File& audioFile)
+{
+    timings = {};
+    consumerMs.assign(consumers.size(), 0.0);
+    cancelled = false;
+    decodeFailed = false;
+    wholeFileDecoded = false;
+
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+    auto reader = MappedAudioReader::createReaderFor(formatManager, audioFile);
+    timings.openMs = juce::Time::getMillisecondCounterHiRes() - startTime;
+
+    if (reader == nullptr)
+    {
+        lastError = "Could not create audio reader for: " + audioFile.getFileName();
+        DBG("[AnalysisPipeline] " << lastError);
+        return false;
+    }
+
+    // Only consumers that accept this file take part in decoding
+    std::vector<size_t> active;
+    for (size_t i = 0; i < consumers.size(); ++i)
+    {
+        startTime = juce::Time::getMillisecondCounterHiRes();
+
+        if (consumers[i]->prepare(*reader))
+            active.push_back(i);
+
+        consumerMs[i] += juce::Time::getMillisecondCounterHiRes() - startTime;
+    }
+
+    // Later passes over a sampled file only run while someone is unsure of its result
+    auto anyoneNeedsMoreAudio = [this, &active]
+    {
+        for (auto i : active)
+        {
+            if (consumers[i]->wantsMoreAudio() && !consumers[i]->isConfident())
+                return true;
+        }
+        return false;
+    };
+
+    const int numChannels = static_cast<int>(reader->numChannels);
+    blockBuffer.setSize(numChannels, blockSize, false, false, true);
+
+    bytesPerSample = reader->lengthInSamples > 0 ? (double) audioFile.getSize() / (double) reader->lengthInSamples : 0.0;
+
+    const auto passes = policy.createPasses(reader->lengthInSamples, reader->sampleRate);
+    juce::int64 samplesDecoded = 0;
+    int numWindows = 0;
+
+    for (size_t pass = 0; pass < passes.size(); ++pass)
+    {
+        if (pass > 0 && !anyoneNeedsMoreAudio())
+            break;
+
+        bool keepGoing = true;
+
+        for (const auto& window : passes[pass])
+        {
+            keepGoing = decodeWindow(*reader, window, active, audioFile, samplesDecoded);
+            ++numWindows;
+
+            if (!keepGoing)
+                break;
+        }
+
+        if (!keepGoing)
+            break;
+    }
+
+    // A cancelled run's partial results are of no use to anyone
+    if (cancelled)
+    {
+        lastError = "Analysis cancelled: " + audioFile.getFileName();
+        DBG("[AnalysisPipeline] " << lastError << " after " << samplesDecoded << " samples");
+        return false;
+    }
+
+    // Results from a truncated or corrupt file would be stored as if it were whole
+    if (decodeFailed)
+        return false;
+
+    wholeFileDecoded = samplesDecoded >= reader->lengthInSamples;
+
+    for (auto i : active)
+    {
+        startTime = juce::Time::getMillisecondCounterHiRes();
+        consumers[i]->finish();
+        consumerMs[i] += juce::Time::getMillisecondCounterHiRes() - startTime;
+    }
+
+    DBG("[AnalysisPipeline] Decoded " << samplesDecoded << " of " << reader->lengthInSamples
+        << " samples in " << numWindows << " window(s) for " << (int) active.size() << " consumers: "
+        << audioFile.getFileName());
+
+    return true;
+}
+
+bool AnalysisPipeline::decodeWindow(juce::AudioFormatReader& reader, const AnalysisPolicy::Window& window,
+                                    const std::vector<size_t>& active, const juce::File& audioFile,
+                                    juce::int64& samplesDecoded)
+{
+    auto anyoneWantsAudio = [this, &active]
+    {
+        for (auto i : active)
+        {
+            if (consumers[i]->wantsMoreAudio())
+                return true;
+        }
+        return false;
+    };
+
+    // Runs the call on every consumer that still wants audio, timing each one
+    auto forEachListening = [this, &active](auto&& call)
+    {
+        for (auto i : active)
+        {
+            if (consumers[i]->wantsMoreAudio())
+            {
+                const auto startTime = juce::Time::getMillisecondCounterHiRes();
+                call(*consumers[i]);
+                consumerMs[i] += juce::Time::getMillisecondCounterHiRes() - startTime;
+            }
+        }
+    };
+
+    if (!anyoneWantsAudio())
+        return false;
+
+    forEachListening([&window](AnalysisConsumer& consumer) { consumer.beginWindow(window.start, window.length); });
+
+    const auto prefetchSamples = MappedAudioReader::getPrefetchSamples(reader);
+    juce::int64 prefetchedUntil = window.start;
+
+    for (juce::int64 position = window.start; position < window.getEnd();)
+    {
+        if (CancellationToken::shouldStop(cancellation))
+        {
+            cancelled = true;
+            return false;
+        }
+
+        if (!anyoneWantsAudio())
+            return false;
+
+        // Keep a mapped file's pages at least half a prefetch ahead of the decoder
+        if (prefetchedUntil < window.getEnd() && position + prefetchSamples / 2 >= prefetchedUntil)
+        {
+            const auto prefetchStart = juce::jmax(position, prefetchedUntil);
+            prefetchedUntil = juce::jmin(window.getEnd(), prefetchStart + prefetchSamples);
+            MappedAudioReader::prefetch(reader, prefetchStart, prefetchedUntil - prefetchStart);
+        }
+
+        const int numSamples = static_cast<int>(juce::jmin((juce::int64) blockSize, window.getEnd() - position));
+
+        if (readThrottle)
+            readThrottle((juce::int64) (numSamples * bytesPerSample));
+
+        const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+        if (!reader.read(&blockBuffer, 0, numSamples, position, true, true))
+        {
+            lastError = "Decoding failed at sample " + juce::String(position) + " of " + audioFile.getFileName();
+            DBG("[AnalysisPipeline] " << lastError);
+            decodeFailed = true;
+            return false;
+        }
+
+        timings.decodeMs += juce::Time::getMillisecondCounterHiRes() - startTime;
+
+        forEachListening([&](AnalysisConsumer& consumer) { consumer.processBlock(blockBuffer, numSamples, position); });
+
+        position += numSamples;
+        samplesDecoded += numSamples;
+    }
+
+    return true;
+}
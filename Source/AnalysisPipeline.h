@@ -0,0 +1,210 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "AnalysisPolicy.h"
+#include "CancellationToken.h"
+#include <functional>
+#include <vector>
+
+//==============================================================================
+/**
+    Interface for anything that wants to look at a track's decoded audio during
+    analysis (metadata, fingerprinting, waveform overview, and later BPM, key and
+    loudness analysers).
+
+    The pipeline calls prepare() once, then processBlock() for blocks of float
+    audio in file order, then finish(). Long files may be decoded in windows
+    (see AnalysisPolicy); beginWindow() announces each one. Consumers keep their
+    own results and expose them through their own getters.
+*/
+class AnalysisConsumer
+{
+public:
+    virtual ~AnalysisConsumer() = default;
+
+    /**
+     * Called once per file before any audio is decoded.
+     * @param reader The open reader (format, length, embedded metadata)
+     * @return False if this consumer cannot handle the file; it then receives no blocks
+     */
+    virtual bool prepare(const juce::AudioFormatReader& reader) = 0;
+
+    /**
+     * Called before the blocks of each decoded window. Windows of a sampled file
+     * skip parts of it, so consumers that carry state from one block to the next
+     * (filters, FFT frames) should restart it here.
+     * @param startSample Position of the window's first sample within the file
+     * @param numSamples Length of the window
+     */
+    virtual void beginWindow(juce::int64 startSample, juce::int64 numSamples)
+    {
+        juce::ignoreUnused(startSample, numSamples);
+    }
+
+    /**
+     * Called for each decoded block, in order.
+     * @param block Decoded audio, one channel per source channel
+     * @param numSamples Number of valid samples in block (the last block may be short)
+     * @param startSample Position of the first sample of the block within the file
+     */
+    virtual void processBlock(const juce::AudioBuffer<float>& block, int numSamples, juce::int64 startSample) = 0;
+
+    /**
+     * Whether this consumer still needs audio. Decoding stops as soon as no
+     * prepared consumer wants more, so e.g. a 2-minute fingerprint alone never
+     * decodes the rest of the file.
+     */
+    virtual bool wantsMoreAudio() const = 0;
+
+    /**
+     * Whether the result so far is good enough. After each pass over a sampled
+     * file the pipeline decodes the next one only while a consumer that still
+     * wants audio is not confident yet.
+     */
+    virtual bool isConfident() { return true; }
+
+    /**
+     * Called after the last block (or after decoding stopped early). Not called
+     * when the run is cancelled; the next prepare() starts over instead.
+     * @return False if the consumer could not produce a result
+     */
+    virtual bool finish() = 0;
+};
+
+//==============================================================================
+/**
+    AnalysisPipeline opens an audio file once, decodes it into fixed-size float
+    blocks and fans each block out to every registered AnalysisConsumer, so a
+    track is decoded a single time no matter how many analysers look at it.
+
+    Which parts get decoded is up to its AnalysisPolicy: short tracks whole,
+    long ones in sampled windows, with more decoded only while a consumer is
+    unsure of its result. Results that are only valid over every sample (the
+    waveform overview, loudness) can be checked with decodedWholeFile(). WAV and
+    AIFF files are memory-mapped (see MappedAudioReader) and prefetched ahead of
+    the decoder.
+*/
+class AnalysisPipeline
+{
+public:
+    //==============================================================================
+    AnalysisPipeline();
+    ~AnalysisPipeline();
+
+    /**
+     * Register a consumer for the next process() call. Consumers are not owned
+     * and must outlive the pipeline run.
+     */
+    void addConsumer(AnalysisConsumer* consumer);
+
+    /**
+     * Remove all registered consumers.
+     */
+    void clearConsumers();
+
+    /**
+     * The policy that picks the windows to decode.
+     */
+    AnalysisPolicy& getPolicy() { return policy; }
+
+    /**
+     * Set a function called before each block is decoded with the number of
+     * file bytes it will read (estimated from the file's average bit rate).
+     * It may block to pace disk I/O.
+     */
+    void setReadThrottle(std::function<void(juce::int64 numBytes)> throttle) { readThrottle = std::move(throttle); }
+
+    /**
+     * Set a token that is checked before every block; once it is cancelled,
+     * process() stops within one block and returns false. Stopping the calling
+     * juce::Thread has the same effect. The token is not owned.
+     */
+    void setCancellationToken(const CancellationToken* token) { cancellation = token; }
+
+    /** True if the last process() call was cancelled rather than finished. */
+    bool wasCancelled() const { return cancelled; }
+
+    /** True if the last process() call stopped because the file failed to decode part way. */
+    bool hadDecodeError() const { return decodeFailed; }
+
+    /** True if the last successful process() call decoded every sample of the file. */
+    bool decodedWholeFile() const { return wholeFileDecoded; }
+
+    /**
+     * Decode the file once and stream it through all consumers.
+     * @param audioFile The file to analyse
+     * @return False if the file could not be opened or decoded, or the run was
+     *         cancelled; no consumer is finished then. Individual consumer failures are reported by the consumers themselves
+     */
+    bool process(const juce::File& audioFile);
+
+    /** Where the last process() call spent its time. */
+    struct Timings
+    {
+        double openMs = 0.0;    // Creating the reader
+        double decodeMs = 0.0;  // Reading and decoding blocks, without the consumers
+    };
+
+    const Timings& getLastTimings() const { return timings; }
+
+    /**
+     * Time the last process() call spent inside a consumer, from prepare() to
+     * finish(); 0 for a consumer that is not registered.
+     */
+    double getConsumerMs(const AnalysisConsumer* consumer) const;
+
+    /**
+     * Number of samples per block handed to consumers.
+     */
+    static constexpr int blockSize = 8192;
+
+    /**
+     * Get the last error message.
+     */
+    juce::String getLastError() const { return lastError; }
+
+private:
+    //==============================================================================
+    bool decodeWindow(juce::AudioFormatReader& reader, const AnalysisPolicy::Window& window,
+                      const std::vector<size_t>& active, const juce::File& audioFile,
+                      juce::int64& samplesDecoded);
+
+    juce::AudioFormatManager formatManager;
+    AnalysisPolicy policy;
+    std::vector<AnalysisConsumer*> consumers;
+    std::vector<double> consumerMs;  // Parallel to consumers
+    Timings timings;
+    juce::AudioBuffer<float> blockBuffer;
+    std::function<void(juce::int64)> readThrottle;
+    const CancellationToken* cancellation = nullptr;
+    bool cancelled = false;
+    bool decodeFailed = false;
+    bool wholeFileDecoded = false;
+    double bytesPerSample = 0.0;  // File size over length, for the read throttle
+    juce::String lastError;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalysisPipeline)
+};
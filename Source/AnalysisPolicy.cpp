@@ -0,0 +1,151 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+#include "AnalysisPolicy.h"
+#include "AcoustIDFingerprinter.h"
+#include <algorithm>
+
+namespace
+{
+    // Clip to the file, sort, and join windows that overlap or touch
+    AnalysisPolicy::Pass normalise(AnalysisPolicy::Pass windows, juce::int64 length)
+    {
+        AnalysisPolicy::Pass result;
+        
+        for (auto& window : windows)
+        {
+            const auto end = juce::jmin(length, window.getEnd());
+            window.start = juce::jmax((juce::int64) 0, window.start);
+            window.length = end - window.start;
+        }
+        
+        std::sort(windows.begin(), windows.end(),
+                  [](const AnalysisPolicy::Window& a, const AnalysisPolicy::Window& b) { return a.start < b.start; });
+        
+        for (const auto& window : windows)
+        {
+            if (window.length <= 0)
+                continue;
+            
+            if (!result.empty() && window.start <= result.back().getEnd())
+                result.back().length = juce::jmax(result.back().getEnd(), window.getEnd()) - result.back().start;
+            else
+                result.push_back(window);
+        }
+        
+        return result;
+    }
+    
+    // The parts of the windows that are not covered yet (both sorted and merged)
+    AnalysisPolicy::Pass subtract(const AnalysisPolicy::Pass& windows, const AnalysisPolicy::Pass& covered)
+    {
+        AnalysisPolicy::Pass result;
+        
+        for (const auto& window : windows)
+        {
+            auto position = window.start;
+            
+            for (const auto& done : covered)
+            {
+                if (done.getEnd() <= position || done.start >= window.getEnd())
+                    continue;
+                
+                if (done.start > position)
+                    result.push_back({ position, done.start - position });
+                
+                position = done.getEnd();
+            }
+            
+            if (position < window.getEnd())
+                result.push_back({ position, window.getEnd() - position });
+        }
+        
+        return result;
+    }
+}
+
+//==============================================================================
+AnalysisPolicy::AnalysisPolicy()
+{
+}
+
+std::vector<AnalysisPolicy::Pass> AnalysisPolicy::createPasses(juce::int64 length, double sampleRate) const
+{
+    if (length <= 0)
+        return {};
+    
+    const Pass wholeFile { { 0, length } };
+    
+    if (!samplingEnabled || sampleRate <= 0.0 || length < (juce::int64) (minSampledSeconds * sampleRate))
+        return { wholeFile };
+    
+    auto samples = [sampleRate](double seconds) { return (juce::int64) (seconds * sampleRate); };
+    
+    auto sectionAt = [&](double fraction)
+    {
+        return Window { (juce::int64) (length * fraction) - samples(sectionSeconds) / 2, samples(sectionSeconds) };
+    };
+    
+    // The intro doubles as the fingerprint, which must start at the beginning of the file
+    std::vector<Pass> candidates (2);
+    candidates[0].push_back({ 0, AcoustIDFingerprinter::getMaxSamplesForFingerprint(juce::roundToInt(sampleRate)) });
+    
+    for (auto fraction : { 0.3, 0.5, 0.7 })
+        candidates[0].push_back(sectionAt(fraction));
+    
+    candidates[0].push_back({ length - samples(outroSeconds), samples(outroSeconds) });
+    
+    for (auto fraction : { 0.2, 0.4, 0.6, 0.8 })
+        candidates[1].push_back(sectionAt(fraction));
+    
+    // Each pass only gets what earlier passes have not decoded; the last one gets the rest
+    std::vector<Pass> passes;
+    Pass covered;
+    
+    for (auto& candidate : candidates)
+    {
+        passes.push_back(subtract(normalise(candidate, length), covered));
+        
+        covered.insert(covered.end(), passes.back().begin(), passes.back().end());
+        covered = normalise(covered, length);
+    }
+    
+    if ((double) getLength(passes.front()) > length * maxSampledFraction)
+        return { wholeFile };
+    
+    passes.push_back(subtract(wholeFile, covered));
+    
+    passes.erase(std::remove_if(passes.begin(), passes.end(), [](const Pass& pass) { return pass.empty(); }),
+                 passes.end());
+    
+    return passes;
+}
+
+juce::int64 AnalysisPolicy::getLength(const Pass& pass)
+{
+    juce::int64 total = 0;
+    
+    for (const auto& window : pass)
+        total += window.length;
+    
+    return total;
+}
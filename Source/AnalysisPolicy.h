@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <vector>
+
+//==============================================================================
+/**
+    Decides which parts of a file the AnalysisPipeline decodes.
+
+    Tracks up to six minutes are decoded whole. Longer ones (extended mixes, DJ
+    edits, recorded sets) are sampled in passes:
+
+    1. The intro (as long as the AcoustID fingerprint needs), core sections at
+       30, 50 and 70%, and the outro
+    2. More core sections, at 20, 40, 60 and 80%
+    3. Everything not decoded yet
+
+    The pipeline only moves on to the next pass while a consumer is not yet
+    confident in its result, so most files stop after the first one. Results
+    that need every sample (the waveform overview, loudness) are measured later
+    by a separate run with sampling disabled.
+*/
+class AnalysisPolicy
+{
+public:
+    //==============================================================================
+    /** A stretch of the file, in samples. */
+    struct Window
+    {
+        juce::int64 start = 0;
+        juce::int64 length = 0;
+        
+        juce::int64 getEnd() const  { return start + length; }
+    };
+    
+    using Pass = std::vector<Window>;
+    
+    //==============================================================================
+    AnalysisPolicy();
+    
+    /** With sampling disabled every file is decoded whole in a single pass. */
+    void setSamplingEnabled(bool shouldSample)  { samplingEnabled = shouldSample; }
+    bool isSamplingEnabled() const              { return samplingEnabled; }
+    
+    /**
+     * The decoding passes for a file. Windows are sorted, never overlap (also not
+     * with earlier passes), and together the passes cover the whole file.
+     */
+    std::vector<Pass> createPasses(juce::int64 lengthInSamples, double sampleRate) const;
+    
+    /** Total number of samples in a pass. */
+    static juce::int64 getLength(const Pass& pass);
+    
+    //==============================================================================
+    static constexpr double minSampledSeconds = 360.0;
+    static constexpr double sectionSeconds = 30.0;
+    static constexpr double outroSeconds = 30.0;
+    
+    // A first pass that would cover more than this share of the file saves too
+    // little, so such files are decoded whole
+    static constexpr double maxSampledFraction = 0.6;
+
+private:
+    //==============================================================================
+    bool samplingEnabled = true;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalysisPolicy)
+};
@@ -0,0 +1,308 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+
+#include "AnalysisResultWriter.h"
+#include "LoudnessAnalyser.h"
+#include <set>
+
+//==============================================================================
+AnalysisResultWriter::AnalysisResultWriter(DatabaseManager& dbManager)
+    : Thread("AnalysisResultWriter"),
+      databaseManager(dbManager)
+{
+}
+
+AnalysisResultWriter::~AnalysisResultWriter()
+{
+    stop();
+}
+
+//==============================================================================
+void AnalysisResultWriter::start()
+{
+    if (!isThreadRunning())
+        startThread();
+}
+
+void AnalysisResultWriter::stop()
+{
+    signalThreadShouldExit();
+    notify();
+    waitForThreadToExit(5000);
+    
+    // Anything submitted after the thread's final flush
+    flush();
+}
+
+void AnalysisResultWriter::submit(Result result)
+{
+    bool wakeWriter = false;
+    
+    {
+        const juce::ScopedLock lock(queueLock);
+        
+        if (queue.empty())
+            oldestQueuedTime = juce::Time::getMillisecondCounter();
+        
+        queue.push_back(std::move(result));
+        
+        // Wake the writer to start the latency clock, or to flush a full batch
+        wakeWriter = queue.size() == 1 || (int) queue.size() >= maxBatchSize;
+    }
+    
+    if (wakeWriter)
+        notify();
+}
+
+void AnalysisResultWriter::setResultCallback(std::function<void(const Result&, bool)> callback)
+{
+    const juce::ScopedLock lock(callbackLock);
+    resultCallback = callback;
+}
+
+//==============================================================================
+void AnalysisResultWriter::setMaxBatchSize(int numResults)
+{
+    maxBatchSize = juce::jmax(1, numResults);
+    notify();
+}
+
+void AnalysisResultWriter::setMaxLatencyMs(int milliseconds)
+{
+    maxLatencyMs = juce::jmax(0, milliseconds);
+    notify();
+}
+
+bool AnalysisResultWriter::setDurability(DatabaseManager::Durability durability)
+{
+    return databaseManager.setDurability(durability);
+}
+
+int AnalysisResultWriter::getQueuedResultCount() const
+{
+    const juce::ScopedLock lock(queueLock);
+    return (int) queue.size();
+}
+
+//==============================================================================
+void AnalysisResultWriter::run()
+{
+    while (!threadShouldExit())
+    {
+        int waitMs = -1;
+        
+        {
+            const juce::ScopedLock lock(queueLock);
+            
+            if (!queue.empty())
+            {
+                const int age = (int) (juce::Time::getMillisecondCounter() - oldestQueuedTime);
+                
+                if ((int) queue.size() >= maxBatchSize || age >= maxLatencyMs)
+                    waitMs = 0;
+                else
+                    waitMs = maxLatencyMs - age;
+            }
+        }
+        
+        if (waitMs == 0)
+            flush();
+        else
+            wait(waitMs);
+    }
+    
+    flush();
+}
+
+bool AnalysisResultWriter::flush()
+{
+    const juce::ScopedLock flushScope(flushLock);
+    
+    std::vector<Result> batch;
+    
+    {
+        const juce::ScopedLock lock(queueLock);
+        batch.swap(queue);
+    }
+    
+    if (batch.empty())
+        return true;
+    
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+    bool committed = databaseManager.beginTransaction();
+    double sharedMs = juce::Time::getMillisecondCounterHiRes() - startTime;
+    
+    if (committed)
+    {
+        for (auto& result : batch)
+        {
+            startTime = juce::Time::getMillisecondCounterHiRes();
+            writeResult(result);
+            result.writeMs = juce::Time::getMillisecondCounterHiRes() - startTime;
+        }
+        
+        startTime = juce::Time::getMillisecondCounterHiRes();
+        updateAlbumGains(batch);
+        sharedMs += juce::Time::getMillisecondCounterHiRes() - startTime;
+        
+        startTime = juce::Time::getMillisecondCounterHiRes();
+        committed = databaseManager.commitTransaction();
+        
+        if (!committed)
+            databaseManager.rollbackTransaction();
+        
+        sharedMs += juce::Time::getMillisecondCounterHiRes() - startTime;
+    }
+    
+    // Every result in the batch waited for the same transaction
+    for (auto& result : batch)
+        result.writeMs += sharedMs / (double) batch.size();
+    
+    if (committed)
+    {
+        DBG("[AnalysisResultWriter] Wrote " << (int) batch.size() << " results in one transaction");
+    }
+    else
+    {
+        DBG("[AnalysisResultWriter] Error: Failed to write " << (int) batch.size()
+            << " results: " << databaseManager.getLastError());
+    }
+    
+    const juce::ScopedLock lock(callbackLock);
+    if (resultCallback)
+    {
+        for (const auto& result : batch)
+            resultCallback(result, committed && result.job.status != "failed");
+    }
+    
+    return committed;
+}
+
+void AnalysisResultWriter::updateAlbumGains(const std::vector<Result>& batch)
+{
+    // An album is its title within one folder, so two "Greatest Hits" never share a gain
+    std::set<std::pair<juce::String, juce::String>> albums;
+    
+    for (const auto& result : batch)
+    {
+        if (result.hasTrack && result.job.status != "failed"
+            && result.track.loudnessLufs < 0.0 && result.track.album.isNotEmpty())
+        {
+            albums.emplace(result.track.album,
+                           juce::File(result.track.filePath).getParentDirectory().getFullPathName());
+        }
+    }
+    
+    for (const auto& album : albums)
+    {
+        double albumGain = 0.0;
+        
+        if (LoudnessAnalyser::getAlbumGain(databaseManager.getTracksByAlbum(album.first, album.second), albumGain))
+            databaseManager.setAlbumGain(album.first, album.second, albumGain);
+    }
+}
+
+void AnalysisResultWriter::writeResult(Result& result)
+{
+    if (result.hasTrack)
+    {
+        auto existing = databaseManager.getTrackByPath(result.track.filePath);
+        int64_t trackId = existing.id;
+        bool trackSaved = false;
+        
+        if (trackId != 0)
+        {
+            result.track.id = trackId;
+            trackSaved = databaseManager.updateTrack(result.track);
+        }
+        else
+        {
+            trackSaved = databaseManager.addTrack(result.track, trackId);
+            result.track.id = trackId;
+        }
+        
+        if (!trackSaved)
+        {
+            DBG("[AnalysisResultWriter] Error: Failed to save track: " << result.track.filePath);
+            result.job.status = "failed";
+            result.job.errorMessage = "Failed to save to database";
+        }
+        else
+        {
+            if (result.hasWaveform)
+            {
+                result.waveform.trackId = trackId;
+                
+                if (!databaseManager.saveWaveformOverview(result.waveform))
+                {
+                    DBG("[AnalysisResultWriter] Warning: Failed to save waveform overview");
+                }
+            }
+            
+            if (result.hasBeatGrid)
+            {
+                result.beatGrid.trackId = trackId;
+                
+                if (!databaseManager.saveBeatGrid(result.beatGrid))
+                {
+                    DBG("[AnalysisResultWriter] Warning: Failed to save beat grid");
+                }
+            }
+            
+            if (result.hasAudioFingerprint)
+            {
+                result.audioFingerprint.trackId = trackId;
+                
+                if (!databaseManager.saveAudioFingerprint(result.audioFingerprint))
+                {
+                    DBG("[AnalysisResultWriter] Warning: Failed to save audio fingerprint");
+                }
+                
+                if (!databaseManager.saveDuplicateMatches(trackId, result.duplicateMatches))
+                {
+                    DBG("[AnalysisResultWriter] Warning: Failed to save duplicate matches");
+                }
+            }
+        }
+    }
+    
+    if (result.hasCacheEntry && !databaseManager.saveAnalysisCacheEntry(result.cacheEntry))
+    {
+        DBG("[AnalysisResultWriter] Warning: Failed to save analysis cache entry");
+    }
+    
+    if (!databaseManager.updateJob(result.job))
+    {
+        DBG("[AnalysisResultWriter] Error: Failed to update job " << result.job.id);
+    }
+    
+    // Follow-up work, such as the full decode of a sampled file
+    int64_t followUpId = 0;
+    
+    if (result.hasFollowUpJob && result.job.status != "failed"
+        && !databaseManager.enqueueJob(result.followUpJob, followUpId))
+    {
+        DBG("[AnalysisResultWriter] Warning: Failed to queue " << result.followUpJob.jobType
+            << " job for: " << result.followUpJob.filePath);
+    }
+}
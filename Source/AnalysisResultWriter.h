@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "DatabaseManager.h"
+#include <atomic>
+#include <functional>
+#include <vector>
+
+//==============================================================================
+/**
+    AnalysisResultWriter collects finished analysis results from all worker
+    threads and writes them on its own thread, many per transaction.
+
+    A batch is flushed once it holds maxBatchSize results or its oldest result
+    has waited maxLatencyMs, whichever comes first. Each result costs one
+    transaction share instead of several autocommit writes (each an fsync on
+    rotating disks), and workers never wait on the database to finish a job.
+*/
+class AnalysisResultWriter : private juce::Thread
+{
+public:
+    //==============================================================================
+    /** Everything the database needs to know about one finished job. */
+    struct Result
+    {
+        DatabaseManager::Job job;           // Final status, error message and progress
+        bool hasTrack = false;
+        DatabaseManager::Track track;       // Inserted or updated by file path
+        bool hasWaveform = false;
+        DatabaseManager::WaveformOverview waveform;  // trackId is filled in on write
+        bool hasBeatGrid = false;
+        DatabaseManager::BeatGrid beatGrid;          // trackId is filled in on write; empty removes the old grid
+        bool hasAudioFingerprint = false;
+        DatabaseManager::AudioFingerprint audioFingerprint;  // trackId is filled in on write
+        std::vector<DatabaseManager::DuplicateMatch> duplicateMatches;  // Saved with the fingerprint, replacing older ones
+        bool hasCacheEntry = false;
+        DatabaseManager::AnalysisCacheEntry cacheEntry;  // Shared with later copies of the same audio
+        bool hasFollowUpJob = false;
+        DatabaseManager::Job followUpJob;   // Queued once the job itself is stored, in the same commit
+        double writeMs = 0.0;               // Set on write: this result's statements plus its share of the commit
+    };
+    
+    //==============================================================================
+    explicit AnalysisResultWriter(DatabaseManager& dbManager);
+    
+    /** Flushes anything still queued. */
+    ~AnalysisResultWriter() override;
+    
+    /**
+     * Start the writer thread.
+     */
+    void start();
+    
+    /**
+     * Stop the writer thread after flushing all queued results.
+     */
+    void stop();
+    
+    /**
+     * Queue a result for writing. Safe to call from any thread.
+     */
+    void submit(Result result);
+    
+    /**
+     * Write all queued results now, on the calling thread.
+     * @return False if the batch could not be committed
+     */
+    bool flush();
+    
+    /**
+     * Set a callback for each result once its batch has been committed (or
+     * failed to commit). Called on the writer thread.
+     */
+    void setResultCallback(std::function<void(const Result&, bool saved)> callback);
+    
+    //==============================================================================
+    // Knobs
+    
+    /** Flush as soon as this many results are queued (default 64). */
+    void setMaxBatchSize(int numResults);
+    
+    /** Flush once the oldest queued result has waited this long (default 250 ms). */
+    void setMaxLatencyMs(int milliseconds);
+    
+    /** Forwarded to DatabaseManager::setDurability(). */
+    bool setDurability(DatabaseManager::Durability durability);
+    
+    int getMaxBatchSize() const     { return maxBatchSize; }
+    int getMaxLatencyMs() const     { return maxLatencyMs; }
+    
+    /** Results submitted but not yet written. */
+    int getQueuedResultCount() const;
+
+private:
+    //==============================================================================
+    void run() override;
+    
+    // Write one result inside the open transaction; marks the job failed if the track cannot be saved
+    void writeResult(Result& result);
+    
+    // Recompute the gain of every album the batch measured, once each, before the commit
+    void updateAlbumGains(const std::vector<Result>& batch);
+    
+    DatabaseManager& databaseManager;
+    std::vector<Result> queue;
+    juce::uint32 oldestQueuedTime = 0;  // Millisecond counter when the queue became non-empty
+    std::function<void(const Result&, bool)> resultCallback;
+    std::atomic<int> maxBatchSize{64};
+    std::atomic<int> maxLatencyMs{250};
+    mutable juce::CriticalSection queueLock;
+    juce::CriticalSection flushLock;       // One batch at a time
+    juce::CriticalSection callbackLock;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalysisResultWriter)
+};
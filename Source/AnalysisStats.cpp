@@ -0,0 +1,191 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+#include "AnalysisStats.h"
+
+//==============================================================================
+AnalysisStats::AnalysisStats()
+{
+    reset();
+}
+
+juce::String AnalysisStats::getStageName(Stage stage)
+{
+    switch (stage)
+    {
+        case stageHash:         return "Hash";
+        case stageTags:         return "Tags";
+        case stageOpen:         return "Open";
+        case stageDecode:       return "Decode";
+        case stageAnalyse:      return "Analyse";
+        case stageFingerprint:  return "Fingerprint";
+        case stageDatabase:     return "DB write";
+        case numStages:         break;
+    }
+    
+    return {};
+}
+
+//==============================================================================
+void AnalysisStats::record(Stage stage, double milliseconds)
+{
+    if (!juce::isPositiveAndBelow((int) stage, (int) numStages))
+        return;
+    
+    auto& histogram = histograms[(size_t) stage];
+    const auto microseconds = (juce::int64) (juce::jmax(0.0, milliseconds) * 1000.0);
+    
+    ++histogram.buckets[(size_t) getBucket(milliseconds)];
+    histogram.totalMicroseconds += microseconds;
+    
+    auto previousMax = histogram.maxMicroseconds.load();
+    while (microseconds > previousMax && !histogram.maxMicroseconds.compare_exchange_weak(previousMax, microseconds))
+    {
+    }
+}
+
+void AnalysisStats::recordFile(juce::int64 numBytes)
+{
+    const juce::ScopedLock lock(rateLock);
+    const auto now = juce::Time::getMillisecondCounter();
+    
+    if (filesProcessed == 0)
+        firstFileTime = now;
+    
+    ++filesProcessed;
+    bytesProcessed += numBytes;
+    recentFiles.emplace_back(now, numBytes);
+    
+    while (!recentFiles.empty() && now - recentFiles.front().first > (juce::uint32) rateWindowMs)
+        recentFiles.pop_front();
+}
+
+AnalysisStats::Snapshot AnalysisStats::getSnapshot() const
+{
+    Snapshot snapshot;
+    
+    for (int stage = 0; stage < numStages; ++stage)
+        snapshot.stages[(size_t) stage] = summarise(histograms[(size_t) stage]);
+    
+    const juce::ScopedLock lock(rateLock);
+    const auto now = juce::Time::getMillisecondCounter();
+    
+    snapshot.filesProcessed = filesProcessed;
+    snapshot.bytesProcessed = bytesProcessed;
+    
+    // Rates over the window, or over the time since the first file while that is shorter
+    juce::int64 recentCount = 0, recentBytes = 0;
+    
+    for (const auto& file : recentFiles)
+    {
+        if (now - file.first <= (juce::uint32) rateWindowMs)
+        {
+            ++recentCount;
+            recentBytes += file.second;
+        }
+    }
+    
+    if (filesProcessed > 0)
+    {
+        const double seconds = juce::jlimit(1.0, rateWindowMs / 1000.0, (now - firstFileTime) / 1000.0);
+        snapshot.filesPerSecond = (double) recentCount / seconds;
+        snapshot.megabytesPerSecond = (double) recentBytes / (1024.0 * 1024.0) / seconds;
+    }
+    
+    return snapshot;
+}
+
+void AnalysisStats::reset()
+{
+    for (auto& histogram : histograms)
+    {
+        for (auto& bucket : histogram.buckets)
+            bucket = 0;
+        
+        histogram.totalMicroseconds = 0;
+        histogram.maxMicroseconds = 0;
+    }
+    
+    const juce::ScopedLock lock(rateLock);
+    recentFiles.clear();
+    firstFileTime = 0;
+    filesProcessed = 0;
+    bytesProcessed = 0;
+}
+
+//==============================================================================
+int AnalysisStats::getBucket(double milliseconds)
+{
+    // Bucket 0 holds everything below firstBucketMs, bucket n [firstBucketMs * 2^(n-1), firstBucketMs * 2^n)
+    if (milliseconds < firstBucketMs)
+        return 0;
+    
+    return juce::jmin(numBuckets - 1, 1 + (int) std::floor(std::log2(milliseconds / firstBucketMs)));
+}
+
+AnalysisStats::StageSummary AnalysisStats::summarise(const Histogram& histogram)
+{
+    StageSummary summary;
+    
+    std::array<juce::int64, numBuckets> counts;
+    juce::int64 total = 0;
+    
+    for (size_t i = 0; i < counts.size(); ++i)
+    {
+        counts[i] = histogram.buckets[i].load();
+        total += counts[i];
+    }
+    
+    if (total == 0)
+        return summary;
+    
+    summary.count = total;
+    summary.meanMs = (double) histogram.totalMicroseconds.load() / 1000.0 / (double) total;
+    summary.maxMs = (double) histogram.maxMicroseconds.load() / 1000.0;
+    
+    // Interpolate geometrically inside the bucket holding the requested rank
+    auto percentile = [&](double fraction)
+    {
+        const double rank = fraction * (double) total;
+        juce::int64 below = 0;
+        
+        for (int i = 0; i < numBuckets; ++i)
+        {
+            if ((double) (below + counts[(size_t) i]) >= rank)
+            {
+                const double lower = i == 0 ? 0.0 : firstBucketMs * std::exp2(i - 1);
+                const double upper = firstBucketMs * std::exp2(i);
+                const double position = ((rank - (double) below) / (double) counts[(size_t) i]);
+                const double value = i == 0 ? upper * position : lower * std::pow(upper / lower, position);
+                return juce::jmin(value, summary.maxMs);
+            }
+            
+            below += counts[(size_t) i];
+        }
+        
+        return summary.maxMs;
+    };
+    
+    summary.p50Ms = percentile(0.5);
+    summary.p95Ms = percentile(0.95);
+    return summary;
+}
@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <deque>
+
+//==============================================================================
+/**
+    Timing statistics for the analysis workers: a latency histogram for each
+    stage of a job, plus files/s and MB/s over the last rateWindowMs.
+
+    Stage times are recorded by the worker threads and the result writer
+    without taking a lock. Histogram buckets double in width from 0.25 ms, so
+    percentiles are estimates within a factor of two of the true value.
+*/
+class AnalysisStats
+{
+public:
+    //==============================================================================
+    enum Stage
+    {
+        stageHash,          // Content hashes (reads the whole file)
+        stageTags,          // Tag parsing and the decoder's metadata
+        stageOpen,          // Creating the audio reader
+        stageDecode,        // Reading and decoding audio blocks
+        stageAnalyse,       // Waveform, tempo, key, loudness and beat grid
+        stageFingerprint,   // Chromaprint
+        stageDatabase,      // Writing the result, with its share of the batch commit
+        numStages
+    };
+    
+    static juce::String getStageName(Stage stage);
+    
+    /** Latency summary of one stage. */
+    struct StageSummary
+    {
+        juce::int64 count = 0;
+        double meanMs = 0.0;
+        double p50Ms = 0.0;
+        double p95Ms = 0.0;
+        double maxMs = 0.0;
+    };
+    
+    /** Everything the stats panel shows, read in one go. */
+    struct Snapshot
+    {
+        std::array<StageSummary, numStages> stages;
+        juce::int64 filesProcessed = 0;
+        juce::int64 bytesProcessed = 0;
+        double filesPerSecond = 0.0;
+        double megabytesPerSecond = 0.0;
+    };
+    
+    //==============================================================================
+    AnalysisStats();
+    
+    /** Record how long one job spent in a stage. Safe to call from any thread. */
+    void record(Stage stage, double milliseconds);
+    
+    /** Record a finished file of the given size, for the throughput rates. */
+    void recordFile(juce::int64 numBytes);
+    
+    Snapshot getSnapshot() const;
+    
+    /** Forget everything recorded so far. */
+    void reset();
+    
+    //==============================================================================
+    static constexpr int numBuckets = 24;           // Up to 0.25 ms * 2^22, about 17 minutes
+    static constexpr double firstBucketMs = 0.25;
+    static constexpr int rateWindowMs = 30000;
+
+private:
+    //==============================================================================
+    struct Histogram
+    {
+        std::array<std::atomic<juce::int64>, numBuckets> buckets {};
+        std::atomic<juce::int64> totalMicroseconds{0};
+        std::atomic<juce::int64> maxMicroseconds{0};
+    };
+    
+    static int getBucket(double milliseconds);
+    static StageSummary summarise(const Histogram& histogram);
+    
+    std::array<Histogram, numStages> histograms;
+    
+    // Finished files (time, bytes) within the rate window
+    mutable juce::CriticalSection rateLock;
+    std::deque<std::pair<juce::uint32, juce::int64>> recentFiles;
+    juce::uint32 firstFileTime = 0;
+    juce::int64 filesProcessed = 0;
+    juce::int64 bytesProcessed = 0;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalysisStats)
+};
@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+#include "AnalysisStatsComponent.h"
+
+//==============================================================================
+AnalysisStatsComponent::AnalysisStatsComponent()
+{
+    setOpaque(false);
+}
+
+AnalysisStatsComponent::~AnalysisStatsComponent()
+{
+}
+
+void AnalysisStatsComponent::setSnapshot(const AnalysisStats::Snapshot& newSnapshot)
+{
+    snapshot = newSnapshot;
+    repaint();
+}
+
+int AnalysisStatsComponent::getPreferredHeight()
+{
+    // Throughput line, column headers, one row per stage
+    return 2 * margin + (2 + AnalysisStats::numStages) * rowHeight;
+}
+
+//==============================================================================
+void AnalysisStatsComponent::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+    
+    g.setColour(juce::Colour(0xff252525));
+    g.fillRoundedRectangle(bounds, 6.0f);
+    g.setColour(juce::Colours::grey);
+    g.drawRoundedRectangle(bounds.reduced(0.5f), 6.0f, 1.0f);
+    
+    auto area = getLocalBounds().reduced(margin);
+    g.setFont(juce::FontOptions(12.0f));
+    
+    // Throughput over the last rate window
+    g.setColour(juce::Colours::white);
+    g.drawText(juce::String(snapshot.filesPerSecond, 2) + " files/s, "
+                   + juce::String(snapshot.megabytesPerSecond, 1) + " MB/s  ("
+                   + juce::String(snapshot.filesProcessed) + " files, "
+                   + juce::File::descriptionOfSizeInBytes(snapshot.bytesProcessed) + " analysed)",
+               area.removeFromTop(rowHeight), juce::Justification::centredLeft);
+    
+    // One column for the stage name, the rest share the width
+    auto drawRow = [&g, &area](const juce::StringArray& cells, juce::Colour colour)
+    {
+        auto row = area.removeFromTop(rowHeight);
+        const int nameWidth = juce::jmin(120, row.getWidth() / 3);
+        const int cellWidth = (row.getWidth() - nameWidth) / juce::jmax(1, cells.size() - 1);
+        
+        g.setColour(colour);
+        
+        for (int i = 0; i < cells.size(); ++i)
+        {
+            auto cell = row.removeFromLeft(i == 0 ? nameWidth : cellWidth);
+            g.drawText(cells[i], cell, i == 0 ? juce::Justification::centredLeft : juce::Justification::centredRight);
+        }
+    };
+    
+    drawRow({ "Stage", "Jobs", "Mean", "Median", "95%", "Max" }, juce::Colours::lightgrey);
+    
+    for (int stage = 0; stage < AnalysisStats::numStages; ++stage)
+    {
+        const auto& summary = snapshot.stages[(size_t) stage];
+        
+        drawRow({ AnalysisStats::getStageName((AnalysisStats::Stage) stage),
+                  juce::String(summary.count),
+                  formatMs(summary.meanMs),
+                  formatMs(summary.p50Ms),
+                  formatMs(summary.p95Ms),
+                  formatMs(summary.maxMs) },
+                juce::Colours::white);
+    }
+}
+
+juce::String AnalysisStatsComponent::formatMs(double milliseconds)
+{
+    if (milliseconds >= 1000.0)
+        return juce::String(milliseconds / 1000.0, 2) + " s";
+    
+    return juce::String(milliseconds, milliseconds < 10.0 ? 2 : 1) + " ms";
+}
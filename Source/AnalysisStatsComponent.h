@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "AnalysisStats.h"
+
+//==============================================================================
+/**
+    AnalysisStatsComponent shows the analysis throughput and a latency row
+    (count, mean, median, 95th percentile, max) for every job stage, so it is
+    clear which stage limits the import.
+*/
+class AnalysisStatsComponent : public juce::Component
+{
+public:
+    AnalysisStatsComponent();
+    ~AnalysisStatsComponent() override;
+    
+    /** Show a new snapshot (call from the message thread). */
+    void setSnapshot(const AnalysisStats::Snapshot& newSnapshot);
+    
+    /** Height that fits the throughput line and every stage row. */
+    static int getPreferredHeight();
+    
+    void paint(juce::Graphics& g) override;
+    
+private:
+    static juce::String formatMs(double milliseconds);
+    
+    AnalysisStats::Snapshot snapshot;
+    
+    static constexpr int rowHeight = 18;
+    static constexpr int margin = 8;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalysisStatsComponent)
+};
@@ -21,78 +21,387 @@
 */
 
 #include "AnalysisWorker.h"
-#include "AcoustIDFingerprinter.h"
-#include <juce_audio_formats/juce_audio_formats.h>
+#include "AnalysisConsumers.h"
+#include "BeatGridAnalyser.h"
+#include "FileHasher.h"
+#include "KeyAnalyser.h"
+#include "LoudnessAnalyser.h"
+#include "SpectralFingerprinter.h"
+#include "TagReader.h"
+#include "TempoAnalyser.h"
+
+namespace
+{
+    // A tagged tempo wins; the detected one only adds precision when the two agree
+    void resolveTempo(double taggedBpm, double detectedBpm, double detectedConfidence, DatabaseManager::Track& track)
+    {
+        if (detectedBpm > 0.0)
+        {
+            if (taggedBpm <= 0.0)
+            {
+                track.bpmPrecise = detectedBpm;
+                track.bpmConfidence = detectedConfidence;
+                track.bpm = juce::roundToInt(detectedBpm);
+            }
+            else
+            {
+                const bool agrees = std::abs(detectedBpm - taggedBpm) < 0.5;
+                track.bpmPrecise = agrees ? detectedBpm : taggedBpm;
+                track.bpmConfidence = 1.0;
+            }
+        }
+        else if (taggedBpm > 0.0)
+        {
+            track.bpmPrecise = taggedBpm;
+            track.bpmConfidence = 1.0;
+        }
+    }
+    
+    // Fill in a track from the analysis of an earlier copy of the same audio.
+    // Fails, leaving the track alone, when this copy's tags ask for something
+    // the earlier analysis did not cover.
+    bool applyCachedAnalysis(const DatabaseManager::AnalysisCacheEntry& cached, const TagReader::Tags& tags,
+                             DatabaseManager::Track& track, AnalysisResultWriter::Result& result)
+    {
+        auto candidate = track;
+        candidate.duration = cached.duration;
+        resolveTempo(tags.bpm, cached.bpm, cached.bpmConfidence, candidate);
+        
+        // The key analyser only ran if the earlier copy had no tagged key, and the grid
+        // follows the earlier copy's final tempo, which may have come from its tags
+        if ((candidate.key.isEmpty() && cached.key.isEmpty()) || std::abs(candidate.bpmPrecise - cached.gridBpm) > 1.0e-6)
+            return false;
+        
+        #ifdef HAVE_CHROMAPRINT
+        if (cached.fingerprint.isEmpty())
+            return false;
+        #endif
+        
+        if (candidate.key.isEmpty())
+            candidate.key = cached.key;
+        
+        if (cached.loudnessLufs < 0.0)
+        {
+            candidate.loudnessLufs = cached.loudnessLufs;
+            candidate.loudnessRange = cached.loudnessRange;
+            candidate.truePeakDb = cached.truePeakDb;
+        }
+        
+        candidate.acoustidFingerprint = cached.fingerprint;
+        track = candidate;
+        
+        result.hasWaveform = cached.waveform.getNumBins() > 0;
+        result.waveform = cached.waveform;
+        result.hasBeatGrid = true;
+        result.beatGrid.markers = cached.beatGrid;
+        result.hasAudioFingerprint = !cached.audioFingerprint.empty();
+        result.audioFingerprint.duration = cached.duration;
+        result.audioFingerprint.bits = cached.audioFingerprint;
+        return true;
+    }
+}
 
 //==============================================================================
-AnalysisWorker::AnalysisWorker(DatabaseManager& dbManager)
-    : Thread("AnalysisWorker"),
-      databaseManager(dbManager)
+/**
+    One thread of the pool; all the work happens in AnalysisWorker::runWorker().
+    The decoder set-up (format manager, block buffer) and the analysers (with
+    their Chromaprint context) live here, built once and reused for every file
+    the thread analyses. The running job's id and priority are kept here (under
+    the owner's jobInfoLock) so it can be picked for preemption.
+*/
+class AnalysisWorker::WorkerThread : public juce::Thread
 {
+public:
+    WorkerThread(AnalysisWorker& ownerToUse, int indexToUse)
+        : Thread("AnalysisWorker " + juce::String(indexToUse)),
+          owner(ownerToUse),
+          index(indexToUse)
+    {
+        pipeline.setReadThrottle([this](juce::int64 numBytes) { owner.governor.waitForTurn(index, numBytes, &cancellation); });
+        pipeline.setCancellationToken(&cancellation);
+        
+        // Follow-up runs over sampled files: every sample, for the waveform and loudness only
+        measurePipeline.setReadThrottle([this](juce::int64 numBytes) { owner.governor.waitForTurn(index, numBytes, &cancellation); });
+        measurePipeline.setCancellationToken(&cancellation);
+        measurePipeline.getPolicy().setSamplingEnabled(false);
+        measurePipeline.addConsumer(&waveformConsumer);
+        measurePipeline.addConsumer(&loudnessAnalyser);
+    }
+    
+    void run() override
+    {
+        owner.runWorker(*this);
+    }
+    
+    AnalysisWorker& owner;
+    const int index;
+    
+    CancellationToken cancellation;
+    int64_t jobId = 0;
+    int jobPriority = -1;   // -1 while idle
+    int preemptedFor = -1;  // Priority of the job that preempted the last one
+    
+    AnalysisPipeline pipeline;
+    AnalysisPipeline measurePipeline;
+    WaveformOverviewConsumer waveformConsumer;
+    TempoAnalyser tempoAnalyser;
+    KeyAnalyser keyAnalyser;
+    LoudnessAnalyser loudnessAnalyser;
+    SpectralFingerprinter spectralFingerprinter;
+    TagReader tagReader;
+    
+    #ifdef HAVE_CHROMAPRINT
+    FingerprintConsumer fingerprintConsumer;
+    #endif
+};
+
+//==============================================================================
+/**
+    Recovers expired leases once at start, then, while any job runs, renews the
+    pool's leases and recovers expired ones every heartbeatIntervalMs, so a job
+    only loses its lease when the whole process stops. An idle pool holds no
+    leases, so the thread sleeps until the next claim wakes it.
+*/
+class AnalysisWorker::HeartbeatThread : public juce::Thread
+{
+public:
+    explicit HeartbeatThread(AnalysisWorker& ownerToUse)
+        : Thread("AnalysisWorker heartbeat"),
+          owner(ownerToUse)
+    {
+    }
+    
+    void run() override
+    {
+        owner.renewLeases();
+        
+        while (!threadShouldExit())
+        {
+            wait(owner.activeJobCount > 0 ? heartbeatIntervalMs : -1);
+            
+            if (!threadShouldExit() && owner.activeJobCount > 0)
+                owner.renewLeases();
+        }
+    }
+    
+    AnalysisWorker& owner;
+};
+
+//==============================================================================
+AnalysisWorker::AnalysisWorker(DatabaseManager& dbManager, int numThreads)
+    : databaseManager(dbManager),
+      resultWriter(dbManager),
+      governor(numThreads > 0 ? numThreads : getDefaultThreadCount()),
+      leaseOwner(juce::SystemStats::getComputerName() + "/" + juce::Uuid().toDashedString())
+{
+    if (numThreads <= 0)
+        numThreads = getDefaultThreadCount();
+    
+    for (int i = 0; i < numThreads; ++i)
+        threads.add(new WorkerThread(*this, i));
+    
+    workerJobInfo.resize((size_t) numThreads);
+    heartbeat = std::make_unique<HeartbeatThread>(*this);
+    
+    databaseManager.setJobAvailableCallback([this](int highestPriority) { notifyJobAvailable(highestPriority); });
+    
+    resultWriter.setResultCallback([this](const AnalysisResultWriter::Result& result, bool saved)
+    {
+        resultWritten(result, saved);
+    });
 }
 
 AnalysisWorker::~AnalysisWorker()
 {
+    databaseManager.setJobAvailableCallback(nullptr);
     stopWorker();
 }
 
+int AnalysisWorker::getDefaultThreadCount()
+{
+    return juce::jmax(1, juce::SystemStats::getNumCpus() - 1);
+}
+
+void AnalysisWorker::notifyJobAvailable(int highestPriority)
+{
+    pendingCountStale = true;
+    
+    // Threads that are busy keep the signal and skip their next sleep
+    for (auto* thread : threads)
+        thread->notify();
+    
+    if (highestPriority > DatabaseManager::jobPriorityBackground)
+        preemptFor(highestPriority);
+}
+
+void AnalysisWorker::preemptFor(int priority)
+{
+    const juce::ScopedLock lock(jobInfoLock);
+    
+    // A thread the governor lets work will pick the job up as soon as it is idle.
+    // Paused threads neither count as busy nor make a useful victim, since the
+    // job they would give up still could not run on them
+    const auto budget = governor.getBudget();
+    int busyThreads = 0;
+    WorkerThread* victim = nullptr;
+    
+    for (auto* thread : threads)
+    {
+        if (thread->jobPriority < 0 || !budget.admits(thread->index))
+            continue;
+        
+        ++busyThreads;
+        
+        if (thread->jobPriority < priority && preemptedJobIds.count(thread->jobId) == 0
+            && (victim == nullptr || thread->jobPriority < victim->jobPriority))
+            victim = thread;
+    }
+    
+    if (busyThreads < budget.maxActiveWorkers || victim == nullptr)
+        return;
+    
+    DBG("[AnalysisWorker] Preempting job " << victim->jobId << " on worker " << victim->index
+        << " for a job of priority " << priority);
+    
+    preemptedJobIds.insert(victim->jobId);
+    victim->preemptedFor = priority;
+    victim->cancellation.cancel(CancellationToken::Reason::preempted);
+    victim->notify();
+}
+
+int AnalysisWorker::getNumThreads() const
+{
+    return threads.size();
+}
+
 //==============================================================================
 void AnalysisWorker::startWorker()
 {
-    if (isThreadRunning())
-        return;
+    DBG("[AnalysisWorker] Starting " << threads.size() << " worker threads");
+    
+    resultWriter.start();
+    
+    // The heartbeat starts by recovering jobs a previous run left behind
+    if (!heartbeat->isThreadRunning())
+        heartbeat->startThread();
     
-    DBG("[AnalysisWorker] Starting worker thread");
-    startThread(); // Start with default priority
+    for (auto* thread : threads)
+    {
+        if (!thread->isThreadRunning())
+            thread->startThread(); // Start with default priority
+    }
 }
 
 void AnalysisWorker::stopWorker()
 {
-    if (!isThreadRunning())
-        return;
+    DBG("[AnalysisWorker] Stopping worker threads");
+    
+    // Signal everyone first so the threads wind down in parallel; running jobs
+    // stop within one block and go back to the queue
+    for (auto* thread : threads)
+    {
+        thread->signalThreadShouldExit();
+        thread->cancellation.cancel(CancellationToken::Reason::shutdown);
+        thread->notify();
+    }
+    
+    for (auto* thread : threads)
+        thread->waitForThreadToExit(5000);
     
-    DBG("[AnalysisWorker] Stopping worker thread");
-    signalThreadShouldExit();
-    notify();
-    waitForThreadToExit(5000);
+    // Leases are kept up until the last job is handed over
+    heartbeat->signalThreadShouldExit();
+    heartbeat->notify();
+    heartbeat->waitForThreadToExit(5000);
+    
+    // Commit whatever the threads finished before they stopped
+    resultWriter.stop();
 }
 
 //==============================================================================
-void AnalysisWorker::run()
+void AnalysisWorker::runWorker(WorkerThread& thread)
 {
-    DBG("[AnalysisWorker] Worker thread started");
+    DBG("[AnalysisWorker] Worker thread " << thread.index << " started");
     
-    while (!threadShouldExit())
+    while (!thread.threadShouldExit())
     {
-        // Get pending jobs
-        auto pendingJobs = databaseManager.getJobsByStatus("pending");
+        // Sit out while the governor wants fewer workers, e.g. during a preview
+        governor.waitForTurn(thread.index, 0);
+        
+        if (thread.threadShouldExit())
+            break;
+        
+        // A thread that gave up its job for a more urgent one takes that one first
+        int urgentPriority = -1;
+        {
+            const juce::ScopedLock lock(jobInfoLock);
+            std::swap(urgentPriority, thread.preemptedFor);
+        }
         
-        if (pendingJobs.empty())
+        // Atomically take the next pending job and mark it running under our lease
+        DatabaseManager::Job job;
+        
+        const bool claimed = (urgentPriority > DatabaseManager::jobPriorityBackground
+                                 && databaseManager.claimNextJob(job, leaseOwner, DatabaseManager::defaultLeaseSeconds,
+                                                                 urgentPriority))
+                          || databaseManager.claimNextJob(job, leaseOwner);
+        
+        if (!claimed)
         {
-            // No jobs to process, wait for notification or timeout
-            wait(1000); // Check every second
+            // Queue is empty: sleep until notifyJobAvailable() or stopWorker()
+            thread.wait(-1);
             continue;
         }
         
-        // Process the first pending job
-        auto job = pendingJobs[0];
+        pendingCountStale = true;
+        
+        {
+            const juce::ScopedLock lock(jobInfoLock);
+            thread.jobId = job.id;
+            thread.jobPriority = job.priority;
+            thread.cancellation.reset();
+        }
         
-        DBG("[AnalysisWorker] Processing job " << job.id << " (" << job.jobType << ")");
+        DBG("[AnalysisWorker] Worker " << thread.index << " processing job " << job.id << " (" << job.jobType << ")");
         
-        // Update job status to running
-        job.status = "running";
-        job.dateStarted = juce::Time::getCurrentTime();
-        job.progress = 0;
-        databaseManager.updateJob(job);
+        ProgressInfo info;
+        info.workerIndex = thread.index;
+        
+        // The heartbeat sleeps while the pool is idle; our lease needs it again
+        if (++activeJobCount == 1)
+            heartbeat->notify();
         
         // Process the job
-        bool success = processJob(job);
+        AnalysisResultWriter::Result result;
+        bool success = processJob(thread, job, info, result);
+        
+        // Shutdown and preemption say nothing about the file, so the job goes back
+        // to the queue as if it had never been claimed
+        if (!success && CancellationToken::shouldStop(&thread.cancellation))
+        {
+            DBG("[AnalysisWorker] Job " << job.id << " interrupted, returning it to the queue");
+            
+            databaseManager.releaseJob(job.id);
+            pendingCountStale = true;
+            --activeJobCount;
+            
+            info.status = "pending";
+            notifyProgress(info);
+            
+            const juce::ScopedLock lock(jobInfoLock);
+            workerJobInfo[(size_t) thread.index] = ProgressInfo();
+            thread.jobPriority = -1;
+            continue;
+        }
         
-        // Update job status to completed or failed
+        // Record the job as completed or failed; the writer commits it with the results
         job.status = success ? "completed" : "failed";
         job.dateCompleted = juce::Time::getCurrentTime();
-        job.progress = success ? 100 : job.progress;
-        databaseManager.updateJob(job);
+        job.progress = success ? 100 : info.progress;
+        
+        result.job = job;
+        resultWriter.submit(std::move(result));
+        
+        --activeJobCount;
         
         if (success)
         {
@@ -101,27 +410,50 @@ void AnalysisWorker::run()
         else
         {
             DBG("[AnalysisWorker] Job " << job.id << " failed: " << job.errorMessage);
+            
+            info.status = "failed";
+            info.errorMessage = job.errorMessage;
+            notifyProgress(info);
         }
         
-        isCurrentlyProcessing = false;
+        {
+            const juce::ScopedLock lock(jobInfoLock);
+            workerJobInfo[(size_t) thread.index] = ProgressInfo();
+            thread.jobPriority = -1;
+            preemptedJobIds.erase(job.id);
+        }
     }
     
-    DBG("[AnalysisWorker] Worker thread stopped");
+    DBG("[AnalysisWorker] Worker thread " << thread.index << " stopped");
+}
+
+void AnalysisWorker::renewLeases()
+{
+    if (activeJobCount > 0)
+        databaseManager.renewJobLeases(leaseOwner);
+    
+    int requeued = 0, failed = 0;
+    
+    if (databaseManager.recoverExpiredJobs(maxJobAttempts, requeued, failed) && (requeued > 0 || failed > 0))
+    {
+        DBG("[AnalysisWorker] Recovered " << requeued << " abandoned job(s), gave up on " << failed);
+        pendingCountStale = true;
+    }
 }
 
 //==============================================================================
-bool AnalysisWorker::processJob(const DatabaseManager::Job& job)
+bool AnalysisWorker::processJob(WorkerThread& thread, DatabaseManager::Job& job, ProgressInfo& info,
+                                AnalysisResultWriter::Result& result)
 {
-    if (threadShouldExit())
+    if (juce::Thread::currentThreadShouldExit())
         return false;
     
-    isCurrentlyProcessing = true;
-    
     // Parse job parameters
     auto params = juce::JSON::parse(job.parameters);
     if (params.isVoid())
     {
         DBG("[AnalysisWorker] Error: Failed to parse job parameters");
+        job.errorMessage = "Invalid job parameters";
         return false;
     }
     
@@ -129,48 +461,52 @@ bool AnalysisWorker::processJob(const DatabaseManager::Job& job)
     if (paramsObj == nullptr)
     {
         DBG("[AnalysisWorker] Error: Job parameters is not an object");
+        job.errorMessage = "Invalid job parameters";
         return false;
     }
     
     // Update current job info
-    {
-        const juce::ScopedLock lock(jobInfoLock);
-        currentJobInfo.jobId = job.id;
-        currentJobInfo.jobType = job.jobType;
-        currentJobInfo.filePath = paramsObj->getProperty("file_path").toString();
-        currentJobInfo.progress = 0;
-        currentJobInfo.status = "running";
-        currentJobInfo.errorMessage = "";
-    }
+    info.jobId = job.id;
+    info.jobType = job.jobType;
+    info.filePath = job.filePath.isNotEmpty() ? job.filePath
+                                              : paramsObj->getProperty("file_path").toString();
+    info.progress = 0;
+    info.status = "running";
+    info.errorMessage = "";
     
-    notifyProgress(currentJobInfo);
+    notifyProgress(info);
     
     // Route to appropriate handler based on job type
     if (job.jobType == "analyze_audio")
     {
-        return processAudioAnalysis(job);
+        return processAudioAnalysis(thread, job, info, result);
+    }
+    else if (job.jobType == "measure_audio")
+    {
+        return processMeasurement(thread, job, info, result);
     }
     else
     {
         DBG("[AnalysisWorker] Error: Unknown job type: " << job.jobType);
+        job.errorMessage = "Unknown job type: " + job.jobType;
         return false;
     }
 }
 
-bool AnalysisWorker::processAudioAnalysis(const DatabaseManager::Job& job)
+bool AnalysisWorker::processAudioAnalysis(WorkerThread& thread, DatabaseManager::Job& job, ProgressInfo& info,
+                                          AnalysisResultWriter::Result& result)
 {
     auto params = juce::JSON::parse(job.parameters);
     auto* paramsObj = params.getDynamicObject();
     
-    juce::String filePath = paramsObj->getProperty("file_path").toString();
+    juce::String filePath = job.filePath.isNotEmpty() ? job.filePath
+                                                      : paramsObj->getProperty("file_path").toString();
     juce::File audioFile(filePath);
     
     if (!audioFile.existsAsFile())
     {
         DBG("[AnalysisWorker] Error: File not found: " << filePath);
-        auto updatedJob = job;
-        updatedJob.errorMessage = "File not found";
-        databaseManager.updateJob(updatedJob);
+        job.errorMessage = "File not found";
         return false;
     }
     
@@ -182,34 +518,192 @@ bool AnalysisWorker::processAudioAnalysis(const DatabaseManager::Job& job)
     track.fileSize = audioFile.getSize();
     track.dateAdded = juce::Time::getCurrentTime();
     track.lastModified = juce::Time(audioFile.getLastModificationTime());
+    track.fileIdentity = FileHasher::getFileIdentity(audioFile);
     
-    // Extract basic metadata
-    if (!extractBasicMetadata(audioFile, track))
+    auto millisecondsSince = [](double startTime) { return juce::Time::getMillisecondCounterHiRes() - startTime; };
+    
+    // Hash the file contents (no decoding) so byte-identical copies can be found, and in
+    // the same read the audio alone, so re-tagged copies can reuse an earlier analysis
+    auto stageStart = juce::Time::getMillisecondCounterHiRes();
+    FileHasher hasher;
+    hasher.setReadThrottle([this, &thread](juce::int64 numBytes) { governor.waitForTurn(thread.index, numBytes, &thread.cancellation); });
+    hasher.setCancellationToken(&thread.cancellation);
+    
+    juce::Range<juce::int64> audioRange;
+    juce::String audioHash;
+    thread.tagReader.findAudioPayload(audioFile, audioRange);
+    
+    if (hasher.hashFilePartial(audioFile, track.partialHash)
+        && hasher.hashFile(audioFile, track.fileHash, audioRange, audioHash))
+    {
+        for (const auto& dup : databaseManager.findTracksByFileHash(track.fileHash))
+        {
+            if (dup.filePath != track.filePath)
+            {
+                DBG("[AnalysisWorker] Byte-identical copy already in library: " << dup.filePath);
+            }
+        }
+    }
+    else
     {
-        DBG("[AnalysisWorker] Warning: Failed to extract metadata, using defaults");
+        DBG("[AnalysisWorker] Warning: Failed to hash file: " << hasher.getLastError());
+    }
+    
+    stats.record(AnalysisStats::stageHash, millisecondsSince(stageStart));
+    
+    if (CancellationToken::shouldStop(&thread.cancellation))
+    {
+        job.errorMessage = "Cancelled";
+        return false;
     }
     
     // Update progress
+    info.progress = 20;
+    notifyProgress(info);
+    
+    // Read the tags straight from the file; the decoder's metadata only fills the gaps
+    TagReader::Tags tags;
+    stageStart = juce::Time::getMillisecondCounterHiRes();
+    
+    if (thread.tagReader.readTags(audioFile, tags))
     {
-        const juce::ScopedLock lock(jobInfoLock);
-        currentJobInfo.progress = 40;
+        track.title = tags.title;
+        track.artist = tags.artist;
+        track.album = tags.album;
+        track.genre = tags.genre;
+        track.key = tags.key;
+        track.bpm = juce::roundToInt(tags.bpm);
     }
-    notifyProgress(currentJobInfo);
     
-    // Generate AcoustID fingerprint
+    const double tagsMs = millisecondsSince(stageStart);
+    
+    // Another copy of this audio was analysed before: its results only cost the hash read
+    DatabaseManager::AnalysisCacheEntry cached;
+    
+    if (databaseManager.getAnalysisCacheEntry(audioHash, cached) && applyCachedAnalysis(cached, tags, track, result))
+    {
+        DBG("[AnalysisWorker] Reusing the analysis of identical audio for: " << audioFile.getFileName());
+        
+        stats.record(AnalysisStats::stageTags, tagsMs);
+        
+        if (result.hasAudioFingerprint)
+            findDuplicates(track, result);
+        
+        if (track.title.isEmpty())
+            track.title = audioFile.getFileNameWithoutExtension();
+        
+        result.hasTrack = true;
+        result.track = track;
+        
+        // The earlier copy was sampled and its full decode has not run yet
+        if (!result.hasWaveform)
+            requestMeasurement(job, track.filePath, audioHash, result);
+        
+        info.progress = 100;
+        info.status = "completed";
+        notifyProgress(info);
+        
+        return true;
+    }
+    
+    // Decode the file once and fan the audio out to every analyser
+    // The pipeline and the long-lived consumers belong to this thread and are reused
+    MetadataConsumer metadataConsumer(track);
+    auto& pipeline = thread.pipeline;
+    auto& waveformConsumer = thread.waveformConsumer;
+    auto& tempoAnalyser = thread.tempoAnalyser;
+    auto& keyAnalyser = thread.keyAnalyser;
+    auto& loudnessAnalyser = thread.loudnessAnalyser;
+    auto& spectralFingerprinter = thread.spectralFingerprinter;
+    
+    pipeline.clearConsumers();
+    pipeline.addConsumer(&metadataConsumer);
+    pipeline.addConsumer(&waveformConsumer);
+    pipeline.addConsumer(&tempoAnalyser);
+    pipeline.addConsumer(&loudnessAnalyser);
+    pipeline.addConsumer(&spectralFingerprinter);
+    
+    // A tagged key is kept, so only analyse when there is none
+    const bool analyseKey = track.key.isEmpty();
+    
+    if (analyseKey)
+        pipeline.addConsumer(&keyAnalyser);
+    
     #ifdef HAVE_CHROMAPRINT
-    AcoustIDFingerprinter fingerprinter;
-    juce::String fingerprint;
-    int fingerprintDuration = 0;
+    auto& fingerprintConsumer = thread.fingerprintConsumer;
+    pipeline.addConsumer(&fingerprintConsumer);
+    #else
+    DBG("[AnalysisWorker] Chromaprint not available, skipping fingerprint generation");
+    #endif
+    
+    info.progress = 40;
+    notifyProgress(info);
+    
+    bool decoded = pipeline.process(audioFile);
+    
+    if (pipeline.wasCancelled())
+    {
+        job.errorMessage = "Cancelled";
+        return false;
+    }
+    
+    // A truncated or corrupt file fails rather than being stored with partial results
+    if (pipeline.hadDecodeError())
+    {
+        job.errorMessage = pipeline.getLastError();
+        return false;
+    }
+    
+    if (!decoded)
+    {
+        DBG("[AnalysisWorker] Warning: " << pipeline.getLastError() << ", using defaults");
+    }
+    
+    stats.record(AnalysisStats::stageTags, tagsMs + pipeline.getConsumerMs(&metadataConsumer));
+    stats.record(AnalysisStats::stageOpen, pipeline.getLastTimings().openMs);
+    
+    if (decoded)
+    {
+        stats.record(AnalysisStats::stageDecode, pipeline.getLastTimings().decodeMs);
+        
+        #ifdef HAVE_CHROMAPRINT
+        stats.record(AnalysisStats::stageFingerprint, pipeline.getConsumerMs(&spectralFingerprinter)
+                                                      + pipeline.getConsumerMs(&thread.fingerprintConsumer));
+        #else
+        stats.record(AnalysisStats::stageFingerprint, pipeline.getConsumerMs(&spectralFingerprinter));
+        #endif
+    }
+    
+    if (track.title.isEmpty())
+        track.title = audioFile.getFileNameWithoutExtension();
+    
+    // A sampled run leaves the waveform and loudness to a full decode queued after this job
+    const bool wholeFile = decoded && pipeline.decodedWholeFile();
+    
+    if (decoded && !wholeFile)
+        requestMeasurement(job, track.filePath, audioHash, result);
+    
+    resolveTempo(tags.bpm, decoded ? tempoAnalyser.getBpm() : 0.0, tempoAnalyser.getConfidence(), track);
+    
+    if (decoded && track.key.isEmpty())
+        track.key = keyAnalyser.getKey();
+    
+    // Album gain is filled in by the result writer once the track is stored
+    if (wholeFile && loudnessAnalyser.getIntegratedLoudness() < 0.0)
+    {
+        track.loudnessLufs = loudnessAnalyser.getIntegratedLoudness();
+        track.loudnessRange = loudnessAnalyser.getLoudnessRange();
+        track.truePeakDb = loudnessAnalyser.getTruePeak();
+    }
     
-    DBG("[AnalysisWorker] Generating fingerprint...");
-    if (fingerprinter.generateFingerprint(audioFile, fingerprint, fingerprintDuration))
+    #ifdef HAVE_CHROMAPRINT
+    if (decoded && fingerprintConsumer.getFingerprint().isNotEmpty())
     {
-        track.acoustidFingerprint = fingerprint;
+        track.acoustidFingerprint = fingerprintConsumer.getFingerprint();
         DBG("[AnalysisWorker] Fingerprint generated successfully");
         
         // Check for duplicates by fingerprint
-        auto duplicates = databaseManager.findTracksByFingerprint(fingerprint);
+        auto duplicates = databaseManager.findTracksByFingerprint(track.acoustidFingerprint);
         if (duplicates.size() > 0)
         {
             DBG("[AnalysisWorker] Found " << duplicates.size() << " potential duplicate(s):");
@@ -222,124 +716,269 @@ bool AnalysisWorker::processAudioAnalysis(const DatabaseManager::Job& job)
             }
         }
     }
-    else
+    else if (decoded)
     {
-        DBG("[AnalysisWorker] Warning: Failed to generate fingerprint: " << fingerprinter.getLastError());
+        DBG("[AnalysisWorker] Warning: Failed to generate fingerprint: " << fingerprintConsumer.getLastError());
         // Continue processing even if fingerprinting fails
     }
-    #else
-    DBG("[AnalysisWorker] Chromaprint not available, skipping fingerprint generation");
     #endif
     
+    // The native fingerprint finds copies of the same recording in any format, with or without Chromaprint
+    if (decoded && !spectralFingerprinter.getFingerprint().empty())
+    {
+        result.hasAudioFingerprint = true;
+        result.audioFingerprint.duration = track.duration;
+        result.audioFingerprint.bits = spectralFingerprinter.getFingerprint();
+        findDuplicates(track, result);
+    }
+    
     // Update progress
+    info.progress = 70;
+    notifyProgress(info);
+    
+    // The track, its overview and its grid are saved by the result writer, batched with other jobs
+    result.hasTrack = true;
+    result.track = track;
+    
+    if (wholeFile && waveformConsumer.getOverview().getNumBins() > 0)
     {
-        const juce::ScopedLock lock(jobInfoLock);
-        currentJobInfo.progress = 70;
+        result.hasWaveform = true;
+        result.waveform = waveformConsumer.getOverview();
     }
-    notifyProgress(currentJobInfo);
     
-    // Check if track already exists
-    auto existingTracks = databaseManager.searchTracks(track.filePath);
-    bool trackExists = false;
-    for (const auto& existing : existingTracks)
+    // The grid follows the track's final tempo, tagged or detected, and reuses the
+    // onset envelope from decoding
+    if (decoded)
     {
-        if (existing.filePath == track.filePath)
+        result.hasBeatGrid = true;
+        stageStart = juce::Time::getMillisecondCounterHiRes();
+        
+        if (track.bpmPrecise > 0.0)
+            BeatGridAnalyser::analyse(tempoAnalyser.getOnsetEnvelope(), tempoAnalyser.getFrameRate(),
+                                      tempoAnalyser.getFirstFrameTime(), track.bpmPrecise, result.beatGrid.markers);
+        
+        stats.record(AnalysisStats::stageAnalyse, millisecondsSince(stageStart)
+                                                  + pipeline.getConsumerMs(&waveformConsumer)
+                                                  + pipeline.getConsumerMs(&tempoAnalyser)
+                                                  + pipeline.getConsumerMs(&keyAnalyser)
+                                                  + pipeline.getConsumerMs(&loudnessAnalyser));
+    }
+    
+    // Keep the detected results (not the tagged ones) for later copies of the same audio
+    if (decoded && audioHash.isNotEmpty())
+    {
+        auto& entry = result.cacheEntry;
+        result.hasCacheEntry = true;
+        
+        entry.audioHash = audioHash;
+        entry.duration = track.duration;
+        entry.bpm = tempoAnalyser.getBpm();
+        entry.bpmConfidence = tempoAnalyser.getConfidence();
+        entry.key = analyseKey ? keyAnalyser.getKey() : juce::String();
+        entry.fingerprint = track.acoustidFingerprint;
+        entry.waveform = result.waveform;
+        entry.gridBpm = track.bpmPrecise;
+        entry.beatGrid = result.beatGrid.markers;
+        entry.audioFingerprint = result.audioFingerprint.bits;
+        
+        if (wholeFile && loudnessAnalyser.getIntegratedLoudness() < 0.0)
         {
-            // Update existing track
-            track.id = existing.id;
-            trackExists = true;
-            break;
+            entry.loudnessLufs = loudnessAnalyser.getIntegratedLoudness();
+            entry.loudnessRange = loudnessAnalyser.getLoudnessRange();
+            entry.truePeakDb = loudnessAnalyser.getTruePeak();
         }
     }
     
-    // Add or update track in database
-    int64_t trackId = 0;
-    bool dbSuccess = false;
+    // Update progress to complete
+    info.progress = 100;
+    info.status = "completed";
+    notifyProgress(info);
+    
+    return true;
+}
+
+bool AnalysisWorker::processMeasurement(WorkerThread& thread, DatabaseManager::Job& job, ProgressInfo& info,
+                                        AnalysisResultWriter::Result& result)
+{
+    auto params = juce::JSON::parse(job.parameters);
+    auto* paramsObj = params.getDynamicObject();
+    
+    juce::String filePath = job.filePath.isNotEmpty() ? job.filePath
+                                                      : paramsObj->getProperty("file_path").toString();
+    juce::File audioFile(filePath);
     
-    if (trackExists)
+    if (!audioFile.existsAsFile())
     {
-        dbSuccess = databaseManager.updateTrack(track);
+        DBG("[AnalysisWorker] Error: File not found: " << filePath);
+        job.errorMessage = "File not found";
+        return false;
     }
-    else
+    
+    // Only the waveform and loudness change; everything else stays as analysed
+    auto track = databaseManager.getTrackByPath(audioFile.getFullPathName());
+    
+    if (track.id == 0)
     {
-        dbSuccess = databaseManager.addTrack(track, trackId);
+        DBG("[AnalysisWorker] Error: Track not in library: " << filePath);
+        job.errorMessage = "Track not in library";
+        return false;
     }
     
-    if (!dbSuccess)
+    DBG("[AnalysisWorker] Measuring: " << audioFile.getFileName());
+    
+    info.progress = 20;
+    notifyProgress(info);
+    
+    auto& pipeline = thread.measurePipeline;
+    
+    if (!pipeline.process(audioFile))
     {
-        DBG("[AnalysisWorker] Error: Failed to save track to database");
-        auto updatedJob = job;
-        updatedJob.errorMessage = "Failed to save to database";
-        databaseManager.updateJob(updatedJob);
+        job.errorMessage = pipeline.wasCancelled() ? juce::String("Cancelled") : pipeline.getLastError();
         return false;
     }
     
-    // Update progress to complete
+    stats.record(AnalysisStats::stageOpen, pipeline.getLastTimings().openMs);
+    stats.record(AnalysisStats::stageDecode, pipeline.getLastTimings().decodeMs);
+    stats.record(AnalysisStats::stageAnalyse, pipeline.getConsumerMs(&thread.waveformConsumer)
+                                              + pipeline.getConsumerMs(&thread.loudnessAnalyser));
+    
+    const auto& loudnessAnalyser = thread.loudnessAnalyser;
+    
+    // Album gain is recomputed by the result writer
+    if (loudnessAnalyser.getIntegratedLoudness() < 0.0)
     {
-        const juce::ScopedLock lock(jobInfoLock);
-        currentJobInfo.progress = 100;
-        currentJobInfo.status = "completed";
+        track.loudnessLufs = loudnessAnalyser.getIntegratedLoudness();
+        track.loudnessRange = loudnessAnalyser.getLoudnessRange();
+        track.truePeakDb = loudnessAnalyser.getTruePeak();
+    }
+    
+    result.hasTrack = true;
+    result.track = track;
+    
+    if (thread.waveformConsumer.getOverview().getNumBins() > 0)
+    {
+        result.hasWaveform = true;
+        result.waveform = thread.waveformConsumer.getOverview();
     }
-    notifyProgress(currentJobInfo);
+    
+    // Later copies of the same audio get the full results too
+    auto& entry = result.cacheEntry;
+    
+    if (databaseManager.getAnalysisCacheEntry(paramsObj->getProperty("audio_hash").toString(), entry))
+    {
+        result.hasCacheEntry = true;
+        entry.waveform = result.waveform;
+        entry.loudnessLufs = track.loudnessLufs;
+        entry.loudnessRange = track.loudnessRange;
+        entry.truePeakDb = track.truePeakDb;
+    }
+    
+    info.progress = 100;
+    info.status = "completed";
+    notifyProgress(info);
     
     return true;
 }
 
-bool AnalysisWorker::extractBasicMetadata(const juce::File& audioFile, DatabaseManager::Track& track)
+void AnalysisWorker::requestMeasurement(const DatabaseManager::Job& job, const juce::String& filePath,
+                                        const juce::String& audioHash, AnalysisResultWriter::Result& result)
 {
-    // Create audio format manager and register formats
-    juce::AudioFormatManager formatManager;
-    formatManager.registerBasicFormats();
+    auto& followUp = result.followUpJob;
+    result.hasFollowUpJob = true;
+    
+    followUp.jobType = "measure_audio";
+    followUp.status = "pending";
+    followUp.filePath = filePath;
+    followUp.priority = job.priority;  // A track the user has open gets its waveform next
+    followUp.dateCreated = juce::Time::getCurrentTime();
+    
+    juce::var paramsObj = new juce::DynamicObject();
+    paramsObj.getDynamicObject()->setProperty("file_path", filePath);
+    paramsObj.getDynamicObject()->setProperty("audio_hash", audioHash);
     
-    // Try to read the file
-    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(audioFile));
+    followUp.parameters = juce::JSON::toString(paramsObj);
+}
+
+void AnalysisWorker::resultWritten(const AnalysisResultWriter::Result& result, bool saved)
+{
+    stats.record(AnalysisStats::stageDatabase, result.writeMs);
+    stats.recordFile(result.hasTrack ? result.track.fileSize : 0);
     
-    if (reader == nullptr)
+    if (saved)
     {
-        DBG("[AnalysisWorker] Warning: Could not create audio reader for: " << audioFile.getFileName());
-        // Set defaults
-        track.title = audioFile.getFileNameWithoutExtension();
-        track.duration = 0.0;
-        return false;
+        // Only committed tracks have an id; the next job can find this one as a duplicate
+        if (result.hasAudioFingerprint)
+            fingerprintIndex.add(result.audioFingerprint.trackId, result.audioFingerprint.bits);
+        
+        ++jobsCompleted;
+        return;
     }
     
-    // Calculate duration
-    track.duration = reader->lengthInSamples / reader->sampleRate;
+    ++jobsFailed;
+    
+    // Analysis failures were already reported by the worker; report save failures here
+    if (result.job.errorMessage == "Failed to save to database" || result.job.status == "completed")
+    {
+        ProgressInfo info;
+        info.jobId = result.job.id;
+        info.jobType = result.job.jobType;
+        info.filePath = result.job.filePath;
+        info.status = "failed";
+        info.errorMessage = "Failed to save to database";
+        notifyProgress(info);
+    }
+}
+
+void AnalysisWorker::findDuplicates(const DatabaseManager::Track& track, AnalysisResultWriter::Result& result)
+{
+    // Re-encodes and trimmed edits match too, whatever their length
+    loadFingerprintIndex();
     
-    // Extract metadata from the reader
-    auto metadata = reader->metadataValues;
+    for (const auto& match : fingerprintIndex.findMatches(result.audioFingerprint.bits))
+    {
+        const auto duplicate = databaseManager.getTrack(match.trackId);
+        
+        // Tracks removed from the library since the index was loaded
+        if (duplicate.id == 0)
+        {
+            fingerprintIndex.remove(match.trackId);
+            continue;
+        }
+        
+        if (duplicate.filePath != track.filePath)  // Don't report the file as duplicate of itself
+        {
+            DBG("[AnalysisWorker] Potential duplicate (bit error rate " << match.bitErrorRate << "): "
+                << duplicate.filePath);
+            
+            DatabaseManager::DuplicateMatch duplicateMatch;
+            duplicateMatch.duplicateId = match.trackId;
+            duplicateMatch.bitErrorRate = match.bitErrorRate;
+            result.duplicateMatches.push_back(duplicateMatch);
+        }
+    }
+}
+
+void AnalysisWorker::loadFingerprintIndex()
+{
+    if (fingerprintIndexLoaded)
+        return;
     
-    // Extract title
-    if (metadata.containsKey("title"))
-        track.title = metadata["title"];
-    else if (metadata.containsKey("TITLE"))
-        track.title = metadata["TITLE"];
-    else
-        track.title = audioFile.getFileNameWithoutExtension();
+    const juce::ScopedLock lock(fingerprintIndexLoadLock);
     
-    // Extract artist
-    if (metadata.containsKey("artist"))
-        track.artist = metadata["artist"];
-    else if (metadata.containsKey("ARTIST"))
-        track.artist = metadata["ARTIST"];
+    if (fingerprintIndexLoaded)
+        return;
     
-    // Extract album
-    if (metadata.containsKey("album"))
-        track.album = metadata["album"];
-    else if (metadata.containsKey("ALBUM"))
-        track.album = metadata["ALBUM"];
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
     
-    // Extract genre
-    if (metadata.containsKey("genre"))
-        track.genre = metadata["genre"];
-    else if (metadata.containsKey("GENRE"))
-        track.genre = metadata["GENRE"];
+    // Only the excerpts the index keeps are read; tracks committed meanwhile are simply replaced
+    for (const auto& excerpt : databaseManager.getAudioFingerprintExcerpts(FingerprintIndex::excerptStartFrame,
+                                                                          FingerprintIndex::excerptFrames))
+        fingerprintIndex.add(excerpt.trackId, excerpt.bits);
     
-    DBG("[AnalysisWorker] Extracted metadata - Title: " << track.title 
-        << ", Artist: " << track.artist 
-        << ", Duration: " << track.duration << "s");
+    fingerprintIndexLoaded = true;
     
-    return true;
+    DBG("[AnalysisWorker] Loaded " << fingerprintIndex.getNumTracks() << " fingerprints into the index in "
+        << juce::Time::getMillisecondCounterHiRes() - startTime << " ms");
 }
 
 //==============================================================================
@@ -349,8 +988,18 @@ void AnalysisWorker::setProgressCallback(std::function<void(const ProgressInfo&)
     progressCallback = callback;
 }
 
-void AnalysisWorker::notifyProgress(const ProgressInfo& info)
+void AnalysisWorker::notifyProgress(ProgressInfo& info)
 {
+    info.activeJobs = activeJobCount;
+    
+    {
+        const juce::ScopedLock lock(jobInfoLock);
+        currentJobInfo = info;
+        
+        if (juce::isPositiveAndBelow(info.workerIndex, (int) workerJobInfo.size()))
+            workerJobInfo[(size_t) info.workerIndex] = info;
+    }
+    
     const juce::ScopedLock lock(callbackLock);
     if (progressCallback)
     {
@@ -360,8 +1009,11 @@ void AnalysisWorker::notifyProgress(const ProgressInfo& info)
 
 int AnalysisWorker::getPendingJobCount() const
 {
-    auto pendingJobs = databaseManager.getJobsByStatus("pending");
-    return static_cast<int>(pendingJobs.size());
+    // Clear the flag before querying, so a change during the query marks it stale again
+    if (pendingCountStale.exchange(false))
+        cachedPendingCount = databaseManager.getJobCountByStatus("pending");
+    
+    return cachedPendingCount;
 }
 
 AnalysisWorker::ProgressInfo AnalysisWorker::getCurrentJob() const
@@ -370,7 +1022,21 @@ AnalysisWorker::ProgressInfo AnalysisWorker::getCurrentJob() const
     return currentJobInfo;
 }
 
+std::vector<AnalysisWorker::ProgressInfo> AnalysisWorker::getActiveJobs() const
+{
+    const juce::ScopedLock lock(jobInfoLock);
+    
+    std::vector<ProgressInfo> active;
+    for (const auto& info : workerJobInfo)
+    {
+        if (info.status == "running")
+            active.push_back(info);
+    }
+    
+    return active;
+}
+
 bool AnalysisWorker::isProcessing() const
 {
-    return isCurrentlyProcessing;
+    return activeJobCount > 0;
 }
@@ -24,32 +24,70 @@
 
 #include <juce_core/juce_core.h>
 #include "DatabaseManager.h"
+#include "AnalysisResultWriter.h"
+#include "AnalysisStats.h"
+#include "FingerprintIndex.h"
+#include "ResourceGovernor.h"
 #include <functional>
 #include <atomic>
+#include <set>
+#include <vector>
 
 //==============================================================================
 /**
-    AnalysisWorker is a background thread that processes pending jobs from the
-    database queue. It processes one job at a time and provides progress callbacks
-    to keep the UI updated.
+    AnalysisWorker processes pending jobs from the database queue on a pool of
+    background threads. Each thread claims one job at a time from the database
+    (claims are atomic, so no job is processed twice) and progress from all
+    threads is reported through a single callback to keep the UI updated.
+
+    Idle threads sleep until the database reports that a job became available,
+    so an empty queue costs no database traffic.
+    Finished jobs are handed to an AnalysisResultWriter, which commits them to
+    the database in batches.
+
+    Claims are leases held in this worker's name. A heartbeat thread recovers
+    jobs whose lease expired when the pool starts and, while jobs run, renews
+    the pool's leases and keeps recovering; it sleeps while the pool is idle.
+    Expired leases are what a crashed or killed run leaves behind: those jobs go
+    back to pending, or to failed once they have been tried getMaxJobAttempts()
+    times.
+
+    A ResourceGovernor limits how many threads work, at what priority and how
+    fast they read, while an audio preview plays or the UI is in use.
+
+    Each thread's hashing and decoding check a CancellationToken between blocks.
+    Stopping the pool cancels every job, and a job queued above background
+    priority while no thread is free preempts the least urgent running one;
+    either way the interrupted job goes back to pending as if never claimed.
 */
-class AnalysisWorker : public juce::Thread
+class AnalysisWorker
 {
 public:
     //==============================================================================
     struct ProgressInfo
     {
-        int64_t jobId;
+        int64_t jobId = 0;
         juce::String jobType;
         juce::String filePath;
-        int progress;  // 0-100
+        int progress = 0;  // 0-100
         juce::String status;
         juce::String errorMessage;
+        int workerIndex = -1;  // Which pool thread reported this update
+        int activeJobs = 0;    // Jobs in progress across the whole pool at report time
     };
     
     //==============================================================================
-    AnalysisWorker(DatabaseManager& dbManager);
-    ~AnalysisWorker() override;
+    /**
+     * @param dbManager The database holding the job queue
+     * @param numThreads Number of worker threads; 0 uses getDefaultThreadCount()
+     */
+    AnalysisWorker(DatabaseManager& dbManager, int numThreads = 0);
+    ~AnalysisWorker();
+    
+    /**
+     * Default pool size: one thread per hardware thread, leaving one for the UI.
+     */
+    static int getDefaultThreadCount();
     
     /**
      * Set a progress callback to be notified when job status changes.
@@ -59,51 +97,151 @@ public:
     void setProgressCallback(std::function<void(const ProgressInfo&)> callback);
     
     /**
-     * Start the worker thread.
+     * Start the worker threads.
      */
     void startWorker();
     
     /**
-     * Stop the worker thread gracefully.
+     * Stop all worker threads gracefully.
      */
     void stopWorker();
     
     /**
-     * Get the current number of pending jobs in the queue.
+     * Wake idle worker threads to look for work. If highestPriority is above
+     * background and every allowed thread is busy, the running job of lowest
+     * priority below it is preempted (each job at most once). Called
+     * automatically when a job is added through the DatabaseManager; only
+     * needed after changing the Jobs table some other way.
+     */
+    void notifyJobAvailable(int highestPriority = DatabaseManager::jobPriorityBackground);
+    
+    /**
+     * Get the number of threads in the pool.
+     */
+    int getNumThreads() const;
+    
+    /**
+     * Get the current number of pending jobs in the queue. The count is cached
+     * and only re-queried after jobs were added or claimed, so polling it from
+     * a UI timer is cheap.
      */
     int getPendingJobCount() const;
     
     /**
-     * Get the current job being processed (if any).
+     * Get the most recently reported job (if any).
      */
     ProgressInfo getCurrentJob() const;
     
     /**
-     * Check if the worker is currently processing a job.
+     * Get the jobs currently being processed, one entry per busy thread.
+     */
+    std::vector<ProgressInfo> getActiveJobs() const;
+    
+    /**
+     * Check if any worker thread is currently processing a job.
      */
     bool isProcessing() const;
+    
+    /**
+     * The writer that commits finished jobs; use it to tune batch size,
+     * latency and durability.
+     */
+    AnalysisResultWriter& getResultWriter()  { return resultWriter; }
+    
+    /**
+     * The governor that scales the pool down while previews play, the UI is
+     * busy or the machine runs on battery; report those states to it.
+     */
+    ResourceGovernor& getResourceGovernor()  { return governor; }
+    
+    /**
+     * Number of jobs completed / failed since the pool was created. A job
+     * counts once its result has been committed.
+     */
+    int getCompletedJobCount() const  { return jobsCompleted; }
+    int getFailedJobCount() const     { return jobsFailed; }
+    
+    /**
+     * Per-stage latency histograms and throughput of the jobs processed so far.
+     */
+    AnalysisStats& getStats()  { return stats; }
+    
+    /**
+     * How many times a job may be claimed before an expired lease fails it
+     * instead of requeueing it (default DatabaseManager::defaultMaxJobAttempts).
+     */
+    void setMaxJobAttempts(int attempts)  { maxJobAttempts = juce::jmax(1, attempts); }
+    int getMaxJobAttempts() const         { return maxJobAttempts; }
+    
+    /** The name this pool's leases are held under, unique per instance. */
+    const juce::String& getLeaseOwner() const  { return leaseOwner; }
+    
+    static constexpr int heartbeatIntervalMs = 15000;
 
 private:
     //==============================================================================
-    void run() override;
+    class WorkerThread;
+    class HeartbeatThread;
+    
+    // Main loop of each pool thread
+    void runWorker(WorkerThread& thread);
+    
+    // One heartbeat: renew our leases and recover expired ones
+    void renewLeases();
     
-    // Process a single job
-    bool processJob(const DatabaseManager::Job& job);
+    // Cancel the least urgent running job if a job of this priority has no thread
+    void preemptFor(int priority);
+    
+    // Process a single job on the given thread (whose decoder state is reused);
+    // sets job.errorMessage on failure and fills in what should be saved
+    bool processJob(WorkerThread& thread, DatabaseManager::Job& job, ProgressInfo& info,
+                    AnalysisResultWriter::Result& result);
     
     // Process an audio analysis job
-    bool processAudioAnalysis(const DatabaseManager::Job& job);
+    bool processAudioAnalysis(WorkerThread& thread, DatabaseManager::Job& job, ProgressInfo& info,
+                              AnalysisResultWriter::Result& result);
+    
+    // Decode a sampled file whole for its waveform and loudness
+    bool processMeasurement(WorkerThread& thread, DatabaseManager::Job& job, ProgressInfo& info,
+                            AnalysisResultWriter::Result& result);
+    
+    // Have the result writer queue a measure_audio job for the file once this job is stored
+    void requestMeasurement(const DatabaseManager::Job& job, const juce::String& filePath,
+                            const juce::String& audioHash, AnalysisResultWriter::Result& result);
+    
+    // Called by the result writer once a job's result is committed (or failed to be)
+    void resultWritten(const AnalysisResultWriter::Result& result, bool saved);
+    
+    // Look the result's spectral fingerprint up in the index; the writer stores the matches
+    void findDuplicates(const DatabaseManager::Track& track, AnalysisResultWriter::Result& result);
     
-    // Extract basic metadata from an audio file
-    bool extractBasicMetadata(const juce::File& audioFile, DatabaseManager::Track& track);
+    // Fill the fingerprint index from the database, once, on the first job that needs it
+    void loadFingerprintIndex();
     
-    // Notify progress callback
-    void notifyProgress(const ProgressInfo& info);
+    // Record a worker's progress and notify the callback
+    void notifyProgress(ProgressInfo& info);
     
     //==============================================================================
     DatabaseManager& databaseManager;
+    AnalysisResultWriter resultWriter;
+    ResourceGovernor governor;
+    AnalysisStats stats;
+    FingerprintIndex fingerprintIndex;
+    std::atomic<bool> fingerprintIndexLoaded{false};
+    juce::CriticalSection fingerprintIndexLoadLock;
+    juce::OwnedArray<WorkerThread> threads;
+    std::unique_ptr<HeartbeatThread> heartbeat;
+    const juce::String leaseOwner;
+    std::atomic<int> maxJobAttempts{DatabaseManager::defaultMaxJobAttempts};
     std::function<void(const ProgressInfo&)> progressCallback;
-    std::atomic<bool> isCurrentlyProcessing{false};
+    std::atomic<int> activeJobCount{0};
+    std::atomic<int> jobsCompleted{0};
+    std::atomic<int> jobsFailed{0};
+    mutable std::atomic<int> cachedPendingCount{0};
+    mutable std::atomic<bool> pendingCountStale{true};
     ProgressInfo currentJobInfo;
+    std::vector<ProgressInfo> workerJobInfo;  // Indexed by workerIndex
+    std::set<int64_t> preemptedJobIds;        // Jobs preempted once, never again
     mutable juce::CriticalSection callbackLock;
     mutable juce::CriticalSection jobInfoLock;
     
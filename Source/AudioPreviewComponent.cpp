@@ -256,4 +256,7 @@ void AudioPreviewComponent::updateTransportState()
 {
     playButton.setEnabled(!playing);
     pauseButton.setEnabled(playing);
+    
+    if (onPlayingChanged)
+        onPlayingChanged(playing);
 }
@@ -100,6 +100,12 @@ public:
      * Set cue points to display on waveform.
      */
     void setCuePoints(const std::vector<double>& positions);
+    
+    /**
+     * Called whenever playback starts or stops, e.g. to tell the analysis
+     * ResourceGovernor that a preview is playing.
+     */
+    std::function<void(bool isPlaying)> onPlayingChanged;
 
     void paint(juce::Graphics&) override;
     void resized() override;
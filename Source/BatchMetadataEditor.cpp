@@ -212,7 +212,9 @@ void BatchMetadataEditor::onApplyClicked()
         
         if (bpmCheckbox.getToggleState() && bpmEditor.getText().isNotEmpty())
         {
-            track.bpm = bpmEditor.getText().getIntValue();
+            track.bpmPrecise = bpmEditor.getText().getDoubleValue();
+            track.bpmConfidence = 1.0;
+            track.bpm = juce::roundToInt(track.bpmPrecise);
             modified = true;
         }
         
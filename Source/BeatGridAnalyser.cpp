@@ -0,0 +1,343 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+#include "BeatGridAnalyser.h"
+#include <cmath>
+
+//==============================================================================
+void BeatGridAnalyser::Segment::add(double k, double y)
+{
+    count += 1.0;
+    sumK += k;
+    sumKK += k * k;
+    sumY += y;
+    sumKY += k * y;
+    lastBeat = y;
+}
+
+void BeatGridAnalyser::Segment::merge(const Segment& other, double beatOffset)
+{
+    // Renumber the other run's beats so they continue this one's count
+    count += other.count;
+    sumK += other.sumK + other.count * beatOffset;
+    sumKK += other.sumKK + 2.0 * beatOffset * other.sumK + other.count * beatOffset * beatOffset;
+    sumY += other.sumY;
+    sumKY += other.sumKY + beatOffset * other.sumY;
+    lastBeat = other.lastBeat;
+}
+
+double BeatGridAnalyser::Segment::getPeriod() const
+{
+    const double denominator = count * sumKK - sumK * sumK;
+    return denominator > 0.0 ? (count * sumKY - sumK * sumY) / denominator : 0.0;
+}
+
+double BeatGridAnalyser::Segment::getOrigin(double period) const
+{
+    return count > 0.0 ? (sumY - period * sumK) / count : 0.0;
+}
+
+//==============================================================================
+bool BeatGridAnalyser::analyse(const std::vector<float>& envelope, double frameRate, double firstFrameTime,
+                               double bpm, std::vector<DatabaseManager::BeatGridMarker>& outMarkers)
+{
+    outMarkers.clear();
+    
+    if (bpm <= 0.0 || frameRate <= 0.0)
+        return false;
+    
+    const double period = frameRate * 60.0 / bpm;
+    const double tolerance = maxBeatError * frameRate;
+    
+    if ((double) envelope.size() < period * minSegmentBeats)
+        return false;
+    
+    const auto segments = findSegments(trackBeats(envelope, period), period, tolerance);
+    
+    // Only long runs count; a run that picks up the previous one's grid after a
+    // break (a breakdown, a missed beat) is the same segment
+    std::vector<Segment> grid;
+    
+    for (const auto& segment : segments)
+    {
+        if (segment.count < minSegmentBeats)
+            continue;
+        
+        if (!grid.empty())
+        {
+            auto& previous = grid.back();
+            const double previousPeriod = previous.getPeriod();
+            const double previousOrigin = previous.getOrigin(previousPeriod);
+            const double segmentPeriod = segment.getPeriod();
+            const double segmentOrigin = segment.getOrigin(segmentPeriod);
+            
+            const double beatOffset = std::round((segmentOrigin - previousOrigin) / previousPeriod);
+            const double phaseError = std::abs(segmentOrigin - (previousOrigin + beatOffset * previousPeriod));
+            const double tempoChange = std::abs(frameRate * 60.0 / segmentPeriod - frameRate * 60.0 / previousPeriod);
+            
+            if (tempoChange < minTempoChange && phaseError <= tolerance)
+            {
+                previous.merge(segment, beatOffset);
+                continue;
+            }
+        }
+        
+        grid.push_back(segment);
+    }
+    
+    if (grid.empty())
+        return false;
+    
+    auto toSeconds = [frameRate, firstFrameTime](double frame) { return firstFrameTime + frame / frameRate; };
+    
+    for (size_t i = 0; i < grid.size(); ++i)
+    {
+        const auto& segment = grid[i];
+        
+        // The fitted tempo only has to be close: the track's tempo is measured over
+        // far more beats, so it wins whenever the two agree
+        double segmentPeriod = segment.getPeriod();
+        
+        if (std::abs(frameRate * 60.0 / segmentPeriod - bpm) < minTempoChange)
+            segmentPeriod = period;
+        
+        double origin = segment.getOrigin(segmentPeriod);
+        int beat = 1;
+        
+        if (i == 0)
+        {
+            // Extend the grid back to the first beat of the track
+            const double beatsBefore = std::floor(toSeconds(origin) * frameRate / segmentPeriod);
+            origin -= beatsBefore * segmentPeriod;
+            
+            const int downbeat = findDownbeat(envelope, segment, segmentPeriod);
+            const int beatsIn = static_cast<int>(-beatsBefore) - downbeat;
+            beat = (beatsIn % beatsPerBar + beatsPerBar) % beatsPerBar + 1;
+        }
+        else
+        {
+            // Keep counting bars across the tempo change
+            const auto& previous = outMarkers.back();
+            const int elapsed = juce::roundToInt((toSeconds(origin) - previous.position) * previous.bpm / 60.0);
+            beat = (previous.beat - 1 + elapsed) % beatsPerBar + 1;
+        }
+        
+        DatabaseManager::BeatGridMarker marker;
+        marker.position = toSeconds(origin);
+        marker.bpm = frameRate * 60.0 / segmentPeriod;
+        marker.beat = beat;
+        outMarkers.push_back(marker);
+    }
+    
+    DBG("[BeatGridAnalyser] " << (int) outMarkers.size() << " grid marker(s), first beat at "
+        << juce::String(outMarkers.front().position, 3) << "s");
+    
+    return true;
+}
+
+//==============================================================================
+std::vector<double> BeatGridAnalyser::trackBeats(const std::vector<float>& envelope, double period)
+{
+    // Penalty for a gap that strays from the beat period, on a log scale
+    constexpr double tightness = 100.0;
+    
+    const int n = (int) envelope.size();
+    
+    // Scale onsets to unit deviation so the penalty weighs the same for every track
+    double sum = 0.0, sumSquares = 0.0;
+    
+    for (auto value : envelope)
+    {
+        sum += value;
+        sumSquares += (double) value * value;
+    }
+    
+    const double variance = sumSquares / n - (sum / n) * (sum / n);
+    
+    if (variance <= 0.0)
+        return {};
+    
+    const double scale = 1.0 / std::sqrt(variance);
+    
+    const int minGap = juce::jmax(1, juce::roundToInt(period * 0.5));
+    const int maxGap = juce::roundToInt(period * 2.0);
+    
+    std::vector<double> penalty((size_t) maxGap + 1, 0.0);
+    
+    for (int gap = minGap; gap <= maxGap; ++gap)
+    {
+        const double stretch = std::log(gap / period);
+        penalty[(size_t) gap] = tightness * stretch * stretch;
+    }
+    
+    // score[t]: the best total for a beat sequence ending on frame t
+    std::vector<double> score((size_t) n);
+    std::vector<int> previousBeat((size_t) n, -1);
+    
+    for (int t = 0; t < n; ++t)
+    {
+        double best = 0.0;
+        
+        for (int gap = minGap; gap <= juce::jmin(maxGap, t); ++gap)
+        {
+            const double candidate = score[(size_t) (t - gap)] - penalty[(size_t) gap];
+            
+            if (previousBeat[(size_t) t] < 0 || candidate > best)
+            {
+                best = candidate;
+                previousBeat[(size_t) t] = t - gap;
+            }
+        }
+        
+        score[(size_t) t] = envelope[(size_t) t] * scale + best;
+    }
+    
+    // The sequence ends on the best frame within the last beat period
+    int beat = n - 1;
+    
+    for (int t = juce::jmax(0, n - juce::roundToInt(period)); t < n; ++t)
+    {
+        if (score[(size_t) t] > score[(size_t) beat])
+            beat = t;
+    }
+    
+    std::vector<double> beats;
+    
+    for (; beat >= 0; beat = previousBeat[(size_t) beat])
+    {
+        // Parabolic interpolation puts the beat between frames
+        double offset = 0.0;
+        
+        if (beat > 0 && beat < n - 1)
+        {
+            const double left = envelope[(size_t) beat - 1];
+            const double centre = envelope[(size_t) beat];
+            const double right = envelope[(size_t) beat + 1];
+            const double denominator = left - 2.0 * centre + right;
+            
+            if (denominator < 0.0 && centre >= left && centre >= right)
+                offset = 0.5 * (left - right) / denominator;
+        }
+        
+        beats.push_back(beat + offset);
+    }
+    
+    std::reverse(beats.begin(), beats.end());
+    return beats;
+}
+
+std::vector<BeatGridAnalyser::Segment> BeatGridAnalyser::findSegments(const std::vector<double>& beats,
+                                                                      double period, double tolerance)
+{
+    // A few beats off the line are noise; this many in a row end the segment
+    constexpr int maxMisses = 4;
+    
+    std::vector<Segment> segments;
+    const int numBeats = (int) beats.size();
+    
+    for (int first = 0; first < numBeats;)
+    {
+        Segment segment;
+        double origin = beats[(size_t) first];
+        
+        // Until there are enough beats to fit a line, go by the local beat spacing,
+        // which is what follows a tempo that differs from the track's
+        std::vector<double> gaps;
+        
+        for (int i = first + 1; i < juce::jmin(numBeats, first + 5); ++i)
+            gaps.push_back(beats[(size_t) i] - beats[(size_t) i - 1]);
+        
+        double slope = period;
+        
+        if (!gaps.empty())
+        {
+            std::nth_element(gaps.begin(), gaps.begin() + (long) gaps.size() / 2, gaps.end());
+            const double spacing = gaps[gaps.size() / 2];
+            
+            if (spacing > period * 0.8 && spacing < period * 1.25)
+                slope = spacing;
+        }
+        
+        int last = first;
+        int misses = 0;
+        
+        for (int i = first; i < numBeats; ++i)
+        {
+            // Match each beat to the nearest grid line, so skipped beats do not matter
+            const double k = std::round((beats[(size_t) i] - origin) / slope);
+            
+            if (std::abs(beats[(size_t) i] - (origin + k * slope)) > tolerance)
+            {
+                if (++misses == maxMisses)
+                    break;
+                
+                continue;
+            }
+            
+            segment.add(k, beats[(size_t) i]);
+            last = i;
+            misses = 0;
+            
+            if (segment.count >= 4.0 && segment.getPeriod() > 0.0)
+            {
+                slope = segment.getPeriod();
+                origin = segment.getOrigin(slope);
+            }
+        }
+        
+        segments.push_back(segment);
+        first = last + 1;
+    }
+    
+    return segments;
+}
+
+int BeatGridAnalyser::findDownbeat(const std::vector<float>& envelope, const Segment& segment, double period)
+{
+    const double origin = segment.getOrigin(period);
+    const int numBeats = juce::roundToInt((segment.lastBeat - origin) / period) + 1;
+    const int n = (int) envelope.size();
+    
+    double strength[beatsPerBar] = {};
+    
+    // Sum the onsets on each beat of the bar, allowing a frame either side
+    for (int k = 0; k < numBeats; ++k)
+    {
+        const int frame = juce::roundToInt(origin + k * period);
+        float peak = 0.0f;
+        
+        for (int t = juce::jmax(0, frame - 1); t <= juce::jmin(n - 1, frame + 1); ++t)
+            peak = juce::jmax(peak, envelope[(size_t) t]);
+        
+        strength[k % beatsPerBar] += peak;
+    }
+    
+    int downbeat = 0;
+    
+    for (int i = 1; i < beatsPerBar; ++i)
+    {
+        if (strength[i] > strength[downbeat])
+            downbeat = i;
+    }
+    
+    return downbeat;
+}
@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "DatabaseManager.h"
+#include <vector>
+
+//==============================================================================
+/**
+    Turns the onset envelope that TempoAnalyser builds during decoding into a
+    beat grid, so no audio has to be decoded again.
+
+    Beats are tracked by dynamic programming: every envelope frame is scored by
+    its onset strength plus the best-scoring previous beat, penalised by how far
+    the gap strays from the tempo's beat period. Straight lines are then fitted
+    through the tracked beats; a new segment starts wherever the beats leave
+    the current line for good. Segments that keep the same tempo and phase are
+    merged, so steady tracks end up with a single marker at the track's precise
+    tempo. The downbeat is the beat of the bar with the strongest onsets.
+*/
+class BeatGridAnalyser
+{
+public:
+    /**
+     * Track the beats in an onset envelope and fit a grid to them.
+     * @param envelope Onset strength per frame (TempoAnalyser::getOnsetEnvelope())
+     * @param frameRate Envelope frames per second
+     * @param firstFrameTime Time in seconds of the first envelope frame
+     * @param bpm The track's tempo, which sets the expected beat period
+     * @param outMarkers Receives the grid markers, earliest first
+     * @return False if there is too little audio or no steady beat was found
+     */
+    static bool analyse(const std::vector<float>& envelope, double frameRate, double firstFrameTime,
+                        double bpm, std::vector<DatabaseManager::BeatGridMarker>& outMarkers);
+    
+    static constexpr int beatsPerBar = 4;
+    
+    // Shorter runs of beats (8 bars) are not trusted to start a tempo segment
+    static constexpr int minSegmentBeats = 32;
+    
+    // How far in seconds a beat may sit off the grid before it counts as a miss
+    static constexpr double maxBeatError = 0.03;
+    
+    // Segments whose tempos differ by less than this (in BPM) are the same tempo
+    static constexpr double minTempoChange = 0.1;
+
+private:
+    //==============================================================================
+    // A run of beats on one straight line, as least-squares sums of
+    // beat frame (y) against beat number (k, counted from the run's first beat)
+    struct Segment
+    {
+        double count = 0.0, sumK = 0.0, sumKK = 0.0, sumY = 0.0, sumKY = 0.0;
+        double lastBeat = 0.0;
+        
+        void add(double k, double y);
+        void merge(const Segment& other, double beatOffset);
+        double getPeriod() const;
+        double getOrigin(double period) const;
+    };
+    
+    static std::vector<double> trackBeats(const std::vector<float>& envelope, double period);
+    static std::vector<Segment> findSegments(const std::vector<double>& beats, double period, double tolerance);
+    static int findDownbeat(const std::vector<float>& envelope, const Segment& segment, double period);
+};
@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+
+//==============================================================================
+/**
+    A flag that asks long-running work to stop, checked cooperatively between
+    blocks. Any thread may cancel; the thread doing the work polls it.
+
+    The reason tells the worker what to do with the interrupted job: on
+    shutdown and on preemption the job goes back to the queue untouched, since
+    neither says anything about the file itself.
+*/
+class CancellationToken
+{
+public:
+    enum class Reason
+    {
+        none,
+        shutdown,   // The application or worker pool is stopping
+        preempted   // A more urgent job needs this thread
+    };
+    
+    CancellationToken() = default;
+    
+    /** Ask the work to stop. The first reason given sticks until reset(). */
+    void cancel(Reason why)
+    {
+        int expected = (int) Reason::none;
+        reason.compare_exchange_strong(expected, (int) why);
+    }
+    
+    /** Clear the flag before starting the next piece of work. */
+    void reset()                    { reason = (int) Reason::none; }
+    
+    bool isCancelled() const        { return reason.load(std::memory_order_relaxed) != (int) Reason::none; }
+    Reason getReason() const        { return (Reason) reason.load(); }
+    
+    /** True if this token or the calling juce::Thread has been asked to stop. */
+    static bool shouldStop(const CancellationToken* token)
+    {
+        return (token != nullptr && token->isCancelled()) || juce::Thread::currentThreadShouldExit();
+    }
+
+private:
+    std::atomic<int> reason{(int) Reason::none};
+    
+    JUCE_DECLARE_NON_COPYABLE (CancellationToken)
+};
@@ -0,0 +1,382 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+
+#include <juce_core/juce_core.h>
+#include "DatabaseManager.h"
+#include "FileScanner.h"
+#include "AnalysisWorker.h"
+#include "RekordboxExporter.h"
+#include "TraktorExporter.h"
+#include "SeratoExporter.h"
+#include <iostream>
+#include <memory>
+
+//==============================================================================
+/*
+    Headless front end for building a library without the GUI, e.g. on a
+    fast server whose database is then copied to the DJ's machine.
+
+    Progress goes to stderr; stdout gets a single line of JSON summarising
+    the command, so scripts can parse it. Failures print it too, with an
+    "error" field. Exit code 0 means success, 1 that the command failed.
+*/
+namespace
+{
+    const char* const databaseOption = "--db";
+    constexpr int pollIntervalMs = 250;
+    constexpr int reportIntervalMs = 2000;
+
+    /** Same location as the GUI uses, unless --db=<file> was given. */
+    juce::File getDatabaseFile(const juce::ArgumentList& args)
+    {
+        if (args.containsOption(databaseOption))
+            return args.getFileForOption(databaseOption);
+        
+        return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                   .getChildFile("LibraryManager")
+                   .getChildFile("library.db");
+    }
+
+    juce::DynamicObject::Ptr createSummary(const juce::String& command, const juce::ArgumentList& args)
+    {
+        juce::DynamicObject::Ptr summary = new juce::DynamicObject();
+        summary->setProperty("command", command);
+        summary->setProperty("database", getDatabaseFile(args).getFullPathName());
+        return summary;
+    }
+
+    /**
+        Prints the summary to stdout, then fails with the error if there was one.
+        Commands create their summary up front with zero counts, so a failure
+        before any work was done still prints a complete line.
+    */
+    void finish(juce::DynamicObject::Ptr summary, juce::uint32 startTime, bool ok, const juce::String& error = {})
+    {
+        summary->setProperty("ok", ok);
+        summary->setProperty("seconds", (juce::Time::getMillisecondCounter() - startTime) / 1000.0);
+        
+        if (!ok)
+            summary->setProperty("error", error);
+        
+        std::cout << juce::JSON::toString(juce::var(summary.get()), true) << std::endl;
+        
+        if (!ok)
+            juce::ConsoleApplication::fail(error);
+    }
+
+    std::unique_ptr<DatabaseManager> openDatabase(const juce::ArgumentList& args, juce::DynamicObject::Ptr summary,
+                                                  juce::uint32 startTime)
+    {
+        auto dbFile = getDatabaseFile(args);
+        dbFile.getParentDirectory().createDirectory();
+        
+        auto db = std::make_unique<DatabaseManager>();
+        
+        if (!db->initialize(dbFile))
+            finish(summary, startTime, false, "Could not open database " + dbFile.getFullPathName()
+                                                  + ": " + db->getLastError());
+        
+        std::cerr << "Using database " << dbFile.getFullPathName() << std::endl;
+        return db;
+    }
+
+    /** Positional argument after the command name, e.g. the folder for scan. */
+    juce::String getPositionalArgument(const juce::ArgumentList& args, const juce::String& description,
+                                       juce::DynamicObject::Ptr summary, juce::uint32 startTime)
+    {
+        for (int i = 1; i < args.size(); ++i)
+        {
+            if (!args[i].isOption())
+                return args[i].text;
+        }
+        
+        finish(summary, startTime, false, "Missing " + description);
+        return {};
+    }
+
+    void reportExportProgress(const char* command, float progress)
+    {
+        std::cerr << "[" << command << "] " << juce::roundToInt(progress * 100.0f) << "%" << std::endl;
+    }
+
+    //==============================================================================
+    void runScan(const juce::ArgumentList& args)
+    {
+        const auto startTime = juce::Time::getMillisecondCounter();
+        const bool recursive = !args.containsOption("--no-recursive");
+        
+        auto summary = createSummary("scan", args);
+        summary->setProperty("recursive", recursive);
+        summary->setProperty("filesQueued", 0);
+        summary->setProperty("pendingJobs", 0);
+        
+        const juce::File folder = juce::File::getCurrentWorkingDirectory()
+                                      .getChildFile(getPositionalArgument(args, "folder to scan", summary, startTime));
+        summary->setProperty("folder", folder.getFullPathName());
+        
+        if (!folder.isDirectory())
+            finish(summary, startTime, false, "Not a folder: " + folder.getFullPathName());
+        
+        auto db = openDatabase(args, summary, startTime);
+        FileScanner scanner(*db);
+        
+        auto lastReport = startTime;
+        scanner.setProgressCallback([&lastReport](int current, int total)
+        {
+            const auto now = juce::Time::getMillisecondCounter();
+            
+            if (current == total || now - lastReport >= (juce::uint32) reportIntervalMs)
+            {
+                std::cerr << "[scan] " << current << " / " << total << " files" << std::endl;
+                lastReport = now;
+            }
+        });
+        
+        const int filesQueued = scanner.scanDirectory(folder, recursive);
+        
+        summary->setProperty("filesQueued", filesQueued);
+        summary->setProperty("pendingJobs", db->getJobCountByStatus("pending"));
+        
+        finish(summary, startTime, true);
+    }
+
+    //==============================================================================
+    void runAnalyze(const juce::ArgumentList& args)
+    {
+        const auto startTime = juce::Time::getMillisecondCounter();
+        int numThreads = 0;
+        
+        auto summary = createSummary("analyze", args);
+        summary->setProperty("threads", 0);
+        summary->setProperty("completed", 0);
+        summary->setProperty("failed", 0);
+        summary->setProperty("bytesProcessed", 0);
+        summary->setProperty("filesPerSecond", 0.0);
+        
+        if (args.containsOption("--threads"))
+        {
+            numThreads = args.getValueForOption("--threads").getIntValue();
+            
+            if (numThreads <= 0)
+                finish(summary, startTime, false, "--threads needs a positive number");
+        }
+        
+        auto db = openDatabase(args, summary, startTime);
+        AnalysisWorker worker(*db, numThreads);
+        
+        // Failures are worth a line each; everything else is summed up periodically
+        juce::CriticalSection outputLock;
+        worker.setProgressCallback([&outputLock](const AnalysisWorker::ProgressInfo& info)
+        {
+            if (info.errorMessage.isNotEmpty())
+            {
+                const juce::ScopedLock sl(outputLock);
+                std::cerr << "[analyze] Failed: " << info.filePath << ": " << info.errorMessage << std::endl;
+            }
+        });
+        
+        // Running jobs left by a crashed process come back once their lease expires
+        auto jobsLeft = [&db]
+        {
+            return db->getJobCountByStatus("pending") + db->getJobCountByStatus("running");
+        };
+        
+        std::cerr << "[analyze] " << jobsLeft() << " jobs queued, " << worker.getNumThreads() << " threads" << std::endl;
+        
+        worker.startWorker();
+        auto lastReport = juce::Time::getMillisecondCounter();
+        
+        while (jobsLeft() > 0)
+        {
+            juce::Thread::sleep(pollIntervalMs);
+            
+            const auto now = juce::Time::getMillisecondCounter();
+            
+            if (now - lastReport >= (juce::uint32) reportIntervalMs)
+            {
+                const auto rates = worker.getStats().getSnapshot();
+                const juce::ScopedLock sl(outputLock);
+                std::cerr << "[analyze] " << worker.getCompletedJobCount() << " done, "
+                          << worker.getFailedJobCount() << " failed, "
+                          << db->getJobCountByStatus("pending") << " pending, "
+                          << juce::String(rates.filesPerSecond, 1) << " files/s, "
+                          << juce::String(rates.megabytesPerSecond, 1) << " MB/s" << std::endl;
+                lastReport = now;
+            }
+        }
+        
+        worker.stopWorker();
+        
+        const auto snapshot = worker.getStats().getSnapshot();
+        const double seconds = (juce::Time::getMillisecondCounter() - startTime) / 1000.0;
+        
+        summary->setProperty("threads", worker.getNumThreads());
+        summary->setProperty("completed", worker.getCompletedJobCount());
+        summary->setProperty("failed", worker.getFailedJobCount());
+        summary->setProperty("bytesProcessed", snapshot.bytesProcessed);
+        summary->setProperty("filesPerSecond", seconds > 0.0 ? worker.getCompletedJobCount() / seconds : 0.0);
+        
+        // Mean time per stage, to spot the bottleneck on a new machine
+        juce::DynamicObject::Ptr stages = new juce::DynamicObject();
+        
+        for (int stage = 0; stage < AnalysisStats::numStages; ++stage)
+        {
+            const auto& stageSummary = snapshot.stages[(size_t) stage];
+            stages->setProperty(AnalysisStats::getStageName((AnalysisStats::Stage) stage), stageSummary.meanMs);
+        }
+        
+        summary->setProperty("meanStageMs", juce::var(stages.get()));
+        
+        finish(summary, startTime, true);
+    }
+
+    //==============================================================================
+    void runExportRekordbox(const juce::ArgumentList& args)
+    {
+        const auto startTime = juce::Time::getMillisecondCounter();
+        
+        auto summary = createSummary("export-rekordbox", args);
+        summary->setProperty("tracks", 0);
+        
+        const auto outputFile = juce::File::getCurrentWorkingDirectory()
+                                    .getChildFile(getPositionalArgument(args, "output XML file", summary, startTime));
+        summary->setProperty("output", outputFile.getFullPathName());
+        
+        auto db = openDatabase(args, summary, startTime);
+        RekordboxExporter exporter(*db);
+        exporter.setProgressCallback([](double progress, const juce::String& status)
+        {
+            std::cerr << "[export-rekordbox] " << juce::roundToInt(progress * 100.0) << "% " << status << std::endl;
+        });
+        
+        const bool ok = exporter.exportToXML(outputFile);
+        
+        summary->setProperty("tracks", (int) db->getAllTracks().size());
+        
+        finish(summary, startTime, ok, exporter.getLastError());
+    }
+
+    void runExportTraktor(const juce::ArgumentList& args)
+    {
+        const auto startTime = juce::Time::getMillisecondCounter();
+        
+        auto summary = createSummary("export-traktor", args);
+        summary->setProperty("tracks", 0);
+        
+        const auto outputFile = juce::File::getCurrentWorkingDirectory()
+                                    .getChildFile(getPositionalArgument(args, "output NML file", summary, startTime));
+        summary->setProperty("output", outputFile.getFullPathName());
+        
+        auto db = openDatabase(args, summary, startTime);
+        TraktorExporter exporter(*db);
+        
+        const bool ok = exporter.exportLibrary(outputFile, [](float progress)
+        {
+            reportExportProgress("export-traktor", progress);
+        });
+        
+        summary->setProperty("tracks", (int) db->getAllTracks().size());
+        
+        finish(summary, startTime, ok, exporter.getLastError());
+    }
+
+    void runExportSerato(const juce::ArgumentList& args)
+    {
+        const auto startTime = juce::Time::getMillisecondCounter();
+        
+        auto summary = createSummary("export-serato", args);
+        summary->setProperty("tracks", 0);
+        
+        const auto outputFolder = juce::File::getCurrentWorkingDirectory()
+                                      .getChildFile(getPositionalArgument(args, "output folder", summary, startTime));
+        summary->setProperty("output", outputFolder.getFullPathName());
+        
+        auto db = openDatabase(args, summary, startTime);
+        SeratoExporter exporter(*db);
+        
+        const bool ok = exporter.exportLibrary(outputFolder, [](float progress)
+        {
+            reportExportProgress("export-serato", progress);
+        });
+        
+        summary->setProperty("tracks", (int) db->getAllTracks().size());
+        
+        finish(summary, startTime, ok, exporter.getLastError());
+    }
+
+    //==============================================================================
+    void runDuplicates(const juce::ArgumentList& args)
+    {
+        const auto startTime = juce::Time::getMillisecondCounter();
+        
+        auto summary = createSummary("duplicates", args);
+        summary->setProperty("pairs", 0);
+        
+        auto db = openDatabase(args, summary, startTime);
+        juce::Array<juce::var> pairs;
+        
+        // Closest pairs first, as found by the analysis' fingerprint index
+        for (const auto& match : db->getAllDuplicateMatches())
+        {
+            juce::DynamicObject::Ptr pair = new juce::DynamicObject();
+            pair->setProperty("track", db->getTrack(match.trackId).filePath);
+            pair->setProperty("duplicate", db->getTrack(match.duplicateId).filePath);
+            pair->setProperty("bitErrorRate", match.bitErrorRate);
+            pairs.add(juce::var(pair.get()));
+        }
+        
+        summary->setProperty("pairs", pairs.size());
+        summary->setProperty("duplicates", pairs);
+        
+        finish(summary, startTime, true);
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ConsoleApplication app;
+    
+    app.addHelpCommand("--help|-h", "Usage: LibraryManagerCli <command> [--db=<library.db>] [options]", true);
+    app.addVersionCommand("--version|-v", "Library Manager CLI " + juce::String(JUCE_APPLICATION_VERSION_STRING));
+    
+    app.addCommand({ "scan", "scan <folder> [--no-recursive]",
+                     "Adds the audio files in a folder and queues them for analysis", {}, runScan });
+    
+    app.addCommand({ "analyze", "analyze [--threads=<n>]",
+                     "Analyses every queued file, then exits", {}, runAnalyze });
+    
+    app.addCommand({ "duplicates", "duplicates",
+                     "Lists the tracks analysis found to be copies of each other", {}, runDuplicates });
+    
+    app.addCommand({ "export-rekordbox", "export-rekordbox <file.xml>",
+                     "Writes the library as Rekordbox XML", {}, runExportRekordbox });
+    
+    app.addCommand({ "export-traktor", "export-traktor <file.nml>",
+                     "Writes the library as a Traktor NML collection", {}, runExportTraktor });
+    
+    app.addCommand({ "export-serato", "export-serato <folder>",
+                     "Writes the library and crates in Serato's format", {}, runExportSerato });
+    
+    return app.findAndRunCommand(argc, argv);
+}
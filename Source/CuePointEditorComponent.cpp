@@ -176,6 +176,9 @@ bool CuePointEditorComponent::loadTrack(int64_t trackId)
         return false;
     }
     
+    // If this track is still waiting for analysis, move it to the front of the queue
+    databaseManager.bumpJobPriority(currentTrack.filePath, DatabaseManager::jobPriorityInteractive);
+    
     // Load cue points
     cuePoints = databaseManager.getCuePointsForTrack(trackId);
     originalCuePoints = cuePoints;
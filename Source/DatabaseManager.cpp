@@ -21,6 +21,7 @@
 */
 
 #include "DatabaseManager.h"
+#include <cstring>
 
 //==============================================================================
 DatabaseManager::DatabaseManager()
@@ -61,9 +62,20 @@ bool DatabaseManager::initialize(const juce::File& databaseFile)
     
     logInfo("Database opened: " + databaseFile.getFullPathName());
     
+    // Watch for new work so idle workers can sleep until there is some
+    sqlite3_update_hook(db, onRowChanged, this);
+    sqlite3_commit_hook(db, onCommit, this);
+    sqlite3_rollback_hook(db, onRollback, this);
+    
     // Enable foreign keys
     executeSQL("PRAGMA foreign_keys = ON");
     
+    // WAL lets readers run during writes, and with synchronous=NORMAL a commit
+    // costs no fsync (only checkpoints do), which is what makes batched
+    // analysis writes cheap on spinning disks
+    executeSQL("PRAGMA journal_mode = WAL");
+    setDurability(Durability::normal);
+    
     // If database didn't exist or tables don't exist, create them
     if (!databaseExists || !checkTableExists("Tracks"))
     {
@@ -146,6 +158,165 @@ bool DatabaseManager::initialize(const juce::File& databaseFile)
                 }
             }
         }
+        
+        // Check if Tracks has the partial_hash prefilter column and add it if not
+        if (!checkColumnExists("Tracks", "partial_hash"))
+        {
+            logInfo("Adding partial_hash column to Tracks table...");
+            if (executeSQL("ALTER TABLE Tracks ADD COLUMN partial_hash TEXT"))
+            {
+                logInfo("Successfully added partial_hash column");
+            }
+            else
+            {
+                logError("initialize", "Failed to add partial_hash column");
+            }
+        }
+        
+        // Check if Tracks has the file_identity column used for move detection
+        if (!checkColumnExists("Tracks", "file_identity"))
+        {
+            logInfo("Adding file_identity column to Tracks table...");
+            if (executeSQL("ALTER TABLE Tracks ADD COLUMN file_identity TEXT"))
+            {
+                logInfo("Successfully added file_identity column");
+            }
+            else
+            {
+                logError("initialize", "Failed to add file_identity column");
+            }
+        }
+        
+        // Check if Tracks has the fractional tempo columns written by TempoAnalyser
+        if (!checkColumnExists("Tracks", "bpm_precise"))
+        {
+            logInfo("Adding bpm_precise and bpm_confidence columns to Tracks table...");
+            if (executeSQL("ALTER TABLE Tracks ADD COLUMN bpm_precise REAL DEFAULT 0.0") &&
+                executeSQL("ALTER TABLE Tracks ADD COLUMN bpm_confidence REAL DEFAULT 0.0"))
+            {
+                // Existing tempos were tagged or typed in, so treat them as certain
+                executeSQL("UPDATE Tracks SET bpm_precise = bpm, bpm_confidence = 1.0 WHERE bpm > 0");
+                logInfo("Successfully added tempo columns");
+            }
+            else
+            {
+                logError("initialize", "Failed to add tempo columns");
+            }
+        }
+        
+        // Check if Tracks has the loudness columns written by LoudnessAnalyser
+        if (!checkColumnExists("Tracks", "loudness_lufs"))
+        {
+            logInfo("Adding loudness columns to Tracks table...");
+            if (executeSQL("ALTER TABLE Tracks ADD COLUMN loudness_lufs REAL DEFAULT 0.0") &&
+                executeSQL("ALTER TABLE Tracks ADD COLUMN loudness_range REAL DEFAULT 0.0") &&
+                executeSQL("ALTER TABLE Tracks ADD COLUMN true_peak_db REAL DEFAULT 0.0") &&
+                executeSQL("ALTER TABLE Tracks ADD COLUMN album_gain_db REAL DEFAULT 0.0"))
+            {
+                logInfo("Successfully added loudness columns");
+            }
+            else
+            {
+                logError("initialize", "Failed to add loudness columns");
+            }
+        }
+        
+        executeSQL("CREATE INDEX IF NOT EXISTS idx_tracks_file_hash ON Tracks(file_hash)");
+        executeSQL("CREATE INDEX IF NOT EXISTS idx_tracks_partial_hash ON Tracks(partial_hash)");
+        executeSQL("CREATE INDEX IF NOT EXISTS idx_tracks_file_size ON Tracks(file_size)");
+        
+        // Waveform overviews were added after the original schema
+        if (!checkTableExists("WaveformOverviews"))
+        {
+            logInfo("Creating WaveformOverviews table...");
+            createWaveformOverviewsTable();
+        }
+        
+        if (!checkTableExists("BeatGrids"))
+        {
+            logInfo("Creating BeatGrids table...");
+            createBeatGridsTable();
+        }
+        
+        if (!checkTableExists("AnalysisCache"))
+        {
+            logInfo("Creating AnalysisCache table...");
+            createAnalysisCacheTable();
+        }
+        
+        if (!checkColumnExists("AnalysisCache", "audio_fingerprint"))
+        {
+            logInfo("Adding audio_fingerprint column to AnalysisCache table...");
+            
+            if (!executeSQL("ALTER TABLE AnalysisCache ADD COLUMN audio_fingerprint BLOB"))
+                logError("initialize", "Failed to add audio_fingerprint column");
+        }
+        
+        if (!checkTableExists("AudioFingerprints"))
+        {
+            logInfo("Creating AudioFingerprints table...");
+            createAudioFingerprintsTable();
+        }
+        
+        // Duplicates are looked up in the FingerprintIndex, never by duration
+        executeSQL("DROP INDEX IF EXISTS idx_audiofingerprints_duration");
+        
+        if (!checkTableExists("DuplicateMatches"))
+        {
+            logInfo("Creating DuplicateMatches table...");
+            createDuplicateMatchesTable();
+        }
+        
+        // Check if Jobs has a dedicated file_path column and add it if not
+        if (!checkColumnExists("Jobs", "file_path"))
+        {
+            logInfo("Adding file_path column to Jobs table...");
+            if (migrateJobsFilePath())
+            {
+                logInfo("Successfully added file_path column");
+            }
+            else
+            {
+                logError("initialize", "Failed to add file_path column to Jobs");
+            }
+        }
+        
+        // Check if Jobs has the scheduling priority column and add it if not
+        if (!checkColumnExists("Jobs", "priority"))
+        {
+            logInfo("Adding priority column to Jobs table...");
+            if (executeSQL("ALTER TABLE Jobs ADD COLUMN priority INTEGER NOT NULL DEFAULT 0"))
+            {
+                logInfo("Successfully added priority column");
+            }
+            else
+            {
+                logError("initialize", "Failed to add priority column to Jobs");
+            }
+        }
+        
+        executeSQL("CREATE INDEX IF NOT EXISTS idx_jobs_priority ON Jobs(status, priority DESC, id)");
+        
+        // Check if Jobs has the lease columns and add them if not
+        if (!checkColumnExists("Jobs", "lease_owner"))
+        {
+            logInfo("Adding lease columns to Jobs table...");
+            
+            // Running jobs from before leases are expired at once, so recovery picks them up
+            if (executeSQL("ALTER TABLE Jobs ADD COLUMN lease_owner TEXT") &&
+                executeSQL("ALTER TABLE Jobs ADD COLUMN lease_expires INTEGER") &&
+                executeSQL("ALTER TABLE Jobs ADD COLUMN attempts INTEGER NOT NULL DEFAULT 0") &&
+                executeSQL("UPDATE Jobs SET lease_expires=0 WHERE status='running'"))
+            {
+                logInfo("Successfully added lease columns");
+            }
+            else
+            {
+                logError("initialize", "Failed to add lease columns to Jobs");
+            }
+        }
+        
+        executeSQL("CREATE INDEX IF NOT EXISTS idx_jobs_lease ON Jobs(status, lease_expires)");
     }
     
     return true;
@@ -157,10 +328,12 @@ void DatabaseManager::close()
     
     if (db != nullptr)
     {
-        sqlite3_close(db);
+        sqlite3_close(db);  // Rolls back any open transaction
         db = nullptr;
         logInfo("Database closed");
     }
+    
+    releaseTransactionLock();
 }
 
 bool DatabaseManager::isOpen() const
@@ -186,9 +359,17 @@ bool DatabaseManager::createTables()
             duration REAL DEFAULT 0.0,
             file_size INTEGER DEFAULT 0,
             file_hash TEXT,
+            partial_hash TEXT,
+            file_identity TEXT,
             acoustid_fingerprint TEXT,
             date_added TEXT NOT NULL,
-            last_modified TEXT NOT NULL
+            last_modified TEXT NOT NULL,
+            bpm_precise REAL DEFAULT 0.0,
+            bpm_confidence REAL DEFAULT 0.0,
+            loudness_lufs REAL DEFAULT 0.0,
+            loudness_range REAL DEFAULT 0.0,
+            true_peak_db REAL DEFAULT 0.0,
+            album_gain_db REAL DEFAULT 0.0
         )
     )";
     
@@ -201,6 +382,9 @@ bool DatabaseManager::createTables()
     executeSQL("CREATE INDEX IF NOT EXISTS idx_tracks_genre ON Tracks(genre)");
     executeSQL("CREATE INDEX IF NOT EXISTS idx_tracks_bpm ON Tracks(bpm)");
     executeSQL("CREATE INDEX IF NOT EXISTS idx_tracks_key ON Tracks(key)");
+    executeSQL("CREATE INDEX IF NOT EXISTS idx_tracks_file_hash ON Tracks(file_hash)");
+    executeSQL("CREATE INDEX IF NOT EXISTS idx_tracks_partial_hash ON Tracks(partial_hash)");
+    executeSQL("CREATE INDEX IF NOT EXISTS idx_tracks_file_size ON Tracks(file_size)");
     
     // Create VirtualFolders table
     const char* createVirtualFoldersTable = R"(
@@ -241,12 +425,17 @@ bool DatabaseManager::createTables()
             id INTEGER PRIMARY KEY AUTOINCREMENT,
             job_type TEXT NOT NULL,
             status TEXT NOT NULL,
+            file_path TEXT,
             parameters TEXT,
             date_created TEXT NOT NULL,
             date_started TEXT,
             date_completed TEXT,
             error_message TEXT,
-            progress INTEGER DEFAULT 0
+            progress INTEGER DEFAULT 0,
+            priority INTEGER NOT NULL DEFAULT 0,
+            lease_owner TEXT,
+            lease_expires INTEGER,
+            attempts INTEGER NOT NULL DEFAULT 0
         )
     )";
     
@@ -255,6 +444,14 @@ bool DatabaseManager::createTables()
     
     executeSQL("CREATE INDEX IF NOT EXISTS idx_jobs_status ON Jobs(status)");
     executeSQL("CREATE INDEX IF NOT EXISTS idx_jobs_type ON Jobs(job_type)");
+    executeSQL("CREATE INDEX IF NOT EXISTS idx_jobs_priority ON Jobs(status, priority DESC, id)");
+    executeSQL("CREATE INDEX IF NOT EXISTS idx_jobs_lease ON Jobs(status, lease_expires)");
+    
+    // Only one pending/running job per file and job type; completed history is unconstrained
+    executeSQL(R"(
+        CREATE UNIQUE INDEX IF NOT EXISTS idx_jobs_active_file ON Jobs(job_type, file_path)
+        WHERE status IN ('pending', 'running') AND file_path IS NOT NULL
+    )");
     
     // Create CuePoints table
     const char* createCuePointsTable = R"(
@@ -276,6 +473,98 @@ bool DatabaseManager::createTables()
     
     executeSQL("CREATE INDEX IF NOT EXISTS idx_cuepoints_track ON CuePoints(track_id)");
     
+    return createWaveformOverviewsTable() && createBeatGridsTable() && createAnalysisCacheTable()
+        && createAudioFingerprintsTable() && createDuplicateMatchesTable();
+}
+
+bool DatabaseManager::createWaveformOverviewsTable()
+{
+    const char* createWaveformOverviewsTable = R"(
+        CREATE TABLE IF NOT EXISTS WaveformOverviews (
+            track_id INTEGER PRIMARY KEY,
+            duration REAL NOT NULL,
+            num_bins INTEGER NOT NULL,
+            data BLOB NOT NULL,
+            FOREIGN KEY (track_id) REFERENCES Tracks(id) ON DELETE CASCADE
+        )
+    )";
+    
+    return executeSQL(createWaveformOverviewsTable);
+}
+
+bool DatabaseManager::createBeatGridsTable()
+{
+    const char* createBeatGridsTable = R"(
+        CREATE TABLE IF NOT EXISTS BeatGrids (
+            track_id INTEGER PRIMARY KEY,
+            num_markers INTEGER NOT NULL,
+            data BLOB NOT NULL,
+            FOREIGN KEY (track_id) REFERENCES Tracks(id) ON DELETE CASCADE
+        )
+    )";
+    
+    return executeSQL(createBeatGridsTable);
+}
+
+bool DatabaseManager::createAnalysisCacheTable()
+{
+    // Keyed by audio content rather than by track, so it outlives the tracks it was made for
+    const char* createAnalysisCacheTable = R"(
+        CREATE TABLE IF NOT EXISTS AnalysisCache (
+            audio_hash TEXT PRIMARY KEY,
+            version INTEGER NOT NULL,
+            duration REAL,
+            fingerprint TEXT,
+            bpm REAL,
+            bpm_confidence REAL,
+            musical_key TEXT,
+            loudness_lufs REAL,
+            loudness_range REAL,
+            true_peak_db REAL,
+            waveform BLOB,
+            grid_bpm REAL,
+            beat_grid BLOB,
+            date_added TEXT,
+            audio_fingerprint BLOB
+        )
+    )";
+    
+    return executeSQL(createAnalysisCacheTable);
+}
+
+bool DatabaseManager::createAudioFingerprintsTable()
+{
+    const char* createAudioFingerprintsTable = R"(
+        CREATE TABLE IF NOT EXISTS AudioFingerprints (
+            track_id INTEGER PRIMARY KEY,
+            duration REAL NOT NULL,
+            num_frames INTEGER NOT NULL,
+            data BLOB NOT NULL,
+            FOREIGN KEY (track_id) REFERENCES Tracks(id) ON DELETE CASCADE
+        )
+    )";
+    
+    return executeSQL(createAudioFingerprintsTable);
+}
+
+bool DatabaseManager::createDuplicateMatchesTable()
+{
+    // One row per pair, lower track id first, so finding it from either side cannot store it twice
+    const char* createDuplicateMatchesTable = R"(
+        CREATE TABLE IF NOT EXISTS DuplicateMatches (
+            track_id INTEGER NOT NULL,
+            duplicate_id INTEGER NOT NULL,
+            bit_error_rate REAL NOT NULL,
+            PRIMARY KEY (track_id, duplicate_id),
+            FOREIGN KEY (track_id) REFERENCES Tracks(id) ON DELETE CASCADE,
+            FOREIGN KEY (duplicate_id) REFERENCES Tracks(id) ON DELETE CASCADE
+        )
+    )";
+    
+    if (!executeSQL(createDuplicateMatchesTable))
+        return false;
+    
+    executeSQL("CREATE INDEX IF NOT EXISTS idx_duplicatematches_duplicate ON DuplicateMatches(duplicate_id)");
     return true;
 }
 
@@ -328,9 +617,177 @@ bool DatabaseManager::checkTableExists(const juce::String& tableName) const
     return exists;
 }
 
+bool DatabaseManager::checkColumnExists(const juce::String& tableName, const juce::String& columnName) const
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    if (!isOpen())
+        return false;
+    
+    juce::String sql = "PRAGMA table_info(" + tableName + ")";
+    sqlite3_stmt* stmt = nullptr;
+    
+    if (sqlite3_prepare_v2(db, sql.toRawUTF8(), -1, &stmt, nullptr) != SQLITE_OK)
+        return false;
+    
+    bool exists = false;
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        const char* name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        if (name && juce::String(name) == columnName)
+        {
+            exists = true;
+            break;
+        }
+    }
+    
+    sqlite3_finalize(stmt);
+    return exists;
+}
+
+bool DatabaseManager::migrateJobsFilePath()
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    // The column is added in the same transaction, so a failed migration leaves no
+    // trace and is retried on the next start
+    if (!beginTransaction())
+        return false;
+    
+    if (!executeSQL("ALTER TABLE Jobs ADD COLUMN file_path TEXT"))
+    {
+        rollbackTransaction();
+        return false;
+    }
+    
+    // Backfill file_path from the JSON parameters of existing jobs
+    std::vector<std::pair<int64_t, juce::String>> backfill;
+    {
+        sqlite3_stmt* stmt = nullptr;
+        const char* sql = "SELECT id, parameters FROM Jobs WHERE file_path IS NULL";
+        
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK)
+        {
+            while (sqlite3_step(stmt) == SQLITE_ROW)
+            {
+                const char* paramsText = (const char*)sqlite3_column_text(stmt, 1);
+                if (paramsText == nullptr)
+                    continue;
+                
+                auto params = juce::JSON::parse(juce::String(juce::CharPointer_UTF8(paramsText)));
+                if (auto* paramsObj = params.getDynamicObject())
+                {
+                    auto path = paramsObj->getProperty("file_path").toString();
+                    if (path.isNotEmpty())
+                        backfill.push_back({ sqlite3_column_int64(stmt, 0), path });
+                }
+            }
+            
+            sqlite3_finalize(stmt);
+        }
+    }
+    
+    {
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db, "UPDATE Jobs SET file_path=? WHERE id=?", -1, &stmt, nullptr) == SQLITE_OK)
+        {
+            for (const auto& entry : backfill)
+            {
+                sqlite3_bind_text(stmt, 1, entry.second.toRawUTF8(), -1, SQLITE_TRANSIENT);
+                sqlite3_bind_int64(stmt, 2, entry.first);
+                sqlite3_step(stmt);
+                sqlite3_reset(stmt);
+            }
+            
+            sqlite3_finalize(stmt);
+        }
+    }
+    
+    // Drop duplicate active work so the unique index can be created: per file keep one
+    // job, a running one if there is any, otherwise the oldest
+    if (!executeSQL(R"(
+        DELETE FROM Jobs WHERE status IN ('pending', 'running') AND file_path IS NOT NULL AND id <> (
+            SELECT k.id FROM Jobs k
+            WHERE k.status IN ('pending', 'running') AND k.job_type=Jobs.job_type AND k.file_path=Jobs.file_path
+            ORDER BY k.status='running' DESC, k.id
+            LIMIT 1)
+    )") || !executeSQL(R"(
+        CREATE UNIQUE INDEX IF NOT EXISTS idx_jobs_active_file ON Jobs(job_type, file_path)
+        WHERE status IN ('pending', 'running') AND file_path IS NOT NULL
+    )"))
+    {
+        rollbackTransaction();
+        return false;
+    }
+    
+    if (!commitTransaction())
+    {
+        rollbackTransaction();
+        return false;
+    }
+    
+    logInfo("Backfilled file_path for " + juce::String((int)backfill.size()) + " jobs");
+    return true;
+}
+
 //==============================================================================
 // CRUD operations for Tracks
 
+juce::String DatabaseManager::trackColumns(const juce::String& tableAlias)
+{
+    static const juce::StringArray columns {
+        "id", "file_path", "title", "artist", "album", "genre", "bpm", "key",
+        "duration", "file_size", "file_hash", "partial_hash", "file_identity",
+        "acoustid_fingerprint", "date_added", "last_modified", "bpm_precise",
+        "bpm_confidence", "loudness_lufs", "loudness_range", "true_peak_db",
+        "album_gain_db"
+    };
+    
+    if (tableAlias.isEmpty())
+        return columns.joinIntoString(", ");
+    
+    juce::StringArray qualified;
+    for (const auto& column : columns)
+        qualified.add(tableAlias + "." + column);
+    
+    return qualified.joinIntoString(", ");
+}
+
+DatabaseManager::Track DatabaseManager::readTrackRow(sqlite3_stmt* stmt)
+{
+    auto text = [stmt](int column)
+    {
+        const char* val = (const char*)sqlite3_column_text(stmt, column);
+        return val ? juce::String(juce::CharPointer_UTF8(val)) : juce::String();
+    };
+    
+    Track track;
+    track.id = sqlite3_column_int64(stmt, 0);
+    track.filePath = text(1);
+    track.title = text(2);
+    track.artist = text(3);
+    track.album = text(4);
+    track.genre = text(5);
+    track.bpm = sqlite3_column_int(stmt, 6);
+    track.key = text(7);
+    track.duration = sqlite3_column_double(stmt, 8);
+    track.fileSize = sqlite3_column_int64(stmt, 9);
+    track.fileHash = text(10);
+    track.partialHash = text(11);
+    track.fileIdentity = text(12);
+    track.acoustidFingerprint = text(13);
+    track.dateAdded = stringToTime(text(14));
+    track.lastModified = stringToTime(text(15));
+    track.bpmPrecise = sqlite3_column_double(stmt, 16);
+    track.bpmConfidence = sqlite3_column_double(stmt, 17);
+    track.loudnessLufs = sqlite3_column_double(stmt, 18);
+    track.loudnessRange = sqlite3_column_double(stmt, 19);
+    track.truePeakDb = sqlite3_column_double(stmt, 20);
+    track.albumGainDb = sqlite3_column_double(stmt, 21);
+    return track;
+}
+
 bool DatabaseManager::addTrack(const Track& track, int64_t& outId)
 {
     const juce::ScopedLock lock(dbMutex);
@@ -343,8 +800,11 @@ bool DatabaseManager::addTrack(const Track& track, int64_t& outId)
     
     const char* sql = R"(
         INSERT INTO Tracks (file_path, title, artist, album, genre, bpm, key, 
-                          duration, file_size, file_hash, acoustid_fingerprint, date_added, last_modified)
-        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+                          duration, file_size, file_hash, partial_hash, file_identity,
+                          acoustid_fingerprint, date_added, last_modified,
+                          bpm_precise, bpm_confidence, loudness_lufs, loudness_range,
+                          true_peak_db, album_gain_db)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
     )";
     
     sqlite3_stmt* stmt = nullptr;
@@ -367,9 +827,17 @@ bool DatabaseManager::addTrack(const Track& track, int64_t& outId)
     sqlite3_bind_double(stmt, 8, track.duration);
     sqlite3_bind_int64(stmt, 9, track.fileSize);
     sqlite3_bind_text(stmt, 10, track.fileHash.toRawUTF8(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 11, track.acoustidFingerprint.toRawUTF8(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 12, timeToString(track.dateAdded).toRawUTF8(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 13, timeToString(track.lastModified).toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 11, track.partialHash.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 12, track.fileIdentity.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 13, track.acoustidFingerprint.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 14, timeToString(track.dateAdded).toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 15, timeToString(track.lastModified).toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_double(stmt, 16, track.bpmPrecise);
+    sqlite3_bind_double(stmt, 17, track.bpmConfidence);
+    sqlite3_bind_double(stmt, 18, track.loudnessLufs);
+    sqlite3_bind_double(stmt, 19, track.loudnessRange);
+    sqlite3_bind_double(stmt, 20, track.truePeakDb);
+    sqlite3_bind_double(stmt, 21, track.albumGainDb);
     
     result = sqlite3_step(stmt);
     
@@ -400,7 +868,10 @@ bool DatabaseManager::updateTrack(const Track& track)
     
     const char* sql = R"(
         UPDATE Tracks SET file_path=?, title=?, artist=?, album=?, genre=?, bpm=?, 
-                         key=?, duration=?, file_size=?, file_hash=?, acoustid_fingerprint=?, last_modified=?
+                         key=?, duration=?, file_size=?, file_hash=?, partial_hash=?,
+                         file_identity=?, acoustid_fingerprint=?, last_modified=?,
+                         bpm_precise=?, bpm_confidence=?, loudness_lufs=?, loudness_range=?,
+                         true_peak_db=?, album_gain_db=?
         WHERE id=?
     )";
     
@@ -424,9 +895,17 @@ bool DatabaseManager::updateTrack(const Track& track)
     sqlite3_bind_double(stmt, 8, track.duration);
     sqlite3_bind_int64(stmt, 9, track.fileSize);
     sqlite3_bind_text(stmt, 10, track.fileHash.toRawUTF8(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 11, track.acoustidFingerprint.toRawUTF8(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 12, timeToString(track.lastModified).toRawUTF8(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int64(stmt, 13, track.id);
+    sqlite3_bind_text(stmt, 11, track.partialHash.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 12, track.fileIdentity.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 13, track.acoustidFingerprint.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 14, timeToString(track.lastModified).toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_double(stmt, 15, track.bpmPrecise);
+    sqlite3_bind_double(stmt, 16, track.bpmConfidence);
+    sqlite3_bind_double(stmt, 17, track.loudnessLufs);
+    sqlite3_bind_double(stmt, 18, track.loudnessRange);
+    sqlite3_bind_double(stmt, 19, track.truePeakDb);
+    sqlite3_bind_double(stmt, 20, track.albumGainDb);
+    sqlite3_bind_int64(stmt, 21, track.id);
     
     result = sqlite3_step(stmt);
     
@@ -489,14 +968,10 @@ DatabaseManager::Track DatabaseManager::getTrack(int64_t trackId) const
     if (!isOpen())
         return track;
     
-    const char* sql = R"(
-        SELECT id, file_path, title, artist, album, genre, bpm, key, 
-               duration, file_size, file_hash, acoustid_fingerprint, date_added, last_modified
-        FROM Tracks WHERE id=?
-    )";
+    juce::String sql = "SELECT " + trackColumns() + " FROM Tracks WHERE id=?";
     
     sqlite3_stmt* stmt = nullptr;
-    int result = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+    int result = sqlite3_prepare_v2(db, sql.toRawUTF8(), -1, &stmt, nullptr);
     
     if (result != SQLITE_OK)
         return track;
@@ -504,52 +979,7 @@ DatabaseManager::Track DatabaseManager::getTrack(int64_t trackId) const
     sqlite3_bind_int64(stmt, 1, trackId);
     
     if (sqlite3_step(stmt) == SQLITE_ROW)
-    {
-        track.id = sqlite3_column_int64(stmt, 0);
-        {
-            const char* val = (const char*)sqlite3_column_text(stmt, 1);
-            track.filePath = val ? juce::CharPointer_UTF8(val) : juce::String();
-        }
-        {
-            const char* val = (const char*)sqlite3_column_text(stmt, 2);
-            track.title = val ? juce::CharPointer_UTF8(val) : juce::String();
-        }
-        {
-            const char* val = (const char*)sqlite3_column_text(stmt, 3);
-            track.artist = val ? juce::CharPointer_UTF8(val) : juce::String();
-        }
-        {
-            const char* val = (const char*)sqlite3_column_text(stmt, 4);
-            track.album = val ? juce::CharPointer_UTF8(val) : juce::String();
-        }
-        {
-            const char* val = (const char*)sqlite3_column_text(stmt, 5);
-            track.genre = val ? juce::CharPointer_UTF8(val) : juce::String();
-        }
-        track.bpm = sqlite3_column_int(stmt, 6);
-        {
-            const char* val = (const char*)sqlite3_column_text(stmt, 7);
-            track.key = val ? juce::CharPointer_UTF8(val) : juce::String();
-        }
-        track.duration = sqlite3_column_double(stmt, 8);
-        track.fileSize = sqlite3_column_int64(stmt, 9);
-        {
-            const char* val = (const char*)sqlite3_column_text(stmt, 10);
-            track.fileHash = val ? juce::CharPointer_UTF8(val) : juce::String();
-        }
-        {
-            const char* val = (const char*)sqlite3_column_text(stmt, 11);
-            track.acoustidFingerprint = val ? juce::CharPointer_UTF8(val) : juce::String();
-        }
-        {
-            const char* val = (const char*)sqlite3_column_text(stmt, 12);
-            track.dateAdded = stringToTime(val ? juce::CharPointer_UTF8(val) : juce::String());
-        }
-        {
-            const char* val = (const char*)sqlite3_column_text(stmt, 13);
-            track.lastModified = stringToTime(val ? juce::CharPointer_UTF8(val) : juce::String());
-        }
-    }
+        track = readTrackRow(stmt);
     
     sqlite3_finalize(stmt);
     return track;
@@ -564,36 +994,17 @@ std::vector<DatabaseManager::Track> DatabaseManager::getAllTracks() const
     if (!isOpen())
         return tracks;
     
-    const char* sql = R"(
-        SELECT id, file_path, title, artist, album, genre, bpm, key, 
-               duration, file_size, file_hash, acoustid_fingerprint, date_added, last_modified
-        FROM Tracks ORDER BY title
-    )";
+    juce::String sql = "SELECT " + trackColumns() + " FROM Tracks ORDER BY title";
     
     sqlite3_stmt* stmt = nullptr;
-    int result = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+    int result = sqlite3_prepare_v2(db, sql.toRawUTF8(), -1, &stmt, nullptr);
     
     if (result != SQLITE_OK)
         return tracks;
     
     while (sqlite3_step(stmt) == SQLITE_ROW)
     {
-        Track track;
-        track.id = sqlite3_column_int64(stmt, 0);
-        track.filePath = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 1));
-        track.title = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 2));
-        track.artist = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 3));
-        track.album = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 4));
-        track.genre = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 5));
-        track.bpm = sqlite3_column_int(stmt, 6);
-        track.key = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 7));
-        track.duration = sqlite3_column_double(stmt, 8);
-        track.fileSize = sqlite3_column_int64(stmt, 9);
-        track.fileHash = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 10));
-        track.acoustidFingerprint = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 11));
-        track.dateAdded = stringToTime(juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 12)));
-        track.lastModified = stringToTime(juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 13)));
-        tracks.push_back(track);
+        tracks.push_back(readTrackRow(stmt));
     }
     
     sqlite3_finalize(stmt);
@@ -609,16 +1020,14 @@ std::vector<DatabaseManager::Track> DatabaseManager::searchTracks(const juce::St
     if (!isOpen())
         return tracks;
     
-    const char* sql = R"(
-        SELECT id, file_path, title, artist, album, genre, bpm, key, 
-               duration, file_size, file_hash, acoustid_fingerprint, date_added, last_modified
+    juce::String sql = "SELECT " + trackColumns() + R"(
         FROM Tracks 
         WHERE title LIKE ? OR artist LIKE ? OR album LIKE ? OR genre LIKE ?
         ORDER BY title
     )";
     
     sqlite3_stmt* stmt = nullptr;
-    int result = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+    int result = sqlite3_prepare_v2(db, sql.toRawUTF8(), -1, &stmt, nullptr);
     
     if (result != SQLITE_OK)
         return tracks;
@@ -631,22 +1040,7 @@ std::vector<DatabaseManager::Track> DatabaseManager::searchTracks(const juce::St
     
     while (sqlite3_step(stmt) == SQLITE_ROW)
     {
-        Track track;
-        track.id = sqlite3_column_int64(stmt, 0);
-        track.filePath = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 1));
-        track.title = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 2));
-        track.artist = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 3));
-        track.album = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 4));
-        track.genre = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 5));
-        track.bpm = sqlite3_column_int(stmt, 6);
-        track.key = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 7));
-        track.duration = sqlite3_column_double(stmt, 8);
-        track.fileSize = sqlite3_column_int64(stmt, 9);
-        track.fileHash = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 10));
-        track.acoustidFingerprint = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 11));
-        track.dateAdded = stringToTime(juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 12)));
-        track.lastModified = stringToTime(juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 13)));
-        tracks.push_back(track);
+        tracks.push_back(readTrackRow(stmt));
     }
     
     sqlite3_finalize(stmt);
@@ -662,16 +1056,14 @@ std::vector<DatabaseManager::Track> DatabaseManager::findTracksByFingerprint(con
     if (!isOpen() || fingerprint.isEmpty())
         return tracks;
     
-    const char* sql = R"(
-        SELECT id, file_path, title, artist, album, genre, bpm, key, 
-               duration, file_size, file_hash, acoustid_fingerprint, date_added, last_modified
+    juce::String sql = "SELECT " + trackColumns() + R"(
         FROM Tracks 
         WHERE acoustid_fingerprint = ?
         ORDER BY title
     )";
     
     sqlite3_stmt* stmt = nullptr;
-    int result = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+    int result = sqlite3_prepare_v2(db, sql.toRawUTF8(), -1, &stmt, nullptr);
     
     if (result != SQLITE_OK)
         return tracks;
@@ -680,63 +1072,273 @@ std::vector<DatabaseManager::Track> DatabaseManager::findTracksByFingerprint(con
     
     while (sqlite3_step(stmt) == SQLITE_ROW)
     {
-        Track track;
-        track.id = sqlite3_column_int64(stmt, 0);
-        track.filePath = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 1));
-        track.title = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 2));
-        track.artist = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 3));
-        track.album = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 4));
-        track.genre = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 5));
-        track.bpm = sqlite3_column_int(stmt, 6);
-        track.key = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 7));
-        track.duration = sqlite3_column_double(stmt, 8);
-        track.fileSize = sqlite3_column_int64(stmt, 9);
-        track.fileHash = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 10));
-        track.acoustidFingerprint = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 11));
-        track.dateAdded = stringToTime(juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 12)));
-        track.lastModified = stringToTime(juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 13)));
-        tracks.push_back(track);
+        tracks.push_back(readTrackRow(stmt));
     }
     
     sqlite3_finalize(stmt);
     return tracks;
 }
 
-//==============================================================================
-// CRUD operations for VirtualFolders
-
-bool DatabaseManager::addVirtualFolder(const VirtualFolder& folder, int64_t& outId)
+std::vector<DatabaseManager::Track> DatabaseManager::findTracksByFileHash(const juce::String& fileHash,
+                                                                          bool partial) const
 {
     const juce::ScopedLock lock(dbMutex);
     
-    if (!isOpen())
-    {
-        lastError = "Database is not open";
-        return false;
-    }
+    std::vector<Track> tracks;
     
-    const char* sql = R"(
-        INSERT INTO VirtualFolders (name, description, date_created, is_smart_playlist, smart_criteria)
-        VALUES (?, ?, ?, ?, ?)
-    )";
+    if (!isOpen() || fileHash.isEmpty())
+        return tracks;
+    
+    juce::String sql = "SELECT " + trackColumns() + " FROM Tracks WHERE "
+                     + (partial ? "partial_hash" : "file_hash") + " = ? ORDER BY title";
     
     sqlite3_stmt* stmt = nullptr;
-    int result = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+    int result = sqlite3_prepare_v2(db, sql.toRawUTF8(), -1, &stmt, nullptr);
     
     if (result != SQLITE_OK)
-    {
-        lastError = juce::String("Failed to prepare statement: ") + sqlite3_errmsg(db);
-        logError("addVirtualFolder", lastError);
-        return false;
-    }
+        return tracks;
     
-    sqlite3_bind_text(stmt, 1, folder.name.toRawUTF8(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, folder.description.toRawUTF8(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, timeToString(folder.dateCreated).toRawUTF8(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 4, folder.isSmartPlaylist ? 1 : 0);
-    sqlite3_bind_text(stmt, 5, folder.smartCriteria.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 1, fileHash.toRawUTF8(), -1, SQLITE_TRANSIENT);
     
-    result = sqlite3_step(stmt);
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+        tracks.push_back(readTrackRow(stmt));
+    
+    sqlite3_finalize(stmt);
+    return tracks;
+}
+
+DatabaseManager::Track DatabaseManager::getTrackByPath(const juce::String& filePath) const
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    Track track;
+    
+    if (!isOpen() || filePath.isEmpty())
+        return track;
+    
+    juce::String sql = "SELECT " + trackColumns() + " FROM Tracks WHERE file_path=?";
+    
+    sqlite3_stmt* stmt = nullptr;
+    int result = sqlite3_prepare_v2(db, sql.toRawUTF8(), -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK)
+        return track;
+    
+    sqlite3_bind_text(stmt, 1, filePath.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+        track = readTrackRow(stmt);
+    
+    sqlite3_finalize(stmt);
+    return track;
+}
+
+// Matches the files directly inside folder ?3 (given with its trailing separator ?4)
+static const char* albumFolderCondition =
+    "album=?2 AND substr(file_path, 1, length(?3))=?3 AND instr(substr(file_path, length(?3) + 1), ?4)=0";
+
+std::vector<DatabaseManager::Track> DatabaseManager::getTracksByAlbum(const juce::String& album,
+                                                                      const juce::String& folder) const
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    std::vector<Track> tracks;
+    
+    if (!isOpen() || album.isEmpty())
+        return tracks;
+    
+    juce::String sql = "SELECT " + trackColumns() + " FROM Tracks WHERE " + albumFolderCondition;
+    
+    sqlite3_stmt* stmt = nullptr;
+    int result = sqlite3_prepare_v2(db, sql.toRawUTF8(), -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK)
+        return tracks;
+    
+    const auto separator = juce::File::getSeparatorString();
+    sqlite3_bind_text(stmt, 2, album.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 3, (folder.trimCharactersAtEnd(separator) + separator).toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 4, separator.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+        tracks.push_back(readTrackRow(stmt));
+    
+    sqlite3_finalize(stmt);
+    return tracks;
+}
+
+bool DatabaseManager::setAlbumGain(const juce::String& album, const juce::String& folder, double gainDb)
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    if (!isOpen())
+    {
+        lastError = "Database is not open";
+        return false;
+    }
+    
+    juce::String sql = juce::String("UPDATE Tracks SET album_gain_db=?1 WHERE ") + albumFolderCondition
+                       + " AND loudness_lufs < 0";
+    
+    sqlite3_stmt* stmt = nullptr;
+    int result = sqlite3_prepare_v2(db, sql.toRawUTF8(), -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK)
+    {
+        lastError = juce::String("Failed to prepare statement: ") + sqlite3_errmsg(db);
+        logError("setAlbumGain", lastError);
+        return false;
+    }
+    
+    const auto separator = juce::File::getSeparatorString();
+    sqlite3_bind_double(stmt, 1, gainDb);
+    sqlite3_bind_text(stmt, 2, album.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 3, (folder.trimCharactersAtEnd(separator) + separator).toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 4, separator.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    
+    result = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    
+    if (result != SQLITE_DONE)
+    {
+        lastError = juce::String("Failed to set album gain: ") + sqlite3_errmsg(db);
+        logError("setAlbumGain", lastError);
+        return false;
+    }
+    
+    return true;
+}
+
+std::vector<DatabaseManager::TrackLocation> DatabaseManager::getTrackLocations() const
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    std::vector<TrackLocation> locations;
+    
+    if (!isOpen())
+        return locations;
+    
+    const char* sql = "SELECT id, file_path, file_size, file_identity, partial_hash FROM Tracks";
+    
+    sqlite3_stmt* stmt = nullptr;
+    int result = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK)
+        return locations;
+    
+    auto text = [stmt](int column)
+    {
+        const char* val = (const char*)sqlite3_column_text(stmt, column);
+        return val ? juce::String(juce::CharPointer_UTF8(val)) : juce::String();
+    };
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        TrackLocation location;
+        location.id = sqlite3_column_int64(stmt, 0);
+        location.filePath = text(1);
+        location.fileSize = sqlite3_column_int64(stmt, 2);
+        location.fileIdentity = text(3);
+        location.partialHash = text(4);
+        locations.push_back(location);
+    }
+    
+    sqlite3_finalize(stmt);
+    return locations;
+}
+
+bool DatabaseManager::relinkTrack(int64_t trackId, const juce::String& newFilePath,
+                                  const juce::String& fileIdentity)
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    if (!isOpen())
+    {
+        lastError = "Database is not open";
+        return false;
+    }
+    
+    const auto oldFilePath = getTrack(trackId).filePath;
+    
+    const char* sql = "UPDATE Tracks SET file_path=?, file_identity=? WHERE id=?";
+    
+    sqlite3_stmt* stmt = nullptr;
+    int result = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK)
+    {
+        lastError = juce::String("Failed to prepare statement: ") + sqlite3_errmsg(db);
+        logError("relinkTrack", lastError);
+        return false;
+    }
+    
+    sqlite3_bind_text(stmt, 1, newFilePath.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, fileIdentity.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 3, trackId);
+    
+    result = sqlite3_step(stmt);
+    
+    if (result != SQLITE_DONE)
+    {
+        lastError = juce::String("Failed to relink track: ") + sqlite3_errmsg(db);
+        logError("relinkTrack", lastError);
+        sqlite3_finalize(stmt);
+        return false;
+    }
+    
+    sqlite3_finalize(stmt);
+    
+    // Jobs still queued for the old path would only fail, or add the track a second time
+    if (oldFilePath.isNotEmpty() && oldFilePath != newFilePath
+        && sqlite3_prepare_v2(db, "DELETE FROM Jobs WHERE file_path=? AND status='pending'", -1, &stmt, nullptr) == SQLITE_OK)
+    {
+        sqlite3_bind_text(stmt, 1, oldFilePath.toRawUTF8(), -1, SQLITE_TRANSIENT);
+        
+        if (sqlite3_step(stmt) != SQLITE_DONE)
+            logError("relinkTrack", juce::String("Failed to remove jobs for the old path: ") + sqlite3_errmsg(db));
+        
+        sqlite3_finalize(stmt);
+    }
+    
+    logInfo("Track " + juce::String(trackId) + " relinked to: " + newFilePath);
+    return true;
+}
+
+//==============================================================================
+// CRUD operations for VirtualFolders
+
+bool DatabaseManager::addVirtualFolder(const VirtualFolder& folder, int64_t& outId)
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    if (!isOpen())
+    {
+        lastError = "Database is not open";
+        return false;
+    }
+    
+    const char* sql = R"(
+        INSERT INTO VirtualFolders (name, description, date_created, is_smart_playlist, smart_criteria)
+        VALUES (?, ?, ?, ?, ?)
+    )";
+    
+    sqlite3_stmt* stmt = nullptr;
+    int result = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK)
+    {
+        lastError = juce::String("Failed to prepare statement: ") + sqlite3_errmsg(db);
+        logError("addVirtualFolder", lastError);
+        return false;
+    }
+    
+    sqlite3_bind_text(stmt, 1, folder.name.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, folder.description.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 3, timeToString(folder.dateCreated).toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 4, folder.isSmartPlaylist ? 1 : 0);
+    sqlite3_bind_text(stmt, 5, folder.smartCriteria.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    
+    result = sqlite3_step(stmt);
     
     if (result != SQLITE_DONE)
     {
@@ -1085,9 +1687,7 @@ std::vector<DatabaseManager::Track> DatabaseManager::getTracksInFolder(int64_t f
     if (!isOpen())
         return tracks;
     
-    const char* sql = R"(
-        SELECT t.id, t.file_path, t.title, t.artist, t.album, t.genre, t.bpm, t.key, 
-               t.duration, t.file_size, t.file_hash, t.acoustid_fingerprint, t.date_added, t.last_modified
+    juce::String sql = "SELECT " + trackColumns("t") + R"(
         FROM Tracks t
         INNER JOIN Folder_Tracks_Link ftl ON t.id = ftl.track_id
         WHERE ftl.folder_id = ?
@@ -1095,7 +1695,7 @@ std::vector<DatabaseManager::Track> DatabaseManager::getTracksInFolder(int64_t f
     )";
     
     sqlite3_stmt* stmt = nullptr;
-    int result = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+    int result = sqlite3_prepare_v2(db, sql.toRawUTF8(), -1, &stmt, nullptr);
     
     if (result != SQLITE_OK)
         return tracks;
@@ -1104,22 +1704,7 @@ std::vector<DatabaseManager::Track> DatabaseManager::getTracksInFolder(int64_t f
     
     while (sqlite3_step(stmt) == SQLITE_ROW)
     {
-        Track track;
-        track.id = sqlite3_column_int64(stmt, 0);
-        track.filePath = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 1));
-        track.title = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 2));
-        track.artist = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 3));
-        track.album = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 4));
-        track.genre = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 5));
-        track.bpm = sqlite3_column_int(stmt, 6);
-        track.key = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 7));
-        track.duration = sqlite3_column_double(stmt, 8);
-        track.fileSize = sqlite3_column_int64(stmt, 9);
-        track.fileHash = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 10));
-        track.acoustidFingerprint = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 11));
-        track.dateAdded = stringToTime(juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 12)));
-        track.lastModified = stringToTime(juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 13)));
-        tracks.push_back(track);
+        tracks.push_back(readTrackRow(stmt));
     }
     
     sqlite3_finalize(stmt);
@@ -1168,24 +1753,75 @@ std::vector<DatabaseManager::VirtualFolder> DatabaseManager::getFoldersForTrack(
 //==============================================================================
 // CRUD operations for Jobs
 
+const char* const DatabaseManager::jobColumns = R"(
+        id, job_type, status, file_path, parameters, date_created, date_started,
+        date_completed, error_message, progress, priority, lease_owner, lease_expires, attempts
+    )";
+
+DatabaseManager::Job DatabaseManager::readJobRow(sqlite3_stmt* stmt)
+{
+    auto text = [stmt](int column)
+    {
+        const char* val = (const char*)sqlite3_column_text(stmt, column);
+        return val ? juce::String(juce::CharPointer_UTF8(val)) : juce::String();
+    };
+    
+    Job job;
+    job.id = sqlite3_column_int64(stmt, 0);
+    job.jobType = text(1);
+    job.status = text(2);
+    job.filePath = text(3);
+    job.parameters = text(4);
+    job.dateCreated = stringToTime(text(5));
+    
+    if (sqlite3_column_type(stmt, 6) != SQLITE_NULL)
+        job.dateStarted = stringToTime(text(6));
+    
+    if (sqlite3_column_type(stmt, 7) != SQLITE_NULL)
+        job.dateCompleted = stringToTime(text(7));
+    
+    job.errorMessage = text(8);
+    job.progress = sqlite3_column_int(stmt, 9);
+    job.priority = sqlite3_column_int(stmt, 10);
+    job.leaseOwner = text(11);
+    
+    if (sqlite3_column_type(stmt, 12) != SQLITE_NULL)
+        job.leaseExpires = juce::Time(sqlite3_column_int64(stmt, 12));
+    
+    job.attempts = sqlite3_column_int(stmt, 13);
+    return job;
+}
+
 bool DatabaseManager::addJob(const Job& job, int64_t& outId)
+{
+    return insertJob(job, outId, false);
+}
+
+bool DatabaseManager::enqueueJob(const Job& job, int64_t& outId)
+{
+    return insertJob(job, outId, true);
+}
+
+bool DatabaseManager::insertJob(const Job& job, int64_t& outId, bool ignoreIfQueued)
 {
     const juce::ScopedLock lock(dbMutex);
     
+    outId = 0;
+    
     if (!isOpen())
     {
         lastError = "Database is not open";
         return false;
     }
     
-    const char* sql = R"(
-        INSERT INTO Jobs (job_type, status, parameters, date_created, date_started, 
-                         date_completed, error_message, progress)
-        VALUES (?, ?, ?, ?, ?, ?, ?, ?)
+    juce::String sql = juce::String(ignoreIfQueued ? "INSERT OR IGNORE" : "INSERT") + R"( INTO Jobs
+            (job_type, status, file_path, parameters, date_created, date_started,
+             date_completed, error_message, progress, priority)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
     )";
     
     sqlite3_stmt* stmt = nullptr;
-    int result = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+    int result = sqlite3_prepare_v2(db, sql.toRawUTF8(), -1, &stmt, nullptr);
     
     if (result != SQLITE_OK)
     {
@@ -1196,21 +1832,28 @@ bool DatabaseManager::addJob(const Job& job, int64_t& outId)
     
     sqlite3_bind_text(stmt, 1, job.jobType.toRawUTF8(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 2, job.status.toRawUTF8(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, job.parameters.toRawUTF8(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 4, timeToString(job.dateCreated).toRawUTF8(), -1, SQLITE_TRANSIENT);
+    
+    if (job.filePath.isNotEmpty())
+        sqlite3_bind_text(stmt, 3, job.filePath.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    else
+        sqlite3_bind_null(stmt, 3);
+    
+    sqlite3_bind_text(stmt, 4, job.parameters.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 5, timeToString(job.dateCreated).toRawUTF8(), -1, SQLITE_TRANSIENT);
     
     if (job.dateStarted != juce::Time())
-        sqlite3_bind_text(stmt, 5, timeToString(job.dateStarted).toRawUTF8(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 6, timeToString(job.dateStarted).toRawUTF8(), -1, SQLITE_TRANSIENT);
     else
-        sqlite3_bind_null(stmt, 5);
+        sqlite3_bind_null(stmt, 6);
     
     if (job.dateCompleted != juce::Time())
-        sqlite3_bind_text(stmt, 6, timeToString(job.dateCompleted).toRawUTF8(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 7, timeToString(job.dateCompleted).toRawUTF8(), -1, SQLITE_TRANSIENT);
     else
-        sqlite3_bind_null(stmt, 6);
+        sqlite3_bind_null(stmt, 7);
     
-    sqlite3_bind_text(stmt, 7, job.errorMessage.toRawUTF8(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 8, job.progress);
+    sqlite3_bind_text(stmt, 8, job.errorMessage.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 9, job.progress);
+    sqlite3_bind_int(stmt, 10, job.priority);
     
     result = sqlite3_step(stmt);
     
@@ -1222,10 +1865,22 @@ bool DatabaseManager::addJob(const Job& job, int64_t& outId)
         return false;
     }
     
-    outId = sqlite3_last_insert_rowid(db);
+    // With OR IGNORE, zero changes means an equivalent job is already queued
+    if (sqlite3_changes(db) > 0)
+    {
+        outId = sqlite3_last_insert_rowid(db);
+        
+        if (job.status == "pending")
+            availablePriority = juce::jmax(availablePriority, job.priority);
+    }
+    
     sqlite3_finalize(stmt);
     
-    logInfo("Job added with ID: " + juce::String(outId));
+    if (outId != 0)
+        logInfo("Job added with ID: " + juce::String(outId));
+    else if (job.priority > jobPriorityBackground && job.filePath.isNotEmpty())
+        bumpJobPriorityLocked(job.filePath, job.priority);  // Already queued: make it run sooner
+    
     return true;
 }
 
@@ -1240,8 +1895,8 @@ bool DatabaseManager::updateJob(const Job& job)
     }
     
     const char* sql = R"(
-        UPDATE Jobs SET job_type=?, status=?, parameters=?, date_started=?, 
-                       date_completed=?, error_message=?, progress=?
+        UPDATE Jobs SET job_type=?, status=?, file_path=?, parameters=?, date_started=?, 
+                       date_completed=?, error_message=?, progress=?, priority=?
         WHERE id=?
     )";
     
@@ -1257,21 +1912,35 @@ bool DatabaseManager::updateJob(const Job& job)
     
     sqlite3_bind_text(stmt, 1, job.jobType.toRawUTF8(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 2, job.status.toRawUTF8(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, job.parameters.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    
+    if (job.filePath.isNotEmpty())
+        sqlite3_bind_text(stmt, 3, job.filePath.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    else
+        sqlite3_bind_null(stmt, 3);
+    
+    sqlite3_bind_text(stmt, 4, job.parameters.toRawUTF8(), -1, SQLITE_TRANSIENT);
     
     if (job.dateStarted != juce::Time())
-        sqlite3_bind_text(stmt, 4, timeToString(job.dateStarted).toRawUTF8(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 5, timeToString(job.dateStarted).toRawUTF8(), -1, SQLITE_TRANSIENT);
     else
-        sqlite3_bind_null(stmt, 4);
+        sqlite3_bind_null(stmt, 5);
     
     if (job.dateCompleted != juce::Time())
-        sqlite3_bind_text(stmt, 5, timeToString(job.dateCompleted).toRawUTF8(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 6, timeToString(job.dateCompleted).toRawUTF8(), -1, SQLITE_TRANSIENT);
     else
-        sqlite3_bind_null(stmt, 5);
+        sqlite3_bind_null(stmt, 6);
+    
+    sqlite3_bind_text(stmt, 7, job.errorMessage.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 8, job.progress);
+    sqlite3_bind_int(stmt, 9, job.priority);
+    sqlite3_bind_int64(stmt, 10, job.id);
     
-    sqlite3_bind_text(stmt, 6, job.errorMessage.toRawUTF8(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 7, job.progress);
-    sqlite3_bind_int64(stmt, 8, job.id);
+    // A job put back to pending is new work as far as the workers are concerned
+    if (job.status == "pending")
+    {
+        jobsBecameAvailable = true;
+        availablePriority = juce::jmax(availablePriority, job.priority);
+    }
     
     result = sqlite3_step(stmt);
     
@@ -1334,14 +2003,10 @@ DatabaseManager::Job DatabaseManager::getJob(int64_t jobId) const
     if (!isOpen())
         return job;
     
-    const char* sql = R"(
-        SELECT id, job_type, status, parameters, date_created, date_started, 
-               date_completed, error_message, progress
-        FROM Jobs WHERE id=?
-    )";
+    juce::String sql = juce::String("SELECT ") + jobColumns + " FROM Jobs WHERE id=?";
     
     sqlite3_stmt* stmt = nullptr;
-    int result = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+    int result = sqlite3_prepare_v2(db, sql.toRawUTF8(), -1, &stmt, nullptr);
     
     if (result != SQLITE_OK)
         return job;
@@ -1349,43 +2014,7 @@ DatabaseManager::Job DatabaseManager::getJob(int64_t jobId) const
     sqlite3_bind_int64(stmt, 1, jobId);
     
     if (sqlite3_step(stmt) == SQLITE_ROW)
-    {
-        job.id = sqlite3_column_int64(stmt, 0);
-        {
-            const char* jobTypeText = (const char*)sqlite3_column_text(stmt, 1);
-            job.jobType = jobTypeText ? juce::CharPointer_UTF8(jobTypeText) : juce::String();
-        }
-        {
-            const char* statusText = (const char*)sqlite3_column_text(stmt, 2);
-            job.status = statusText ? juce::CharPointer_UTF8(statusText) : juce::String();
-        }
-        {
-            const char* parametersText = (const char*)sqlite3_column_text(stmt, 3);
-            job.parameters = parametersText ? juce::CharPointer_UTF8(parametersText) : juce::String();
-        }
-        {
-            const char* dateCreatedText = (const char*)sqlite3_column_text(stmt, 4);
-            job.dateCreated = dateCreatedText ? stringToTime(juce::CharPointer_UTF8(dateCreatedText)) : juce::Time();
-        }
-        
-        if (sqlite3_column_type(stmt, 5) != SQLITE_NULL)
-        {
-            const char* dateStartedText = (const char*)sqlite3_column_text(stmt, 5);
-            job.dateStarted = dateStartedText ? stringToTime(juce::CharPointer_UTF8(dateStartedText)) : juce::Time();
-        }
-        
-        if (sqlite3_column_type(stmt, 6) != SQLITE_NULL)
-        {
-            const char* dateCompletedText = (const char*)sqlite3_column_text(stmt, 6);
-            job.dateCompleted = dateCompletedText ? stringToTime(juce::CharPointer_UTF8(dateCompletedText)) : juce::Time();
-        }
-        
-        {
-            const char* errorMessageText = (const char*)sqlite3_column_text(stmt, 7);
-            job.errorMessage = errorMessageText ? juce::CharPointer_UTF8(errorMessageText) : juce::String();
-        }
-        job.progress = sqlite3_column_int(stmt, 8);
-    }
+        job = readJobRow(stmt);
     
     sqlite3_finalize(stmt);
     return job;
@@ -1400,87 +2029,975 @@ std::vector<DatabaseManager::Job> DatabaseManager::getAllJobs() const
     if (!isOpen())
         return jobs;
     
-    const char* sql = R"(
-        SELECT id, job_type, status, parameters, date_created, date_started, 
-               date_completed, error_message, progress
-        FROM Jobs ORDER BY date_created DESC
-    )";
+    juce::String sql = juce::String("SELECT ") + jobColumns + " FROM Jobs ORDER BY date_created DESC";
+    
+    sqlite3_stmt* stmt = nullptr;
+    int result = sqlite3_prepare_v2(db, sql.toRawUTF8(), -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK)
+        return jobs;
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+        jobs.push_back(readJobRow(stmt));
+    
+    sqlite3_finalize(stmt);
+    return jobs;
+}
+
+std::vector<DatabaseManager::Job> DatabaseManager::getJobsByStatus(const juce::String& status) const
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    std::vector<Job> jobs;
+    
+    if (!isOpen())
+        return jobs;
+    
+    juce::String sql = juce::String("SELECT ") + jobColumns + " FROM Jobs WHERE status=? ORDER BY date_created DESC";
+    
+    sqlite3_stmt* stmt = nullptr;
+    int result = sqlite3_prepare_v2(db, sql.toRawUTF8(), -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK)
+        return jobs;
+    
+    sqlite3_bind_text(stmt, 1, status.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+        jobs.push_back(readJobRow(stmt));
+    
+    sqlite3_finalize(stmt);
+    return jobs;
+}
+
+int DatabaseManager::getJobCountByStatus(const juce::String& status) const
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    if (!isOpen())
+        return 0;
+    
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM Jobs WHERE status=?", -1, &stmt, nullptr) != SQLITE_OK)
+        return 0;
+    
+    sqlite3_bind_text(stmt, 1, status.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    
+    int count = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+        count = sqlite3_column_int(stmt, 0);
+    
+    sqlite3_finalize(stmt);
+    return count;
+}
+
+bool DatabaseManager::claimNextJob(Job& outJob, const juce::String& leaseOwner, int leaseSeconds, int minPriority)
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    if (!isOpen())
+    {
+        lastError = "Database is not open";
+        return false;
+    }
+    
+    // Mostly highest priority first, but give every Nth claim to the oldest job
+    // so a steady stream of interactive requests cannot starve the background queue
+    const bool urgentOnly = minPriority > jobPriorityBackground;
+    const bool backgroundTurn = !urgentOnly && (++claimCount % backgroundClaimInterval) == 0;
+    
+    // Select and mark running under the same lock, so two workers can never
+    // claim the same row
+    juce::String sql = juce::String("SELECT ") + jobColumns + " FROM Jobs WHERE status='pending'"
+                     + (urgentOnly ? " AND priority>=" + juce::String(minPriority) : juce::String())
+                     + " ORDER BY " + (backgroundTurn ? "id" : "priority DESC, id") + " LIMIT 1";
+    
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql.toRawUTF8(), -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        lastError = juce::String("Failed to prepare statement: ") + sqlite3_errmsg(db);
+        logError("claimNextJob", lastError);
+        return false;
+    }
+    
+    bool found = (sqlite3_step(stmt) == SQLITE_ROW);
+    if (found)
+        outJob = readJobRow(stmt);
+    
+    sqlite3_finalize(stmt);
+    
+    if (!found)
+        return false;
+    
+    outJob.status = "running";
+    outJob.dateStarted = juce::Time::getCurrentTime();
+    outJob.progress = 0;
+    outJob.leaseOwner = leaseOwner;
+    outJob.leaseExpires = outJob.dateStarted + juce::RelativeTime::seconds(leaseSeconds);
+    ++outJob.attempts;
+    
+    stmt = nullptr;
+    if (sqlite3_prepare_v2(db, R"(
+            UPDATE Jobs SET status='running', date_started=?, progress=0,
+                            lease_owner=?, lease_expires=?, attempts=attempts+1
+            WHERE id=? AND status='pending'
+        )", -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        lastError = juce::String("Failed to prepare statement: ") + sqlite3_errmsg(db);
+        logError("claimNextJob", lastError);
+        return false;
+    }
+    
+    sqlite3_bind_text(stmt, 1, timeToString(outJob.dateStarted).toRawUTF8(), -1, SQLITE_TRANSIENT);
+    
+    if (leaseOwner.isNotEmpty())
+        sqlite3_bind_text(stmt, 2, leaseOwner.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    else
+        sqlite3_bind_null(stmt, 2);
+    
+    sqlite3_bind_int64(stmt, 3, outJob.leaseExpires.toMilliseconds());
+    sqlite3_bind_int64(stmt, 4, outJob.id);
+    
+    bool claimed = (sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db) > 0);
+    sqlite3_finalize(stmt);
+    
+    return claimed;
+}
+
+int DatabaseManager::renewJobLeases(const juce::String& leaseOwner, int leaseSeconds)
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    if (!isOpen())
+    {
+        lastError = "Database is not open";
+        return -1;
+    }
+    
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "UPDATE Jobs SET lease_expires=? WHERE status='running' AND lease_owner=?",
+                           -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        lastError = juce::String("Failed to prepare statement: ") + sqlite3_errmsg(db);
+        logError("renewJobLeases", lastError);
+        return -1;
+    }
+    
+    const auto expires = juce::Time::getCurrentTime() + juce::RelativeTime::seconds(leaseSeconds);
+    sqlite3_bind_int64(stmt, 1, expires.toMilliseconds());
+    sqlite3_bind_text(stmt, 2, leaseOwner.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    
+    const bool renewed = (sqlite3_step(stmt) == SQLITE_DONE);
+    sqlite3_finalize(stmt);
+    
+    if (!renewed)
+    {
+        lastError = juce::String("Failed to renew job leases: ") + sqlite3_errmsg(db);
+        logError("renewJobLeases", lastError);
+        return -1;
+    }
+    
+    return sqlite3_changes(db);
+}
+
+bool DatabaseManager::recoverExpiredJobs(int maxAttempts, int& outRequeued, int& outFailed)
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    outRequeued = 0;
+    outFailed = 0;
+    
+    if (!isOpen())
+    {
+        lastError = "Database is not open";
+        return false;
+    }
+    
+    const auto now = juce::Time::getCurrentTime();
+    
+    // Give up on jobs that used all their attempts first; the rest go back to pending
+    auto recover = [this, &now, maxAttempts](const char* sql, bool bindFailure) -> int
+    {
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            lastError = juce::String("Failed to prepare statement: ") + sqlite3_errmsg(db);
+            logError("recoverExpiredJobs", lastError);
+            return -1;
+        }
+        
+        sqlite3_bind_int64(stmt, 1, now.toMilliseconds());
+        sqlite3_bind_int(stmt, 2, maxAttempts);
+        
+        if (bindFailure)
+        {
+            const auto message = "Abandoned after " + juce::String(maxAttempts) + " attempts";
+            sqlite3_bind_text(stmt, 3, timeToString(now).toRawUTF8(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt, 4, message.toRawUTF8(), -1, SQLITE_TRANSIENT);
+        }
+        
+        const int result = sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+        
+        if (result != SQLITE_DONE)
+        {
+            lastError = juce::String("Failed to recover jobs: ") + sqlite3_errmsg(db);
+            logError("recoverExpiredJobs", lastError);
+            return -1;
+        }
+        
+        return sqlite3_changes(db);
+    };
+    
+    if (!beginTransaction())
+        return false;
+    
+    outFailed = recover(R"(
+        UPDATE Jobs SET status='failed', date_completed=?3, error_message=?4, lease_owner=NULL
+        WHERE status='running' AND lease_expires < ?1 AND attempts >= ?2
+    )", true);
+    
+    outRequeued = recover(R"(
+        UPDATE Jobs SET status='pending', progress=0, lease_owner=NULL, lease_expires=NULL
+        WHERE status='running' AND lease_expires < ?1 AND attempts < ?2
+    )", false);
+    
+    if (outFailed < 0 || outRequeued < 0)
+    {
+        rollbackTransaction();
+        outRequeued = outFailed = 0;
+        return false;
+    }
+    
+    // Requeued jobs are new work for the workers
+    if (outRequeued > 0)
+        jobsBecameAvailable = true;
+    
+    if (!commitTransaction())
+    {
+        rollbackTransaction();
+        outRequeued = outFailed = 0;
+        return false;
+    }
+    
+    if (outRequeued > 0 || outFailed > 0)
+        logInfo("Recovered expired jobs: " + juce::String(outRequeued) + " requeued, "
+                + juce::String(outFailed) + " failed");
+    
+    return true;
+}
+
+bool DatabaseManager::releaseJob(int64_t jobId)
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    if (!isOpen())
+    {
+        lastError = "Database is not open";
+        return false;
+    }
+    
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, R"(
+            UPDATE Jobs SET status='pending', progress=0, lease_owner=NULL, lease_expires=NULL,
+                            attempts=MAX(attempts-1, 0)
+            WHERE id=? AND status='running'
+        )", -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        lastError = juce::String("Failed to prepare statement: ") + sqlite3_errmsg(db);
+        logError("releaseJob", lastError);
+        return false;
+    }
+    
+    sqlite3_bind_int64(stmt, 1, jobId);
+    
+    // Flagged before the step so the autocommit's hook sees it
+    jobsBecameAvailable = true;
+    
+    const int result = sqlite3_step(stmt);
+    const bool released = (result == SQLITE_DONE && sqlite3_changes(db) > 0);
+    sqlite3_finalize(stmt);
+    
+    if (result != SQLITE_DONE)
+    {
+        lastError = juce::String("Failed to release job: ") + sqlite3_errmsg(db);
+        logError("releaseJob", lastError);
+        return false;
+    }
+    
+    if (released)
+        logInfo("Job released back to the queue: " + juce::String(jobId));
+    
+    return released;
+}
+
+bool DatabaseManager::bumpJobPriority(const juce::String& filePath, int priority)
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    if (!isOpen())
+    {
+        lastError = "Database is not open";
+        return false;
+    }
+    
+    return bumpJobPriorityLocked(filePath, priority);
+}
+
+bool DatabaseManager::bumpJobPriorityLocked(const juce::String& filePath, int priority)
+{
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "UPDATE Jobs SET priority=? WHERE status='pending' AND file_path=? AND priority<?",
+                           -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        lastError = juce::String("Failed to prepare statement: ") + sqlite3_errmsg(db);
+        logError("bumpJobPriority", lastError);
+        return false;
+    }
+    
+    sqlite3_bind_int(stmt, 1, priority);
+    sqlite3_bind_text(stmt, 2, filePath.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 3, priority);
+    
+    bool bumped = (sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db) > 0);
+    sqlite3_finalize(stmt);
+    
+    // A raised job may now outrank work already running
+    if (bumped)
+    {
+        jobsBecameAvailable = true;
+        availablePriority = juce::jmax(availablePriority, priority);
+        logInfo("Raised job priority to " + juce::String(priority) + " for: " + filePath);
+    }
+    
+    return bumped;
+}
+
+//==============================================================================
+// Change notifications
+
+void DatabaseManager::setJobAvailableCallback(std::function<void(int highestPriority)> callback)
+{
+    const juce::ScopedLock lock(dbMutex);
+    jobAvailableCallback = std::move(callback);
+}
+
+void DatabaseManager::onRowChanged(void* context, int operation, const char*,
+                                   const char* table, sqlite3_int64)
+{
+    // Only inserts are flagged here; claiming a job (an UPDATE to running)
+    // must not wake the other workers. updateJob() flags requeues itself.
+    if (operation == SQLITE_INSERT && std::strcmp(table, "Jobs") == 0)
+        static_cast<DatabaseManager*>(context)->jobsBecameAvailable = true;
+}
+
+int DatabaseManager::onCommit(void* context)
+{
+    auto* self = static_cast<DatabaseManager*>(context);
+    
+    if (self->jobsBecameAvailable)
+    {
+        const int priority = self->availablePriority;
+        self->jobsBecameAvailable = false;
+        self->availablePriority = jobPriorityBackground;
+        
+        if (self->jobAvailableCallback)
+            self->jobAvailableCallback(priority);
+    }
+    
+    return 0;  // Non-zero would turn the commit into a rollback
+}
+
+void DatabaseManager::onRollback(void* context)
+{
+    auto* self = static_cast<DatabaseManager*>(context);
+    self->jobsBecameAvailable = false;
+    self->availablePriority = jobPriorityBackground;
+}
+
+//==============================================================================
+// Waveform overviews
+
+bool DatabaseManager::saveWaveformOverview(const WaveformOverview& overview)
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    if (!isOpen())
+    {
+        lastError = "Database is not open";
+        return false;
+    }
+    
+    const char* sql = R"(
+        INSERT OR REPLACE INTO WaveformOverviews (track_id, duration, num_bins, data)
+        VALUES (?, ?, ?, ?)
+    )";
+    
+    sqlite3_stmt* stmt = nullptr;
+    int result = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK)
+    {
+        lastError = juce::String("Failed to prepare statement: ") + sqlite3_errmsg(db);
+        logError("saveWaveformOverview", lastError);
+        return false;
+    }
+    
+    sqlite3_bind_int64(stmt, 1, overview.trackId);
+    sqlite3_bind_double(stmt, 2, overview.duration);
+    sqlite3_bind_int(stmt, 3, overview.getNumBins());
+    sqlite3_bind_blob(stmt, 4, overview.minMax.data(), static_cast<int>(overview.minMax.size()), SQLITE_TRANSIENT);
+    
+    result = sqlite3_step(stmt);
+    
+    if (result != SQLITE_DONE)
+    {
+        lastError = juce::String("Failed to save waveform overview: ") + sqlite3_errmsg(db);
+        logError("saveWaveformOverview", lastError);
+        sqlite3_finalize(stmt);
+        return false;
+    }
+    
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+bool DatabaseManager::getWaveformOverview(int64_t trackId, WaveformOverview& outOverview) const
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    if (!isOpen())
+        return false;
+    
+    const char* sql = "SELECT duration, data FROM WaveformOverviews WHERE track_id=?";
+    
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+        return false;
+    
+    sqlite3_bind_int64(stmt, 1, trackId);
+    
+    bool found = false;
+    
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        auto* data = static_cast<const int8_t*>(sqlite3_column_blob(stmt, 1));
+        auto size = sqlite3_column_bytes(stmt, 1);
+        
+        outOverview.trackId = trackId;
+        outOverview.duration = sqlite3_column_double(stmt, 0);
+        outOverview.minMax.assign(data, data + (data != nullptr ? size : 0));
+        found = true;
+    }
+    
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+//==============================================================================
+// Beat grids
+
+bool DatabaseManager::saveBeatGrid(const BeatGrid& grid)
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    if (!isOpen())
+    {
+        lastError = "Database is not open";
+        return false;
+    }
+    
+    const bool remove = grid.markers.empty();
+    const char* sql = remove ? "DELETE FROM BeatGrids WHERE track_id=?"
+                             : "INSERT OR REPLACE INTO BeatGrids (track_id, num_markers, data) VALUES (?, ?, ?)";
+    
+    sqlite3_stmt* stmt = nullptr;
+    int result = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK)
+    {
+        lastError = juce::String("Failed to prepare statement: ") + sqlite3_errmsg(db);
+        logError("saveBeatGrid", lastError);
+        return false;
+    }
+    
+    juce::MemoryOutputStream data;
+    writeBeatGridMarkers(grid.markers, data);
+    
+    sqlite3_bind_int64(stmt, 1, grid.trackId);
+    
+    if (!remove)
+    {
+        sqlite3_bind_int(stmt, 2, static_cast<int>(grid.markers.size()));
+        sqlite3_bind_blob(stmt, 3, data.getData(), static_cast<int>(data.getDataSize()), SQLITE_TRANSIENT);
+    }
+    
+    result = sqlite3_step(stmt);
+    
+    if (result != SQLITE_DONE)
+    {
+        lastError = juce::String("Failed to save beat grid: ") + sqlite3_errmsg(db);
+        logError("saveBeatGrid", lastError);
+        sqlite3_finalize(stmt);
+        return false;
+    }
+    
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+bool DatabaseManager::getBeatGrid(int64_t trackId, BeatGrid& outGrid) const
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    if (!isOpen())
+        return false;
+    
+    const char* sql = "SELECT num_markers, data FROM BeatGrids WHERE track_id=?";
+    
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+        return false;
+    
+    sqlite3_bind_int64(stmt, 1, trackId);
+    
+    bool found = false;
+    
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        outGrid.trackId = trackId;
+        outGrid.markers = readBeatGridMarkers(sqlite3_column_blob(stmt, 1), (size_t) sqlite3_column_bytes(stmt, 1),
+                                              sqlite3_column_int(stmt, 0));
+        found = true;
+    }
+    
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+void DatabaseManager::writeBeatGridMarkers(const std::vector<BeatGridMarker>& markers, juce::MemoryOutputStream& out)
+{
+    // 17 bytes per marker: little-endian position and tempo as doubles, then the beat number
+    for (const auto& marker : markers)
+    {
+        out.writeDouble(marker.position);
+        out.writeDouble(marker.bpm);
+        out.writeByte(static_cast<char>(marker.beat));
+    }
+}
+
+std::vector<DatabaseManager::BeatGridMarker> DatabaseManager::readBeatGridMarkers(const void* data, size_t size,
+                                                                                  int numMarkers)
+{
+    if (data == nullptr)
+        size = 0;
+    
+    std::vector<BeatGridMarker> markers((size_t) juce::jlimit(0, static_cast<int>(size / 17), numMarkers));
+    juce::MemoryInputStream input(data, size, false);
+    
+    for (auto& marker : markers)
+    {
+        marker.position = input.readDouble();
+        marker.bpm = input.readDouble();
+        marker.beat = input.readByte();
+    }
+    
+    return markers;
+}
+
+//==============================================================================
+// Audio fingerprints
+
+bool DatabaseManager::saveAudioFingerprint(const AudioFingerprint& fingerprint)
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    if (!isOpen())
+    {
+        lastError = "Database is not open";
+        return false;
+    }
+    
+    const char* sql = R"(
+        INSERT OR REPLACE INTO AudioFingerprints (track_id, duration, num_frames, data)
+        VALUES (?, ?, ?, ?)
+    )";
     
     sqlite3_stmt* stmt = nullptr;
     int result = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
     
     if (result != SQLITE_OK)
-        return jobs;
+    {
+        lastError = juce::String("Failed to prepare statement: ") + sqlite3_errmsg(db);
+        logError("saveAudioFingerprint", lastError);
+        return false;
+    }
+    
+    juce::MemoryOutputStream data;
+    writeFingerprintBits(fingerprint.bits, data);
+    
+    sqlite3_bind_int64(stmt, 1, fingerprint.trackId);
+    sqlite3_bind_double(stmt, 2, fingerprint.duration);
+    sqlite3_bind_int(stmt, 3, static_cast<int>(fingerprint.bits.size()));
+    sqlite3_bind_blob(stmt, 4, data.getData(), static_cast<int>(data.getDataSize()), SQLITE_TRANSIENT);
+    
+    result = sqlite3_step(stmt);
+    
+    if (result != SQLITE_DONE)
+    {
+        lastError = juce::String("Failed to save audio fingerprint: ") + sqlite3_errmsg(db);
+        logError("saveAudioFingerprint", lastError);
+        sqlite3_finalize(stmt);
+        return false;
+    }
+    
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+bool DatabaseManager::getAudioFingerprint(int64_t trackId, AudioFingerprint& outFingerprint) const
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    if (!isOpen())
+        return false;
+    
+    const char* sql = "SELECT duration, data FROM AudioFingerprints WHERE track_id=?";
+    
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+        return false;
+    
+    sqlite3_bind_int64(stmt, 1, trackId);
+    
+    bool found = false;
+    
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        outFingerprint.trackId = trackId;
+        outFingerprint.duration = sqlite3_column_double(stmt, 0);
+        outFingerprint.bits = readFingerprintBits(sqlite3_column_blob(stmt, 1), (size_t) sqlite3_column_bytes(stmt, 1));
+        found = true;
+    }
+    
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+std::vector<DatabaseManager::AudioFingerprint> DatabaseManager::getAudioFingerprintExcerpts(int startFrame,
+                                                                                            int numFrames) const
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    std::vector<AudioFingerprint> excerpts;
+    
+    if (!isOpen())
+        return excerpts;
+    
+    // substr() on a BLOB counts bytes from 1, so SQLite hands back just the excerpt
+    const char* sql = R"(
+        SELECT track_id, duration, substr(data, 1 + 4 * max(0, min(?, num_frames - ?)), 4 * ?)
+        FROM AudioFingerprints WHERE num_frames >= ?
+    )";
+    
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+        return excerpts;
+    
+    sqlite3_bind_int(stmt, 1, startFrame);
+    sqlite3_bind_int(stmt, 2, numFrames);
+    sqlite3_bind_int(stmt, 3, numFrames);
+    sqlite3_bind_int(stmt, 4, numFrames);
     
     while (sqlite3_step(stmt) == SQLITE_ROW)
     {
-        Job job;
-        job.id = sqlite3_column_int64(stmt, 0);
-        job.jobType = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 1));
-        job.status = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 2));
-        job.parameters = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 3));
-        job.dateCreated = stringToTime(juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 4)));
-        
-        if (sqlite3_column_type(stmt, 5) != SQLITE_NULL)
-            job.dateStarted = stringToTime(juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 5)));
+        AudioFingerprint excerpt;
+        excerpt.trackId = sqlite3_column_int64(stmt, 0);
+        excerpt.duration = sqlite3_column_double(stmt, 1);
+        excerpt.bits = readFingerprintBits(sqlite3_column_blob(stmt, 2), (size_t) sqlite3_column_bytes(stmt, 2));
+        excerpts.push_back(std::move(excerpt));
+    }
+    
+    sqlite3_finalize(stmt);
+    return excerpts;
+}
+
+//==============================================================================
+bool DatabaseManager::saveDuplicateMatches(int64_t trackId, const std::vector<DuplicateMatch>& matches)
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    if (!isOpen())
+    {
+        lastError = "Database is not open";
+        return false;
+    }
+    
+    sqlite3_stmt* stmt = nullptr;
+    int result = sqlite3_prepare_v2(db, "DELETE FROM DuplicateMatches WHERE track_id=? OR duplicate_id=?", -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK)
+    {
+        lastError = juce::String("Failed to prepare statement: ") + sqlite3_errmsg(db);
+        logError("saveDuplicateMatches", lastError);
+        return false;
+    }
+    
+    sqlite3_bind_int64(stmt, 1, trackId);
+    sqlite3_bind_int64(stmt, 2, trackId);
+    result = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    
+    if (result != SQLITE_DONE)
+    {
+        lastError = juce::String("Failed to clear duplicate matches: ") + sqlite3_errmsg(db);
+        logError("saveDuplicateMatches", lastError);
+        return false;
+    }
+    
+    if (matches.empty())
+        return true;
+    
+    const char* sql = "INSERT OR REPLACE INTO DuplicateMatches (track_id, duplicate_id, bit_error_rate) VALUES (?, ?, ?)";
+    result = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK)
+    {
+        lastError = juce::String("Failed to prepare statement: ") + sqlite3_errmsg(db);
+        logError("saveDuplicateMatches", lastError);
+        return false;
+    }
+    
+    for (const auto& match : matches)
+    {
+        if (match.duplicateId == trackId)
+            continue;
         
-        if (sqlite3_column_type(stmt, 6) != SQLITE_NULL)
-            job.dateCompleted = stringToTime(juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 6)));
+        sqlite3_reset(stmt);
+        sqlite3_bind_int64(stmt, 1, juce::jmin(trackId, match.duplicateId));
+        sqlite3_bind_int64(stmt, 2, juce::jmax(trackId, match.duplicateId));
+        sqlite3_bind_double(stmt, 3, match.bitErrorRate);
         
-        job.errorMessage = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 7));
-        job.progress = sqlite3_column_int(stmt, 8);
-        jobs.push_back(job);
+        if (sqlite3_step(stmt) != SQLITE_DONE)
+        {
+            lastError = juce::String("Failed to save duplicate match: ") + sqlite3_errmsg(db);
+            logError("saveDuplicateMatches", lastError);
+            sqlite3_finalize(stmt);
+            return false;
+        }
     }
     
     sqlite3_finalize(stmt);
-    return jobs;
+    return true;
 }
 
-std::vector<DatabaseManager::Job> DatabaseManager::getJobsByStatus(const juce::String& status) const
+std::vector<DatabaseManager::DuplicateMatch> DatabaseManager::getDuplicateMatches(int64_t trackId) const
 {
     const juce::ScopedLock lock(dbMutex);
     
-    std::vector<Job> jobs;
+    std::vector<DuplicateMatch> matches;
     
     if (!isOpen())
-        return jobs;
+        return matches;
+    
+    const char* sql = R"(
+        SELECT CASE WHEN track_id=?1 THEN duplicate_id ELSE track_id END, bit_error_rate
+        FROM DuplicateMatches WHERE track_id=?1 OR duplicate_id=?1
+        ORDER BY bit_error_rate
+    )";
+    
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+        return matches;
+    
+    sqlite3_bind_int64(stmt, 1, trackId);
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        DuplicateMatch match;
+        match.trackId = trackId;
+        match.duplicateId = sqlite3_column_int64(stmt, 0);
+        match.bitErrorRate = sqlite3_column_double(stmt, 1);
+        matches.push_back(match);
+    }
+    
+    sqlite3_finalize(stmt);
+    return matches;
+}
+
+std::vector<DatabaseManager::DuplicateMatch> DatabaseManager::getAllDuplicateMatches() const
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    std::vector<DuplicateMatch> matches;
+    
+    if (!isOpen())
+        return matches;
+    
+    const char* sql = "SELECT track_id, duplicate_id, bit_error_rate FROM DuplicateMatches ORDER BY bit_error_rate";
+    
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+        return matches;
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        DuplicateMatch match;
+        match.trackId = sqlite3_column_int64(stmt, 0);
+        match.duplicateId = sqlite3_column_int64(stmt, 1);
+        match.bitErrorRate = sqlite3_column_double(stmt, 2);
+        matches.push_back(match);
+    }
+    
+    sqlite3_finalize(stmt);
+    return matches;
+}
+
+void DatabaseManager::writeFingerprintBits(const std::vector<juce::uint32>& bits, juce::MemoryOutputStream& out)
+{
+    for (auto word : bits)
+        out.writeInt(static_cast<int>(word));
+}
+
+std::vector<juce::uint32> DatabaseManager::readFingerprintBits(const void* data, size_t size)
+{
+    if (data == nullptr)
+        size = 0;
+    
+    std::vector<juce::uint32> bits(size / 4);
+    juce::MemoryInputStream input(data, size, false);
+    
+    for (auto& word : bits)
+        word = static_cast<juce::uint32>(input.readInt());
+    
+    return bits;
+}
+
+//==============================================================================
+// Analysis cache
+
+bool DatabaseManager::saveAnalysisCacheEntry(const AnalysisCacheEntry& entry)
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    if (!isOpen())
+    {
+        lastError = "Database is not open";
+        return false;
+    }
     
     const char* sql = R"(
-        SELECT id, job_type, status, parameters, date_created, date_started, 
-               date_completed, error_message, progress
-        FROM Jobs WHERE status=? ORDER BY date_created DESC
+        INSERT OR REPLACE INTO AnalysisCache (audio_hash, version, duration, fingerprint, bpm, bpm_confidence,
+                                              musical_key, loudness_lufs, loudness_range, true_peak_db,
+                                              waveform, grid_bpm, beat_grid, date_added, audio_fingerprint)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
     )";
     
     sqlite3_stmt* stmt = nullptr;
     int result = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
     
     if (result != SQLITE_OK)
-        return jobs;
+    {
+        lastError = juce::String("Failed to prepare statement: ") + sqlite3_errmsg(db);
+        logError("saveAnalysisCacheEntry", lastError);
+        return false;
+    }
     
-    sqlite3_bind_text(stmt, 1, status.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    juce::MemoryOutputStream grid;
+    writeBeatGridMarkers(entry.beatGrid, grid);
+    
+    juce::MemoryOutputStream audioFingerprint;
+    writeFingerprintBits(entry.audioFingerprint, audioFingerprint);
+    
+    sqlite3_bind_text(stmt, 1, entry.audioHash.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, analysisCacheVersion);
+    sqlite3_bind_double(stmt, 3, entry.duration);
+    sqlite3_bind_text(stmt, 4, entry.fingerprint.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_double(stmt, 5, entry.bpm);
+    sqlite3_bind_double(stmt, 6, entry.bpmConfidence);
+    sqlite3_bind_text(stmt, 7, entry.key.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_double(stmt, 8, entry.loudnessLufs);
+    sqlite3_bind_double(stmt, 9, entry.loudnessRange);
+    sqlite3_bind_double(stmt, 10, entry.truePeakDb);
+    sqlite3_bind_blob(stmt, 11, entry.waveform.minMax.data(), static_cast<int>(entry.waveform.minMax.size()),
+                      SQLITE_TRANSIENT);
+    sqlite3_bind_double(stmt, 12, entry.gridBpm);
+    sqlite3_bind_blob(stmt, 13, grid.getData(), static_cast<int>(grid.getDataSize()), SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 14, timeToString(juce::Time::getCurrentTime()).toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_blob(stmt, 15, audioFingerprint.getData(), static_cast<int>(audioFingerprint.getDataSize()),
+                      SQLITE_TRANSIENT);
     
-    while (sqlite3_step(stmt) == SQLITE_ROW)
+    result = sqlite3_step(stmt);
+    
+    if (result != SQLITE_DONE)
+    {
+        lastError = juce::String("Failed to save analysis cache entry: ") + sqlite3_errmsg(db);
+        logError("saveAnalysisCacheEntry", lastError);
+        sqlite3_finalize(stmt);
+        return false;
+    }
+    
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+bool DatabaseManager::getAnalysisCacheEntry(const juce::String& audioHash, AnalysisCacheEntry& outEntry) const
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    if (!isOpen() || audioHash.isEmpty())
+        return false;
+    
+    const char* sql = R"(
+        SELECT duration, fingerprint, bpm, bpm_confidence, musical_key, loudness_lufs, loudness_range,
+               true_peak_db, waveform, grid_bpm, beat_grid, audio_fingerprint
+        FROM AnalysisCache WHERE audio_hash=? AND version=?
+    )";
+    
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+        return false;
+    
+    sqlite3_bind_text(stmt, 1, audioHash.toRawUTF8(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, analysisCacheVersion);
+    
+    bool found = false;
+    
+    if (sqlite3_step(stmt) == SQLITE_ROW)
     {
-        Job job;
-        job.id = sqlite3_column_int64(stmt, 0);
-        job.jobType = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 1));
-        job.status = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 2));
-        job.parameters = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 3));
-        job.dateCreated = stringToTime(juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 4)));
+        auto text = [stmt](int column)
+        {
+            const char* val = (const char*)sqlite3_column_text(stmt, column);
+            return val ? juce::String(juce::CharPointer_UTF8(val)) : juce::String();
+        };
+        
+        outEntry = AnalysisCacheEntry();
+        outEntry.audioHash = audioHash;
+        outEntry.duration = sqlite3_column_double(stmt, 0);
+        outEntry.fingerprint = text(1);
+        outEntry.bpm = sqlite3_column_double(stmt, 2);
+        outEntry.bpmConfidence = sqlite3_column_double(stmt, 3);
+        outEntry.key = text(4);
+        outEntry.loudnessLufs = sqlite3_column_double(stmt, 5);
+        outEntry.loudnessRange = sqlite3_column_double(stmt, 6);
+        outEntry.truePeakDb = sqlite3_column_double(stmt, 7);
         
-        if (sqlite3_column_type(stmt, 5) != SQLITE_NULL)
-            job.dateStarted = stringToTime(juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 5)));
+        auto* waveform = static_cast<const int8_t*>(sqlite3_column_blob(stmt, 8));
+        auto waveformSize = sqlite3_column_bytes(stmt, 8);
+        outEntry.waveform.duration = outEntry.duration;
+        outEntry.waveform.minMax.assign(waveform, waveform + (waveform != nullptr ? waveformSize : 0));
         
-        if (sqlite3_column_type(stmt, 6) != SQLITE_NULL)
-            job.dateCompleted = stringToTime(juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 6)));
+        const auto gridSize = (size_t) sqlite3_column_bytes(stmt, 10);
+        outEntry.gridBpm = sqlite3_column_double(stmt, 9);
+        outEntry.beatGrid = readBeatGridMarkers(sqlite3_column_blob(stmt, 10), gridSize, static_cast<int>(gridSize / 17));
+        outEntry.audioFingerprint = readFingerprintBits(sqlite3_column_blob(stmt, 11),
+                                                        (size_t) sqlite3_column_bytes(stmt, 11));
         
-        job.errorMessage = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 7));
-        job.progress = sqlite3_column_int(stmt, 8);
-        jobs.push_back(job);
+        found = true;
     }
     
     sqlite3_finalize(stmt);
-    return jobs;
+    return found;
 }
 
 //==============================================================================
@@ -1490,21 +3007,59 @@ bool DatabaseManager::beginTransaction()
 {
     const juce::ScopedLock lock(dbMutex);
     
-    return executeSQL("BEGIN TRANSACTION");
+    if (!executeSQL("BEGIN TRANSACTION"))
+        return false;
+    
+    // Hold the lock past this call until the transaction ends
+    dbMutex.enter();
+    transactionLockHeld = true;
+    return true;
 }
 
 bool DatabaseManager::commitTransaction()
 {
     const juce::ScopedLock lock(dbMutex);
     
-    return executeSQL("COMMIT");
+    bool committed = executeSQL("COMMIT");
+    
+    // A failed COMMIT can leave the transaction open; the caller must roll back then
+    if (db == nullptr || sqlite3_get_autocommit(db) != 0)
+        releaseTransactionLock();
+    
+    return committed;
 }
 
 bool DatabaseManager::rollbackTransaction()
 {
     const juce::ScopedLock lock(dbMutex);
     
-    return executeSQL("ROLLBACK");
+    bool rolledBack = executeSQL("ROLLBACK");
+    releaseTransactionLock();
+    
+    return rolledBack;
+}
+
+void DatabaseManager::releaseTransactionLock()
+{
+    const juce::ScopedLock lock(dbMutex);
+    
+    if (transactionLockHeld)
+    {
+        transactionLockHeld = false;
+        dbMutex.exit();
+    }
+}
+
+bool DatabaseManager::setDurability(Durability durability)
+{
+    switch (durability)
+    {
+        case Durability::full:   return executeSQL("PRAGMA synchronous = FULL");
+        case Durability::normal: return executeSQL("PRAGMA synchronous = NORMAL");
+        case Durability::off:    return executeSQL("PRAGMA synchronous = OFF");
+    }
+    
+    return false;
 }
 
 //==============================================================================
@@ -1873,10 +3428,7 @@ std::vector<DatabaseManager::Track> DatabaseManager::evaluateSmartPlaylist(const
         }
     }
     
-    juce::String sql = R"(
-        SELECT id, file_path, title, artist, album, genre, bpm, key, 
-               duration, file_size, file_hash, acoustid_fingerprint, date_added, last_modified
-        FROM Tracks )" + whereClause + " ORDER BY title";
+    juce::String sql = "SELECT " + trackColumns() + " FROM Tracks " + whereClause + " ORDER BY title";
     
     sqlite3_stmt* stmt = nullptr;
     int result = sqlite3_prepare_v2(db, sql.toRawUTF8(), -1, &stmt, nullptr);
@@ -1900,22 +3452,7 @@ std::vector<DatabaseManager::Track> DatabaseManager::evaluateSmartPlaylist(const
     
     while (sqlite3_step(stmt) == SQLITE_ROW)
     {
-        Track track;
-        track.id = sqlite3_column_int64(stmt, 0);
-        track.filePath = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 1));
-        track.title = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 2));
-        track.artist = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 3));
-        track.album = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 4));
-        track.genre = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 5));
-        track.bpm = sqlite3_column_int(stmt, 6);
-        track.key = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 7));
-        track.duration = sqlite3_column_double(stmt, 8);
-        track.fileSize = sqlite3_column_int64(stmt, 9);
-        track.fileHash = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 10));
-        track.acoustidFingerprint = juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 11));
-        track.dateAdded = stringToTime(juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 12)));
-        track.lastModified = stringToTime(juce::CharPointer_UTF8((const char*)sqlite3_column_text(stmt, 13)));
-        tracks.push_back(track);
+        tracks.push_back(readTrackRow(stmt));
     }
     
     sqlite3_finalize(stmt);
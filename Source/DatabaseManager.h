@@ -25,6 +25,7 @@
 #include <juce_core/juce_core.h>
 #include <juce_data_structures/juce_data_structures.h>
 #include <sqlite3.h>
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -49,13 +50,31 @@ public:
         juce::String album;
         juce::String genre;
         int bpm = 0;
+        double bpmPrecise = 0.0;     // Fractional tempo, detected or entered (0 if unknown)
+        double bpmConfidence = 0.0;  // 0-1; 1 for tempos entered by hand
         juce::String key;
         double duration = 0.0;
         int64_t fileSize = 0;
-        juce::String fileHash;
+        juce::String fileHash;       // Full-content hash, e.g. "xxh3:<32 hex digits>"
+        juce::String partialHash;    // Head + tail + size prefilter hash
+        juce::String fileIdentity;   // Filesystem identity (device:inode), survives renames
         juce::String acoustidFingerprint;
         juce::Time dateAdded;
         juce::Time lastModified;
+        double loudnessLufs = 0.0;   // EBU R128 integrated loudness; 0 if not analysed
+        double loudnessRange = 0.0;  // LU
+        double truePeakDb = 0.0;     // dBTP; only meaningful when loudnessLufs is set
+        double albumGainDb = 0.0;    // ReplayGain album gain, shared by the tracks of an album
+    };
+    
+    // Lightweight view of a track's on-disk identity, used for move detection
+    struct TrackLocation
+    {
+        int64_t id = 0;
+        juce::String filePath;
+        int64_t fileSize = 0;
+        juce::String fileIdentity;
+        juce::String partialHash;
     };
     
     struct VirtualFolder
@@ -82,12 +101,25 @@ public:
         int64_t id = 0;
         juce::String jobType;
         juce::String status;
+        juce::String filePath;  // Target file for file-based jobs; used to de-duplicate queued work
         juce::String parameters;
         juce::Time dateCreated;
         juce::Time dateStarted;
         juce::Time dateCompleted;
         juce::String errorMessage;
         int progress = 0;
+        int priority = 0;       // JobPriority; higher values are claimed first
+        juce::String leaseOwner;  // Worker holding a running job
+        juce::Time leaseExpires;  // A running job whose lease passes this is assumed lost
+        int attempts = 0;         // Times the job has been claimed
+    };
+    
+    // Scheduling priorities for analysis jobs
+    enum JobPriority
+    {
+        jobPriorityBackground  = 0,    // Library scans and imports
+        jobPriorityPlaylist    = 50,   // Tracks just added to a playlist
+        jobPriorityInteractive = 100   // Tracks the user has open right now
     };
     
     struct CuePoint
@@ -102,6 +134,69 @@ public:
         juce::Time dateCreated;
     };
 
+    // Downsampled waveform for display, stored so the UI never has to decode audio
+    struct WaveformOverview
+    {
+        int64_t trackId = 0;
+        double duration = 0.0;          // Track length in seconds
+        std::vector<int8_t> minMax;     // Interleaved min/max pairs per bin, scaled to -127..127
+        
+        int getNumBins() const { return static_cast<int>(minMax.size() / 2); }
+    };
+    
+    // A beat grid marker; the grid runs at its tempo until the next marker
+    struct BeatGridMarker
+    {
+        double position = 0.0;  // Position of a beat in seconds
+        double bpm = 0.0;
+        int beat = 1;           // Beat within the 4/4 bar at this position (1 = downbeat)
+    };
+    
+    // Beat grid written by the analysis pipeline: one marker for a steady tempo,
+    // or one per tempo segment
+    struct BeatGrid
+    {
+        int64_t trackId = 0;
+        std::vector<BeatGridMarker> markers;
+    };
+    
+    // Native spectral fingerprint (SpectralFingerprinter): one 32-bit word per frame
+    // of the first two minutes, compared by Hamming distance to find duplicates
+    struct AudioFingerprint
+    {
+        int64_t trackId = 0;
+        double duration = 0.0;          // Track length in seconds
+        std::vector<juce::uint32> bits;
+    };
+    
+    // Two tracks whose spectral fingerprints match, found by the analysis pipeline.
+    // Stored once per pair; getters orient it so trackId is the track asked about
+    struct DuplicateMatch
+    {
+        int64_t trackId = 0;
+        int64_t duplicateId = 0;
+        double bitErrorRate = 1.0;      // Lower is closer; copies stay below SpectralFingerprinter::matchThreshold
+    };
+    
+    // Analysis results for a recording, keyed by a hash of its audio payload so
+    // that copies differing only in their tags are analysed once
+    struct AnalysisCacheEntry
+    {
+        juce::String audioHash;      // FileHasher digest of TagReader::findAudioPayload()
+        double duration = 0.0;
+        juce::String fingerprint;    // Empty if fingerprinting was unavailable or failed
+        double bpm = 0.0;            // Detected tempo; 0 if none was found
+        double bpmConfidence = 0.0;
+        juce::String key;            // Detected key; empty if the file's tagged key was kept
+        double loudnessLufs = 0.0;   // 0 if not measured
+        double loudnessRange = 0.0;
+        double truePeakDb = 0.0;
+        WaveformOverview waveform;   // trackId unused
+        double gridBpm = 0.0;        // Tempo the beat grid was fitted to
+        std::vector<BeatGridMarker> beatGrid;
+        std::vector<juce::uint32> audioFingerprint;  // SpectralFingerprinter words
+    };
+
     //==============================================================================
     DatabaseManager();
     ~DatabaseManager();
@@ -132,6 +227,48 @@ public:
      */
     std::vector<Track> findTracksByFingerprint(const juce::String& fingerprint) const;
     
+    /**
+     * Find tracks whose content hash matches (byte-identical files).
+     * @param fileHash The hash string produced by FileHasher
+     * @param partial If true, match against partial_hash instead of file_hash
+     * @return Vector of tracks with matching hash
+     */
+    std::vector<Track> findTracksByFileHash(const juce::String& fileHash, bool partial = false) const;
+    
+    /**
+     * Get the track stored at an exact file path.
+     * @return The track, or a Track with id 0 if no track has that path
+     */
+    Track getTrackByPath(const juce::String& filePath) const;
+    
+    /**
+     * Get the tracks of one album: those tagged with the album name that sit directly in a folder.
+     * @param album The album name
+     * @param folder Full path of the folder holding the album's files
+     */
+    std::vector<Track> getTracksByAlbum(const juce::String& album, const juce::String& folder) const;
+    
+    /**
+     * Store the album gain on every analysed track of an album.
+     * @param album The album name
+     * @param folder Full path of the folder holding the album's files
+     * @param gainDb Album gain in dB
+     * @return true if successful
+     */
+    bool setAlbumGain(const juce::String& album, const juce::String& folder, double gainDb);
+    
+    /**
+     * Get the path, size and identity of every track, for matching moved files.
+     */
+    std::vector<TrackLocation> getTrackLocations() const;
+    
+    /**
+     * Point an existing track at a new file path (after a move or rename).
+     * Cue points, folder links and analysis results stay attached to the track;
+     * pending jobs for the old path are removed.
+     */
+    bool relinkTrack(int64_t trackId, const juce::String& newFilePath, const juce::String& fileIdentity);
+    
     //==============================================================================
     // CRUD operations for VirtualFolders
     
@@ -161,12 +298,82 @@ public:
     // CRUD operations for Jobs
     
     bool addJob(const Job& job, int64_t& outId);
+    
+    /**
+     * Add a job unless an equivalent one (same job type and file path) is already
+     * pending or running. Uses INSERT OR IGNORE against a partial unique index.
+     * @param job The job to enqueue (filePath should be set)
+     * @param outId Receives the new job ID, or 0 if the job was already queued
+     * @return False only if the insert itself failed
+     */
+    bool enqueueJob(const Job& job, int64_t& outId);
+    
     bool updateJob(const Job& job);
     bool deleteJob(int64_t jobId);
     Job getJob(int64_t jobId) const;
     std::vector<Job> getAllJobs() const;
     std::vector<Job> getJobsByStatus(const juce::String& status) const;
     
+    // Count jobs with the given status without loading them
+    int getJobCountByStatus(const juce::String& status) const;
+    
+    /**
+     * Atomically claim the next pending job: it is marked running (with
+     * date_started set) before any other thread can see it as pending.
+     * Jobs are taken by priority, then age, except that every
+     * backgroundClaimInterval-th claim takes the oldest job regardless of
+     * priority so background work keeps moving under a stream of UI requests.
+     * The claim is a lease: it counts as an attempt and expires after
+     * leaseSeconds unless renewJobLeases() extends it.
+     * @param outJob Receives the claimed job, already in the running state
+     * @param leaseOwner Identifies the claiming worker for renewJobLeases()
+     * @param leaseSeconds How long the claim holds without a renewal
+     * @param minPriority Only claim jobs of at least this priority (the
+     *                    background share is skipped for such claims)
+     * @return True if a job was claimed, false if none is pending
+     */
+    bool claimNextJob(Job& outJob, const juce::String& leaseOwner = {},
+                      int leaseSeconds = defaultLeaseSeconds,
+                      int minPriority = jobPriorityBackground);
+    
+    static constexpr int backgroundClaimInterval = 4;
+    static constexpr int defaultLeaseSeconds = 60;
+    
+    /**
+     * Extend the leases of all running jobs held by a worker (its heartbeat).
+     * @return The number of leases renewed, or -1 on error
+     */
+    int renewJobLeases(const juce::String& leaseOwner, int leaseSeconds = defaultLeaseSeconds);
+    
+    /**
+     * Recover running jobs whose lease has expired, left behind by a worker
+     * that crashed or was killed. They go back to pending, except jobs already
+     * claimed maxAttempts times: those are assumed to bring the analysis down
+     * and are marked failed.
+     * @param outRequeued Receives the number of jobs put back to pending
+     * @param outFailed Receives the number of jobs given up on
+     * @return False if the database could not be updated
+     */
+    bool recoverExpiredJobs(int maxAttempts, int& outRequeued, int& outFailed);
+    
+    static constexpr int defaultMaxJobAttempts = 3;
+    
+    /**
+     * Put a running job back to pending without counting the claim as an
+     * attempt, for work interrupted by shutdown or preemption rather than by
+     * anything wrong with the file.
+     * @return True if the job was running and has been requeued
+     */
+    bool releaseJob(int64_t jobId);
+    
+    /**
+     * Raise the priority of the pending jobs for a file (never lowers it).
+     * @param filePath The file whose queued analysis should run sooner
+     * @param priority The new JobPriority
+     * @return True if a pending job was found and raised
+     */
+    bool bumpJobPriority(const juce::String& filePath, int priority);
+    
     //==============================================================================
     // CRUD operations for CuePoints
     
@@ -177,13 +384,104 @@ public:
     std::vector<CuePoint> getCuePointsForTrack(int64_t trackId) const;
     bool deleteAllCuePointsForTrack(int64_t trackId);
     
+    //==============================================================================
+    // Waveform overviews (one per track, written by the analysis pipeline)
+    
+    bool saveWaveformOverview(const WaveformOverview& overview);
+    bool getWaveformOverview(int64_t trackId, WaveformOverview& outOverview) const;
+    
+    //==============================================================================
+    // Beat grids (one per track, written by the analysis pipeline)
+    
+    /** Stores a track's grid, replacing any previous one; an empty grid removes it. */
+    bool saveBeatGrid(const BeatGrid& grid);
+    bool getBeatGrid(int64_t trackId, BeatGrid& outGrid) const;
+    
+    //==============================================================================
+    // Audio fingerprints (one per track, written by the analysis pipeline)
+    
+    bool saveAudioFingerprint(const AudioFingerprint& fingerprint);
+    bool getAudioFingerprint(int64_t trackId, AudioFingerprint& outFingerprint) const;
+    
+    /**
+     * numFrames words of every stored fingerprint, starting at startFrame or as
+     * close to it as the fingerprint's length allows; shorter fingerprints are
+     * left out. Reads only the excerpts, for building a FingerprintIndex.
+     */
+    std::vector<AudioFingerprint> getAudioFingerprintExcerpts(int startFrame, int numFrames) const;
+    
+    //==============================================================================
+    // Duplicate matches (written with each analysed track's fingerprint)
+    
+    /**
+     * Store the duplicates found for a track, replacing every match it had so far
+     * (in either direction), since its audio may have changed; an empty list clears them.
+     * @param trackId The analysed track; the matches' own trackId is ignored
+     */
+    bool saveDuplicateMatches(int64_t trackId, const std::vector<DuplicateMatch>& matches);
+    
+    /** The matches of one track, with trackId set to it, closest first. */
+    std::vector<DuplicateMatch> getDuplicateMatches(int64_t trackId) const;
+    
+    /** Every stored pair, closest first, e.g. for a duplicates list. */
+    std::vector<DuplicateMatch> getAllDuplicateMatches() const;
+    
+    //==============================================================================
+    // Analysis cache (results shared by every copy of the same audio)
+    
+    /** Stores an entry, replacing any previous one for the same audio hash. */
+    bool saveAnalysisCacheEntry(const AnalysisCacheEntry& entry);
+    
+    /**
+     * Look up the analysis of a recording.
+     * @return False if there is no entry for the hash, or it was written by an
+     *         older analysisCacheVersion
+     */
+    bool getAnalysisCacheEntry(const juce::String& audioHash, AnalysisCacheEntry& outEntry) const;
+    
+    // Bump whenever an analyser's results change, so older entries are recomputed
+    static constexpr int analysisCacheVersion = 2;
+    
+    //==============================================================================
+    // Change notifications
+    
+    /**
+     * Set a callback raised whenever a commit adds a job, raises a queued job's
+     * priority or puts one back to pending, whichever code path made the change.
+     * It is passed the highest JobPriority the commit made available. It runs on
+     * the committing thread inside SQLite's commit hook with the database lock
+     * held, so it must not call back into the DatabaseManager; use it to wake
+     * another thread.
+     */
+    void setJobAvailableCallback(std::function<void(int highestPriority)> callback);
+    
     //==============================================================================
     // Transaction support
     
+    /**
+     * Begin a transaction. The calling thread keeps the database lock until
+     * commitTransaction() or rollbackTransaction(), so statements from other
+     * threads cannot slip into (or fail inside) someone else's transaction.
+     * Keep transactions short: every other database call waits for them.
+     */
     bool beginTransaction();
     bool commitTransaction();
     bool rollbackTransaction();
     
+    // How hard a commit works to survive power loss (PRAGMA synchronous)
+    enum class Durability
+    {
+        full,    // fsync on every commit
+        normal,  // WAL default: fsync only at checkpoints; a crash can lose the last commits but never corrupts
+        off      // Leave flushing to the OS entirely
+    };
+    
+    /**
+     * Set the durability of subsequent commits. The database is opened in WAL
+     * mode with Durability::normal.
+     */
+    bool setDurability(Durability durability);
+    
     // Get last error message
     juce::String getLastError() const;
 
@@ -193,10 +491,47 @@ private:
     juce::String lastError;
     mutable juce::CriticalSection dbMutex;  // Thread safety for database operations
     
+    // Job-available signalling (hooks run with dbMutex held)
+    std::function<void(int)> jobAvailableCallback;
+    int claimCount = 0;                // Drives the background share in claimNextJob
+    bool transactionLockHeld = false;  // beginTransaction() entered dbMutex an extra time
+    bool jobsBecameAvailable = false;  // Set by the update hook, raised on commit
+    int availablePriority = jobPriorityBackground;  // Highest priority made available since the last commit
+    
+    static void onRowChanged(void* context, int operation, const char* database,
+                             const char* table, sqlite3_int64 rowId);
+    static int onCommit(void* context);
+    static void onRollback(void* context);
+    
     // Helper methods
     bool createTables();
+    bool createWaveformOverviewsTable();
+    bool createBeatGridsTable();
+    bool createAnalysisCacheTable();
+    bool createAudioFingerprintsTable();
+    bool createDuplicateMatchesTable();
+    void releaseTransactionLock();
     bool executeSQL(const juce::String& sql);
     bool checkTableExists(const juce::String& tableName) const;
+    bool checkColumnExists(const juce::String& tableName, const juce::String& columnName) const;
+    bool migrateJobsFilePath();
+    bool bumpJobPriorityLocked(const juce::String& filePath, int priority);
+    bool insertJob(const Job& job, int64_t& outId, bool ignoreIfQueued);
+    
+    // Shared column list and row reader for the Tracks SELECT statements
+    static juce::String trackColumns(const juce::String& tableAlias = {});
+    static Track readTrackRow(sqlite3_stmt* stmt);
+    
+    // Shared row reader for the Jobs SELECT statements (columns in jobColumns order)
+    static const char* const jobColumns;
+    static Job readJobRow(sqlite3_stmt* stmt);
+    
+    // BLOB encodings, shared by the tables and the analysis cache:
+    // beat grid markers take 17 bytes each, fingerprint words 4 little-endian bytes
+    static void writeBeatGridMarkers(const std::vector<BeatGridMarker>& markers, juce::MemoryOutputStream& out);
+    static std::vector<BeatGridMarker> readBeatGridMarkers(const void* data, size_t size, int numMarkers);
+    static void writeFingerprintBits(const std::vector<juce::uint32>& bits, juce::MemoryOutputStream& out);
+    static std::vector<juce::uint32> readFingerprintBits(const void* data, size_t size);
     
     // Helper for converting JUCE Time to SQLite timestamp
     static juce::String timeToString(const juce::Time& time);
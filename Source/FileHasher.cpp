@@ -0,0 +1,408 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+#include "FileHasher.h"
+
+#if JUCE_WINDOWS
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#ifdef HAVE_XXHASH
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+#endif
+
+//==============================================================================
+/**
+    Streaming 128-bit digest. Wraps XXH3-128 when available, otherwise runs a
+    4-lane multiply/rotate hash over 32-byte stripes (the XXH64 round function)
+    and derives two independent 64-bit outputs from the lane state.
+*/
+class FileHasher::Digest
+{
+public:
+    Digest()
+    {
+       #ifdef HAVE_XXHASH
+        XXH3_128bits_reset(&state);
+       #else
+        lanes[0] = prime1 + prime2;
+        lanes[1] = prime2;
+        lanes[2] = 0;
+        lanes[3] = 0 - prime1;
+       #endif
+    }
+
+    void update(const void* data, size_t size)
+    {
+       #ifdef HAVE_XXHASH
+        XXH3_128bits_update(&state, data, size);
+       #else
+        auto* input = static_cast<const juce::uint8*>(data);
+        totalLength += size;
+
+        // Top up a partially filled stripe first
+        if (buffered > 0)
+        {
+            auto toCopy = juce::jmin(size, stripeSize - buffered);
+            std::memcpy(buffer + buffered, input, toCopy);
+            buffered += toCopy;
+            input += toCopy;
+            size -= toCopy;
+
+            if (buffered < stripeSize)
+                return;
+
+            consumeStripe(buffer);
+            buffered = 0;
+        }
+
+        while (size >= stripeSize)
+        {
+            consumeStripe(input);
+            input += stripeSize;
+            size -= stripeSize;
+        }
+
+        if (size > 0)
+        {
+            std::memcpy(buffer, input, size);
+            buffered = size;
+        }
+       #endif
+    }
+
+    juce::String toString() const
+    {
+        juce::uint8 bytes[16];
+
+       #ifdef HAVE_XXHASH
+        XXH128_canonical_t canonical;
+        XXH128_canonicalFromHash(&canonical, XXH3_128bits_digest(&state));
+        std::memcpy(bytes, canonical.digest, sizeof(bytes));
+       #else
+        auto high = finalise(rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18));
+        auto low  = finalise(rotl(lanes[0], 18) + rotl(lanes[1], 12) + rotl(lanes[2], 7) + rotl(lanes[3], 1) + prime5);
+
+        for (int i = 0; i < 8; ++i)
+        {
+            bytes[i]     = (juce::uint8) (high >> (56 - 8 * i));
+            bytes[8 + i] = (juce::uint8) (low  >> (56 - 8 * i));
+        }
+       #endif
+
+        return FileHasher::getAlgorithmName() + ":" + juce::String::toHexString(bytes, (int) sizeof(bytes), 0);
+    }
+
+private:
+   #ifdef HAVE_XXHASH
+    XXH3_state_t state;
+   #else
+    static constexpr juce::uint64 prime1 = 0x9E3779B185EBCA87ULL;
+    static constexpr juce::uint64 prime2 = 0xC2B2AE3D27D4EB4FULL;
+    static constexpr juce::uint64 prime3 = 0x165667B19E3779F9ULL;
+    static constexpr juce::uint64 prime4 = 0x85EBCA77C2B2AE63ULL;
+    static constexpr juce::uint64 prime5 = 0x27D4EB2F165667C5ULL;
+    static constexpr size_t stripeSize = 32;
+
+    static juce::uint64 rotl(juce::uint64 x, int r) noexcept  { return (x << r) | (x >> (64 - r)); }
+
+    static juce::uint64 round(juce::uint64 acc, juce::uint64 input) noexcept
+    {
+        acc += input * prime2;
+        acc = rotl(acc, 31);
+        return acc * prime1;
+    }
+
+    void consumeStripe(const juce::uint8* stripe) noexcept
+    {
+        for (int i = 0; i < 4; ++i)
+            lanes[i] = round(lanes[i], juce::ByteOrder::littleEndianInt64(stripe + 8 * i));
+    }
+
+    juce::uint64 finalise(juce::uint64 h) const noexcept
+    {
+        for (auto lane : lanes)
+            h = (h ^ round(0, lane)) * prime1 + prime4;
+
+        h += (juce::uint64) totalLength;
+
+        // Remaining bytes of the final partial stripe
+        size_t i = 0;
+        for (; i + 8 <= buffered; i += 8)
+            h = rotl(h ^ round(0, juce::ByteOrder::littleEndianInt64(buffer + i)), 27) * prime1 + prime4;
+
+        for (; i < buffered; ++i)
+            h = rotl(h ^ (buffer[i] * prime5), 11) * prime1;
+
+        h ^= h >> 33;
+        h *= prime2;
+        h ^= h >> 29;
+        h *= prime3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    juce::uint64 lanes[4];
+    juce::uint8 buffer[stripeSize];
+    size_t buffered = 0;
+    juce::uint64 totalLength = 0;
+   #endif
+};
+
+//==============================================================================
+FileHasher::FileHasher()
+{
+}
+
+FileHasher::~FileHasher()
+{
+}
+
+juce::String FileHasher::getAlgorithmName()
+{
+   #ifdef HAVE_XXHASH
+    return "xxh3";
+   #else
+    return "lane128";
+   #endif
+}
+
+juce::String FileHasher::getFileIdentity(const juce::File& file)
+{
+   #if JUCE_WINDOWS
+    auto handle = CreateFileW(file.getFullPathName().toWideCharPointer(), 0,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+
+    if (handle == INVALID_HANDLE_VALUE)
+        return {};
+
+    BY_HANDLE_FILE_INFORMATION info;
+    auto ok = GetFileInformationByHandle(handle, &info);
+    CloseHandle(handle);
+
+    if (!ok)
+        return {};
+
+    auto fileIndex = ((juce::uint64) info.nFileIndexHigh << 32) | info.nFileIndexLow;
+    return juce::String((juce::uint64) info.dwVolumeSerialNumber) + ":" + juce::String(fileIndex);
+   #else
+    struct stat info;
+
+    if (stat(file.getFullPathName().toRawUTF8(), &info) != 0)
+        return {};
+
+    return juce::String((juce::uint64) info.st_dev) + ":" + juce::String((juce::uint64) info.st_ino);
+   #endif
+}
+
+//==============================================================================
+bool FileHasher::hashFile(const juce::File& file, juce::String& outHash)
+{
+    if (!file.existsAsFile())
+    {
+        lastError = "File does not exist: " + file.getFullPathName();
+        DBG("[FileHasher] " << lastError);
+        return false;
+    }
+
+    Digest digest;
+
+    if (!hashRange(file, 0, file.getSize(), digest))
+        return false;
+
+    outHash = digest.toString();
+    return true;
+}
+
+bool FileHasher::hashFile(const juce::File& file, juce::String& outHash,
+                          juce::Range<juce::int64> payloadRange, juce::String& outAudioHash)
+{
+    if (!file.existsAsFile())
+    {
+        lastError = "File does not exist: " + file.getFullPathName();
+        DBG("[FileHasher] " << lastError);
+        return false;
+    }
+
+    const auto fileSize = file.getSize();
+
+    Digest digest, payloadDigest;
+    audioDigest = &payloadDigest;
+    audioRange = payloadRange.getIntersectionWith({ 0, fileSize });
+
+    const bool ok = hashRange(file, 0, fileSize, digest);
+    audioDigest = nullptr;
+
+    if (!ok)
+        return false;
+
+    outHash = digest.toString();
+    outAudioHash = payloadDigest.toString();
+    return true;
+}
+
+bool FileHasher::hashFilePartial(const juce::File& file, juce::String& outHash)
+{
+    if (!file.existsAsFile())
+    {
+        lastError = "File does not exist: " + file.getFullPathName();
+        DBG("[FileHasher] " << lastError);
+        return false;
+    }
+
+    const auto fileSize = file.getSize();
+
+    // The size goes in first so that files sharing head and tail but differing
+    // in length never collide
+    Digest digest;
+    juce::uint8 sizeBytes[8];
+    for (int i = 0; i < 8; ++i)
+        sizeBytes[i] = (juce::uint8) ((juce::uint64) fileSize >> (8 * i));
+    digest.update(sizeBytes, sizeof(sizeBytes));
+
+    bool ok = true;
+
+    if (fileSize <= 2 * partialChunkSize)
+    {
+        ok = hashRange(file, 0, fileSize, digest);
+    }
+    else
+    {
+        ok = hashRange(file, 0, partialChunkSize, digest)
+          && hashRange(file, fileSize - partialChunkSize, fileSize, digest);
+    }
+
+    if (!ok)
+        return false;
+
+    outHash = digest.toString();
+    return true;
+}
+
+//==============================================================================
+bool FileHasher::hashRange(const juce::File& file, juce::int64 start, juce::int64 end, Digest& digest)
+{
+    for (auto position = start; position < end;)
+    {
+        auto windowEnd = juce::jmin(end, position + mappedWindowSize);
+        juce::MemoryMappedFile mapped(file, juce::Range<juce::int64>(position, windowEnd),
+                                      juce::MemoryMappedFile::readOnly);
+
+        // JUCE rounds the mapped start down to a page boundary, so the data we asked
+        // for may begin part-way into the mapping
+        auto mappedRange = mapped.getRange();
+
+        // Mapping can fail (network shares, exotic filesystems); fall back to plain reads
+        if (mapped.getData() == nullptr || mappedRange.getStart() > position || mappedRange.getEnd() <= position)
+            return hashRangeBuffered(file, position, end, digest);
+
+        auto offset = position - mappedRange.getStart();
+        auto length = juce::jmin(windowEnd, mappedRange.getEnd()) - position;
+        auto* data = static_cast<const char*>(mapped.getData()) + offset;
+
+        // Pages are read as the digest touches them, so pace the window in chunks
+        for (juce::int64 done = 0; done < length;)
+        {
+            auto chunk = juce::jmin(readChunkSize, length - done);
+
+            if (!beforeRead(file, chunk))
+                return false;
+
+            consume(digest, data + done, chunk, position + done);
+            done += chunk;
+        }
+
+        position += length;
+    }
+
+    return true;
+}
+
+bool FileHasher::beforeRead(const juce::File& file, juce::int64 numBytes)
+{
+    if (CancellationToken::shouldStop(cancellation))
+    {
+        lastError = "Hashing cancelled: " + file.getFullPathName();
+        DBG("[FileHasher] " << lastError);
+        return false;
+    }
+
+    if (readThrottle)
+        readThrottle(numBytes);
+
+    return true;
+}
+
+void FileHasher::consume(Digest& digest, const char* data, juce::int64 size, juce::int64 position)
+{
+    digest.update(data, (size_t) size);
+
+    if (audioDigest == nullptr)
+        return;
+
+    auto overlap = audioRange.getIntersectionWith({ position, position + size });
+
+    if (!overlap.isEmpty())
+        audioDigest->update(data + (overlap.getStart() - position), (size_t) overlap.getLength());
+}
+
+bool FileHasher::hashRangeBuffered(const juce::File& file, juce::int64 start, juce::int64 end, Digest& digest)
+{
+    juce::FileInputStream stream(file);
+
+    if (stream.failedToOpen() || !stream.setPosition(start))
+    {
+        lastError = "Could not open file for hashing: " + file.getFullPathName();
+        DBG("[FileHasher] " << lastError);
+        return false;
+    }
+
+    constexpr int bufferSize = (int) readChunkSize;
+    if (readBuffer.get() == nullptr)
+        readBuffer.malloc(bufferSize);
+
+    for (auto remaining = end - start; remaining > 0;)
+    {
+        auto bytesToRead = juce::jmin((juce::int64) bufferSize, remaining);
+
+        if (!beforeRead(file, bytesToRead))
+            return false;
+
+        auto bytesRead = stream.read(readBuffer.get(), (int) bytesToRead);
+
+        if (bytesRead <= 0)
+        {
+            lastError = "Unexpected end of file while hashing: " + file.getFullPathName();
+            DBG("[FileHasher] " << lastError);
+            return false;
+        }
+
+        consume(digest, readBuffer.get(), bytesRead, end - remaining);
+        remaining -= bytesRead;
+    }
+
+    return true;
+}
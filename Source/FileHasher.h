@@ -0,0 +1,144 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <functional>
+#include "CancellationToken.h"
+
+//==============================================================================
+/**
+    FileHasher computes fast non-cryptographic 128-bit content hashes for audio
+    files so that byte-identical duplicates and moved files can be recognised
+    without decoding any audio.
+
+    When the xxHash library is available the hash is XXH3-128 (SIMD accelerated);
+    otherwise a built-in 4-lane 64-bit mixing hash is used. Hash strings carry an
+    algorithm prefix (e.g. "xxh3:...") so values produced by different builds are
+    never mistaken for each other.
+
+    Files are read through large memory-mapped windows, falling back to buffered
+    sequential reads if mapping fails.
+*/
+class FileHasher
+{
+public:
+    //==============================================================================
+    FileHasher();
+    ~FileHasher();
+
+    /**
+     * Hash the entire contents of a file.
+     * @param file The file to hash
+     * @param outHash Receives the prefixed hex digest
+     * @return True on success, false if the file could not be read
+     */
+    bool hashFile(const juce::File& file, juce::String& outHash);
+
+    /**
+     * Hash the entire contents of a file and, in the same pass, the byte range
+     * holding its audio (see TagReader::findAudioPayload()). The audio hash does
+     * not change when only the file's tags do.
+     * @param file The file to hash
+     * @param outHash Receives the prefixed hex digest of the whole file
+     * @param payloadRange The range to hash separately, clipped to the file
+     * @param outAudioHash Receives the prefixed hex digest of that range
+     * @return True on success, false if the file could not be read
+     */
+    bool hashFile(const juce::File& file, juce::String& outHash,
+                  juce::Range<juce::int64> payloadRange, juce::String& outAudioHash);
+
+    /**
+     * Cheap prefilter hash over the file size, the first and the last
+     * partialChunkSize bytes. Equal partial hashes only mean "possibly identical";
+     * confirm with hashFile() before treating files as duplicates.
+     * @param file The file to hash
+     * @param outHash Receives the prefixed hex digest
+     * @return True on success, false if the file could not be read
+     */
+    bool hashFilePartial(const juce::File& file, juce::String& outHash);
+
+    /**
+     * Filesystem identity of a file: "device:inode" on POSIX systems, or
+     * "volume serial:file index" on Windows. A renamed or moved file keeps its
+     * identity as long as it stays on the same volume, so this lets the scanner
+     * recognise moves without reading any file data.
+     * @return The identity string, or an empty string if it could not be read
+     */
+    static juce::String getFileIdentity(const juce::File& file);
+
+    /**
+     * Algorithm prefix used for hash strings produced by this build.
+     */
+    static juce::String getAlgorithmName();
+
+    /**
+     * Set a function called before each read with the number of bytes about to
+     * be read. It may block to pace disk I/O.
+     */
+    void setReadThrottle(std::function<void(juce::int64 numBytes)> throttle) { readThrottle = std::move(throttle); }
+
+    /**
+     * Set a token checked between reads; once it is cancelled, hashing stops
+     * within readChunkSize bytes and fails. The token is not owned.
+     */
+    void setCancellationToken(const CancellationToken* token) { cancellation = token; }
+
+    /**
+     * Get the last error message.
+     */
+    juce::String getLastError() const { return lastError; }
+
+    // Bytes taken from each end of the file for partial hashes
+    static constexpr juce::int64 partialChunkSize = 64 * 1024;
+
+    // Size of each memory-mapped window when hashing whole files
+    static constexpr juce::int64 mappedWindowSize = 16 * 1024 * 1024;
+
+    // Largest read between two throttle or cancellation checks
+    static constexpr juce::int64 readChunkSize = 1024 * 1024;
+
+private:
+    //==============================================================================
+    class Digest;
+
+    // Called before each chunk; false if hashing was cancelled
+    bool beforeRead(const juce::File& file, juce::int64 numBytes);
+
+    // Feed bytes read from the given file position into the digest, and the part
+    // inside audioRange into audioDigest if one is set
+    void consume(Digest& digest, const char* data, juce::int64 size, juce::int64 position);
+
+    // Feed the byte range [start, end) of a file into the digest
+    bool hashRange(const juce::File& file, juce::int64 start, juce::int64 end, Digest& digest);
+    bool hashRangeBuffered(const juce::File& file, juce::int64 start, juce::int64 end, Digest& digest);
+
+    juce::String lastError;
+    juce::HeapBlock<char> readBuffer;
+    std::function<void(juce::int64)> readThrottle;
+    const CancellationToken* cancellation = nullptr;
+    Digest* audioDigest = nullptr;
+    juce::Range<juce::int64> audioRange;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FileHasher)
+};
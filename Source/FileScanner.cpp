@@ -21,6 +21,70 @@
 */
 
 #include "FileScanner.h"
+#include "FileHasher.h"
+#include <map>
+#include <set>
+
+namespace
+{
+    /**
+        The folder the volume holding a file is mounted at: the drive or share on
+        Windows, a folder under /Volumes, /media, /run/media or /mnt elsewhere.
+        Returns an invalid File for files on the system volume.
+    */
+    juce::File getMountPoint(const juce::File& file)
+    {
+        auto segments = juce::StringArray::fromTokens(file.getFullPathName(), juce::File::getSeparatorString(), {});
+        segments.removeEmptyStrings();
+        
+       #if JUCE_WINDOWS
+        // \\server\share\... or C:\...
+        const bool isShare = file.getFullPathName().startsWith("\\\\");
+        const int depth = isShare ? 2 : 1;
+        
+        if (segments.size() < depth)
+            return {};
+        
+        return juce::File((isShare ? "\\\\" : "") + segments.joinIntoString("\\", 0, depth) + "\\");
+       #else
+        // Depth of the mount point below each folder removable volumes are mounted in
+        int depth = 0;
+        
+        if (segments[0] == "Volumes" || segments[0] == "mnt")
+            depth = 2;
+        else if (segments[0] == "media")
+            depth = 3;
+        else if (segments[0] == "run" && segments[1] == "media")
+            depth = 4;
+        
+        if (depth == 0 || segments.size() <= depth)
+            return {};
+        
+        return juce::File("/" + segments.joinIntoString("/", 0, depth));
+       #endif
+    }
+    
+    /** False while the volume a track lives on is unplugged or unmounted. */
+    bool isVolumeMounted(const juce::File& file, std::map<juce::String, bool>& mountedCache)
+    {
+        const auto mountPoint = getMountPoint(file);
+        
+        if (mountPoint == juce::File())
+            return true;
+        
+        auto cached = mountedCache.find(mountPoint.getFullPathName());
+        
+        if (cached != mountedCache.end())
+            return cached->second;
+        
+        // An empty mount point folder is left behind when a volume is unmounted
+        const bool mounted = mountPoint.isDirectory()
+                          && mountPoint.getNumberOfChildFiles(juce::File::findFilesAndDirectories) > 0;
+        
+        mountedCache[mountPoint.getFullPathName()] = mounted;
+        return mounted;
+    }
+}
 
 //==============================================================================
 FileScanner::FileScanner(DatabaseManager& dbManager)
@@ -74,45 +138,62 @@ int FileScanner::scanDirectory(const juce::File& directory, bool recursive)
     
     DBG("[FileScanner] Found " << foundFiles.size() << " audio files");
     
-    // Create jobs in a transaction for better performance
-    int jobsCreated = 0;
+    // Files that are library tracks moved from elsewhere are relinked, not re-analysed
+    const int tracksRelinked = relinkMovedFiles(foundFiles);
     
-    if (!databaseManager.beginTransaction())
-    {
-        DBG("[FileScanner] Error: Failed to begin transaction");
-        return 0;
-    }
+    // Create jobs in chunked transactions: batching keeps inserts fast, and
+    // committing every chunk releases the database to the analysis workers
+    // (and wakes them) instead of holding it for the whole scan
+    int jobsCreated = 0;
     
-    for (size_t i = 0; i < foundFiles.size(); ++i)
+    for (size_t chunkStart = 0; chunkStart < foundFiles.size(); chunkStart += jobsPerTransaction)
     {
         if (shouldCancel)
             break;
+        
+        if (!databaseManager.beginTransaction())
+        {
+            DBG("[FileScanner] Error: Failed to begin transaction");
+            return jobsCreated;
+        }
+        
+        const size_t chunkEnd = juce::jmin(foundFiles.size(), chunkStart + (size_t) jobsPerTransaction);
+        int chunkJobs = 0;
+        
+        for (size_t i = chunkStart; i < chunkEnd && !shouldCancel; ++i)
+        {
+            if (createJobForFile(foundFiles[i]))
+            {
+                chunkJobs++;
+            }
             
-        if (createJobForFile(foundFiles[i]))
+            if (progressCallback)
+            {
+                progressCallback(static_cast<int>(i + 1), static_cast<int>(foundFiles.size()));
+            }
+        }
+        
+        if (shouldCancel)
         {
-            jobsCreated++;
+            databaseManager.rollbackTransaction();
+            DBG("[FileScanner] Scan cancelled, rolled back the current chunk ("
+                << jobsCreated << " jobs already queued)");
+            return jobsCreated;
         }
         
-        if (progressCallback)
+        if (!databaseManager.commitTransaction())
         {
-            progressCallback(static_cast<int>(i + 1), static_cast<int>(foundFiles.size()));
+            DBG("[FileScanner] Error: Failed to commit transaction");
+            databaseManager.rollbackTransaction();
+            return jobsCreated;
         }
+        
+        jobsCreated += chunkJobs;
     }
     
-    if (shouldCancel)
-    {
-        databaseManager.rollbackTransaction();
-        DBG("[FileScanner] Scan cancelled, rolled back transaction");
-        return 0;
-    }
-    
-    if (!databaseManager.commitTransaction())
-    {
-        DBG("[FileScanner] Error: Failed to commit transaction");
-        return 0;
-    }
-    
-    DBG("[FileScanner] Created " << jobsCreated << " pending jobs");
+    DBG("[FileScanner] Created " << jobsCreated << " pending jobs ("
+        << (static_cast<int>(foundFiles.size()) - jobsCreated) << " already queued, "
+        << tracksRelinked << " moved tracks relinked)");
     return jobsCreated;
 }
 
@@ -161,11 +242,168 @@ void FileScanner::scanDirectoryInternal(const juce::File& directory, bool recurs
     }
 }
 
-bool FileScanner::createJobForFile(const juce::File& audioFile)
+std::vector<FileScanner::Move> FileScanner::findMovedFiles(const std::vector<juce::File>& foundFiles)
+{
+    std::vector<Move> moves;
+    auto locations = databaseManager.getTrackLocations();
+    
+    std::set<juce::String> knownPaths;
+    for (const auto& location : locations)
+        knownPaths.insert(location.filePath);
+    
+    std::vector<size_t> unknownFiles;
+    for (size_t i = 0; i < foundFiles.size(); ++i)
+    {
+        if (knownPaths.count(foundFiles[i].getFullPathName()) == 0)
+            unknownFiles.push_back(i);
+    }
+    
+    if (unknownFiles.empty())
+        return moves;
+    
+    // Tracks whose file is gone are the only possible move sources, bucketed by size.
+    // Tracks on an unplugged drive are offline, not gone, and keep their path.
+    std::multimap<int64_t, const DatabaseManager::TrackLocation*> vanishedBySize;
+    std::map<juce::String, bool> mountedVolumes;
+    
+    for (const auto& location : locations)
+    {
+        const juce::File trackFile(location.filePath);
+        
+        if (!trackFile.existsAsFile() && isVolumeMounted(trackFile, mountedVolumes))
+            vanishedBySize.emplace(location.fileSize, &location);
+    }
+    
+    if (vanishedBySize.empty())
+        return moves;
+    
+    FileHasher hasher;
+    
+    for (auto index : unknownFiles)
+    {
+        if (shouldCancel || vanishedBySize.empty())
+            break;
+        
+        const auto& file = foundFiles[index];
+        auto candidates = vanishedBySize.equal_range(file.getSize());
+        
+        if (candidates.first == candidates.second)
+            continue;
+        
+        auto identity = FileHasher::getFileIdentity(file);
+        auto match = candidates.second;
+        
+        // Read at most once, and only when a candidate needs it
+        juce::String partialHash;
+        bool partialHashRead = false;
+        
+        auto getPartialHash = [&]() -> const juce::String&
+        {
+            if (!partialHashRead && !hasher.hashFilePartial(file, partialHash))
+                partialHash = {};
+            
+            partialHashRead = true;
+            return partialHash;
+        };
+        
+        // Same volume and inode: a plain rename or move. Inodes are reused after a delete,
+        // so the content must still match wherever a partial hash was recorded.
+        for (auto it = candidates.first; it != candidates.second && identity.isNotEmpty(); ++it)
+        {
+            if (it->second->fileIdentity == identity
+                && (it->second->partialHash.isEmpty() || it->second->partialHash == getPartialHash()))
+            {
+                match = it;
+                break;
+            }
+        }
+        
+        // Otherwise (copied across volumes, or identity not recorded yet) compare content
+        if (match == candidates.second)
+        {
+            if (getPartialHash().isNotEmpty())
+            {
+                for (auto it = candidates.first; it != candidates.second; ++it)
+                {
+                    if (it->second->partialHash == partialHash)
+                    {
+                        match = it;
+                        break;
+                    }
+                }
+            }
+        }
+        
+        if (match == candidates.second)
+            continue;
+        
+        DBG("[FileScanner] Detected move: " << match->second->filePath << " -> " << file.getFullPathName());
+        
+        moves.push_back({ index, match->second->id, identity });
+        vanishedBySize.erase(match);
+    }
+    
+    return moves;
+}
+
+int FileScanner::relinkMovedFiles(std::vector<juce::File>& foundFiles)
+{
+    // Stats and hashing happen above without the database lock; only the updates are in a transaction
+    const auto moves = findMovedFiles(foundFiles);
+    
+    if (moves.empty() || shouldCancel || !databaseManager.beginTransaction())
+        return 0;
+    
+    std::vector<bool> relinked(foundFiles.size(), false);
+    int relinkedCount = 0;
+    
+    for (const auto& move : moves)
+    {
+        if (databaseManager.relinkTrack(move.trackId, foundFiles[move.fileIndex].getFullPathName(), move.fileIdentity))
+        {
+            relinked[move.fileIndex] = true;
+            ++relinkedCount;
+        }
+    }
+    
+    if (!databaseManager.commitTransaction())
+    {
+        databaseManager.rollbackTransaction();
+        return 0;
+    }
+    
+    if (relinkedCount > 0)
+    {
+        std::vector<juce::File> remaining;
+        for (size_t i = 0; i < foundFiles.size(); ++i)
+        {
+            if (!relinked[i])
+                remaining.push_back(foundFiles[i]);
+        }
+        foundFiles.swap(remaining);
+    }
+    
+    return relinkedCount;
+}
+
+bool FileScanner::enqueueFile(const juce::File& audioFile, int priority)
+{
+    if (!audioFile.existsAsFile() || !isSupportedAudioFile(audioFile))
+    {
+        DBG("[FileScanner] Not a supported audio file: " << audioFile.getFullPathName());
+        return false;
+    }
+    
+    return createJobForFile(audioFile, priority);
+}
+
+bool FileScanner::createJobForFile(const juce::File& audioFile, int priority)
 {
     DatabaseManager::Job job;
     job.jobType = "analyze_audio";
     job.status = "pending";
+    job.filePath = audioFile.getFullPathName();
+    job.priority = priority;
     
     // Create JSON parameters
     juce::var paramsObj = new juce::DynamicObject();
@@ -177,14 +415,15 @@ bool FileScanner::createJobForFile(const juce::File& audioFile)
     job.dateCreated = juce::Time::getCurrentTime();
     job.progress = 0;
     
+    // Rescans and overlapping folders must not queue the same file twice
     int64_t jobId = 0;
-    if (!databaseManager.addJob(job, jobId))
+    if (!databaseManager.enqueueJob(job, jobId))
     {
         DBG("[FileScanner] Error: Failed to create job for: " << audioFile.getFullPathName());
         return false;
     }
     
-    return true;
+    return jobId != 0;
 }
 
 //==============================================================================
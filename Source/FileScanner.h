@@ -44,13 +44,30 @@ public:
     static const juce::StringArray& getSupportedExtensions();
     
     /**
-     * Recursively scan a directory for audio files.
+     * Recursively scan a directory for audio files. Files that turn out to be
+     * library tracks moved or renamed from a path that no longer exists are
+     * relinked in place instead of being queued for analysis.
      * @param directory The directory to scan
      * @param recursive If true, scan subdirectories recursively
-     * @return Number of files found and added to the job queue
+     * @return Number of files newly added to the job queue (files that already
+     *         have a pending or running job are skipped). Jobs are committed in
+     *         chunks of jobsPerTransaction, so a cancelled scan keeps the chunks
+     *         committed before the cancel.
      */
     int scanDirectory(const juce::File& directory, bool recursive = true);
     
+    static constexpr int jobsPerTransaction = 500;
+    
+    /**
+     * Queue a single file for analysis, e.g. one dropped on the main window.
+     * If the file is already queued its job is raised to the given priority.
+     * @param audioFile The file to analyse
+     * @param priority DatabaseManager::JobPriority for the job
+     * @return True if a new job was created
+     */
+    bool enqueueFile(const juce::File& audioFile,
+                     int priority = DatabaseManager::jobPriorityInteractive);
+    
     /**
      * Check if a file is a supported audio file.
      * @param file The file to check
@@ -79,8 +96,34 @@ private:
     void scanDirectoryInternal(const juce::File& directory, bool recursive, 
                               std::vector<juce::File>& foundFiles);
     
-    // Create a pending job for a file
-    bool createJobForFile(const juce::File& audioFile);
+    // A found file that is a library track moved from elsewhere
+    struct Move
+    {
+        size_t fileIndex = 0;       // Into foundFiles
+        int64_t trackId = 0;
+        juce::String fileIdentity;  // Of the new file
+    };
+    
+    /**
+     * Match newly seen files against library tracks whose file has vanished
+     * (same size, then same file identity or same partial hash; an identity match
+     * must also agree with the partial hash when one is stored). Tracks on a
+     * volume that is not mounted are offline and never matched. Only reads the
+     * database, so it runs without holding a transaction.
+     */
+    std::vector<Move> findMovedFiles(const std::vector<juce::File>& foundFiles);
+    
+    /**
+     * Relink the tracks findMovedFiles() matched to their new paths, in one short
+     * transaction. Relinked files are removed from foundFiles so they are not
+     * queued for analysis again.
+     * @return Number of tracks relinked
+     */
+    int relinkMovedFiles(std::vector<juce::File>& foundFiles);
+    
+    // Create a pending job for a file; returns false if it failed or was already queued
+    bool createJobForFile(const juce::File& audioFile,
+                          int priority = DatabaseManager::jobPriorityBackground);
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FileScanner)
 };
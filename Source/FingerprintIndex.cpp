@@ -0,0 +1,242 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+
+#include "FingerprintIndex.h"
+
+//==============================================================================
+FingerprintIndex::FingerprintIndex()
+{
+}
+
+FingerprintIndex::~FingerprintIndex()
+{
+}
+
+//==============================================================================
+bool FingerprintIndex::add(int64_t trackId, const std::vector<juce::uint32>& fingerprint)
+{
+    if ((int) fingerprint.size() < excerptFrames)
+    {
+        remove(trackId);
+        return false;
+    }
+
+    Entry entry;
+    entry.trackId = trackId;
+
+    const auto start = fingerprint.begin() + getExcerptStart((int) fingerprint.size());
+    std::copy(start, start + excerptFrames, entry.excerpt.begin());
+
+    // A mostly silent or stationary excerpt would only ever match other such tracks
+    if (std::count_if(entry.excerpt.begin(), entry.excerpt.end(), SpectralFingerprinter::isDegenerate) > maxDegenerateFrames)
+    {
+        remove(trackId);
+        return false;
+    }
+
+    const juce::ScopedLock sl(lock);
+
+    // The old excerpt's postings stay behind until the next compaction, pointing at a dead entry
+    auto existing = entryForTrack.find(trackId);
+
+    if (existing != entryForTrack.end())
+        entries[existing->second].trackId = 0;
+
+    const auto entryIndex = (juce::uint32) entries.size();
+    entries.push_back(entry);
+    entryForTrack[trackId] = entryIndex;
+    addPostings(entryIndex);
+
+    if (entries.size() > 2 * entryForTrack.size() + 1024)
+        compact();
+
+    return true;
+}
+
+void FingerprintIndex::remove(int64_t trackId)
+{
+    const juce::ScopedLock sl(lock);
+
+    auto existing = entryForTrack.find(trackId);
+
+    if (existing == entryForTrack.end())
+        return;
+
+    entries[existing->second].trackId = 0;
+    entryForTrack.erase(existing);
+}
+
+void FingerprintIndex::clear()
+{
+    const juce::ScopedLock sl(lock);
+
+    entries.clear();
+    entryForTrack.clear();
+
+    for (auto& table : buckets)
+        table.clear();
+}
+
+int FingerprintIndex::getNumTracks() const
+{
+    const juce::ScopedLock sl(lock);
+    return (int) entryForTrack.size();
+}
+
+//==============================================================================
+std::vector<FingerprintIndex::Match> FingerprintIndex::findMatches(const std::vector<juce::uint32>& fingerprint,
+                                                                   double maxBitErrorRate) const
+{
+    const int numFrames = (int) fingerprint.size();
+    std::vector<Match> matches;
+
+    if (numFrames < excerptFrames)
+        return matches;
+
+    const juce::ScopedLock sl(lock);
+
+    // One vote per bucket hit for (entry, position of the excerpt's first word in the query)
+    std::vector<juce::uint64> votes;
+
+    for (int frame = 0; frame < numFrames; ++frame)
+    {
+        if (SpectralFingerprinter::isDegenerate(fingerprint[(size_t) frame]))
+            continue;
+
+        for (int table = 0; table < numTables; ++table)
+        {
+            const auto bucket = buckets[(size_t) table].find(getKey(fingerprint[(size_t) frame], table));
+
+            if (bucket == buckets[(size_t) table].end())
+                continue;
+
+            for (auto posting : bucket->second)
+            {
+                const int position = frame - (int) (posting & 0xff);
+
+                if (position >= 0 && position + excerptFrames <= numFrames)
+                    votes.push_back((juce::uint64) (posting >> 8) << 32 | (juce::uint32) position);
+            }
+        }
+    }
+
+    // Sorting brings each candidate's votes together
+    std::sort(votes.begin(), votes.end());
+
+    // Verify each candidate at its voted position, give or take one word
+    std::unordered_map<int64_t, double> best;
+
+    for (size_t first = 0, last = 0; first < votes.size(); first = last)
+    {
+        const auto candidate = votes[first];
+
+        while (last < votes.size() && votes[last] == candidate)
+            ++last;
+
+        if ((int) (last - first) < minVotes || entries[(size_t) (candidate >> 32)].trackId == 0)
+            continue;
+
+        const auto& entry = entries[(size_t) (candidate >> 32)];
+        const int position = (int) (candidate & 0xffffffff);
+
+        for (int start = juce::jmax(0, position - 1); start <= juce::jmin(numFrames - excerptFrames, position + 1); ++start)
+        {
+            const int differingBits = SpectralFingerprinter::countDifferingBits(fingerprint.data() + start,
+                                                                                entry.excerpt.data(), excerptFrames);
+            const double bitErrorRate = differingBits / (32.0 * excerptFrames);
+
+            if (bitErrorRate >= maxBitErrorRate)
+                continue;
+
+            auto found = best.find(entry.trackId);
+
+            if (found == best.end())
+                best[entry.trackId] = bitErrorRate;
+            else
+                found->second = juce::jmin(found->second, bitErrorRate);
+        }
+    }
+
+    for (const auto& [trackId, bitErrorRate] : best)
+        matches.push_back({ trackId, bitErrorRate });
+
+    std::sort(matches.begin(), matches.end(),
+              [](const Match& a, const Match& b) { return a.bitErrorRate < b.bitErrorRate; });
+
+    return matches;
+}
+
+int FingerprintIndex::getExcerptStart(int numFrames)
+{
+    return juce::jlimit(0, juce::jmax(0, numFrames - excerptFrames), excerptStartFrame);
+}
+
+//==============================================================================
+juce::uint32 FingerprintIndex::getKey(juce::uint32 word, int table)
+{
+    // Each table samples a different run of bits: rotate, then keep the low keyBits
+    const int rotation = table * (32 / numTables);
+    const auto rotated = rotation == 0 ? word : (word >> rotation) | (word << (32 - rotation));
+    return rotated & ((1u << keyBits) - 1);
+}
+
+void FingerprintIndex::addPostings(juce::uint32 entryIndex)
+{
+    const auto& entry = entries[entryIndex];
+
+    for (int frame = 0; frame < excerptFrames; frame += keyStride)
+    {
+        if (SpectralFingerprinter::isDegenerate(entry.excerpt[(size_t) frame]))
+            continue;
+
+        for (int table = 0; table < numTables; ++table)
+            buckets[(size_t) table][getKey(entry.excerpt[(size_t) frame], table)].push_back(entryIndex << 8 | (juce::uint32) frame);
+    }
+}
+
+void FingerprintIndex::compact()
+{
+    // Rebuild without the replaced and removed entries
+    std::vector<Entry> live;
+    live.reserve(entryForTrack.size());
+
+    for (const auto& entry : entries)
+    {
+        if (entry.trackId != 0)
+            live.push_back(entry);
+    }
+
+    entries = std::move(live);
+    entryForTrack.clear();
+
+    for (auto& table : buckets)
+        table.clear();
+
+    for (juce::uint32 i = 0; i < (juce::uint32) entries.size(); ++i)
+    {
+        entryForTrack[entries[i].trackId] = i;
+        addPostings(i);
+    }
+
+    DBG("[FingerprintIndex] Compacted to " << (int) entries.size() << " tracks");
+}
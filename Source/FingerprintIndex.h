@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "SpectralFingerprinter.h"
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+//==============================================================================
+/**
+    In-memory near-duplicate search over SpectralFingerprinter fingerprints.
+
+    For every track the index keeps a 3-second excerpt of its fingerprint
+    (excerptFrames words, taken excerptStartFrame words after the music starts
+    so the intro is skipped). Every other excerpt word is hashed into
+    numTables locality-sensitive hash tables, each keyed by a different
+    keyBits-bit sample of the word's bits, so a word with a few flipped bits
+    still lands in the same bucket of at least one table.
+
+    Degenerate words (silence and stationary frames, see
+    SpectralFingerprinter::isDegenerate()) are never hashed or looked up, so
+    they cannot pile up in one bucket, and an excerpt with more than
+    maxDegenerateFrames of them is not indexed at all: the rest of its words
+    could not outweigh silence that every track shares.
+
+    findMatches() looks up every word of the query fingerprint, so an excerpt
+    is found wherever it lies in the query: copies with a different start
+    (trimmed or padded edits) match as well as re-encodes. Each bucket hit
+    votes for the excerpt's position in the query; excerpts with minVotes
+    votes at one position are verified by bit error rate, so only a handful
+    of the indexed tracks are ever compared bit by bit.
+
+    The index is thread-safe. Adding a track that is already indexed replaces
+    its excerpt.
+*/
+class FingerprintIndex
+{
+public:
+    //==============================================================================
+    struct Match
+    {
+        int64_t trackId = 0;
+        double bitErrorRate = 1.0;   // Over the track's excerpt, at the best alignment
+    };
+
+    //==============================================================================
+    FingerprintIndex();
+    ~FingerprintIndex();
+
+    /**
+     * Index a track, replacing any earlier fingerprint of it. Fingerprints
+     * shorter than excerptFrames, or whose excerpt is mostly degenerate, are
+     * not indexed and drop the track's earlier excerpt.
+     * @return True if the track was indexed
+     */
+    bool add(int64_t trackId, const std::vector<juce::uint32>& fingerprint);
+
+    void remove(int64_t trackId);
+    void clear();
+
+    int getNumTracks() const;
+
+    /**
+     * Find the indexed tracks whose excerpt occurs in the fingerprint.
+     * @return Matches below maxBitErrorRate, best first
+     */
+    std::vector<Match> findMatches(const std::vector<juce::uint32>& fingerprint,
+                                   double maxBitErrorRate = SpectralFingerprinter::matchThreshold) const;
+
+    /** First word of the excerpt kept for a fingerprint of this many words. */
+    static int getExcerptStart(int numFrames);
+
+    static constexpr int excerptStartFrame = 128;   // About 6 seconds
+    static constexpr int excerptFrames = 64;        // About 3 seconds
+    static constexpr int keyStride = 2;             // Every other excerpt word is hashed
+    static constexpr int numTables = 2;
+    static constexpr int keyBits = 20;
+    static constexpr int minVotes = 2;
+    static constexpr int maxDegenerateFrames = excerptFrames / 4;
+
+private:
+    //==============================================================================
+    struct Entry
+    {
+        int64_t trackId = 0;    // 0 once replaced or removed
+        std::array<juce::uint32, excerptFrames> excerpt {};
+    };
+
+    static juce::uint32 getKey(juce::uint32 word, int table);
+    void addPostings(juce::uint32 entryIndex);
+    void compact();
+
+    // Bucket postings are entry index << 8 | word within the excerpt
+    std::vector<Entry> entries;
+    std::unordered_map<int64_t, juce::uint32> entryForTrack;
+    std::array<std::unordered_map<juce::uint32, std::vector<juce::uint32>>, numTables> buckets;
+
+    mutable juce::CriticalSection lock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FingerprintIndex)
+};
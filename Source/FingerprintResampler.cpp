@@ -0,0 +1,182 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+
+#include "FingerprintResampler.h"
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    /** numTaps must be a multiple of FingerprintResampler::dotProductLanes. */
+    float dotProduct(const float* samples, const float* taps, int numTaps)
+    {
+        constexpr int lanes = FingerprintResampler::dotProductLanes;
+        float sums[lanes] = {};
+        
+        for (int i = 0; i < numTaps; i += lanes)
+        {
+            for (int lane = 0; lane < lanes; ++lane)
+                sums[lane] += samples[i + lane] * taps[i + lane];
+        }
+        
+        float total = 0.0f;
+        
+        for (int lane = 0; lane < lanes; ++lane)
+            total += sums[lane];
+        
+        return total;
+    }
+}
+
+//==============================================================================
+FingerprintResampler::FingerprintResampler()
+{
+}
+
+void FingerprintResampler::prepare(double sourceSampleRate, int numChannels)
+{
+    channels = numChannels;
+    
+    if (sourceSampleRate != sourceRate)
+    {
+        sourceRate = sourceSampleRate;
+        buildFilter();
+    }
+    
+    // Start with silence before the first sample, so the first output lands on it
+    numBuffered = halfLength - 1;
+    input.assign((size_t) numBuffered, 0.0f);
+    position = (double) numBuffered;
+}
+
+void FingerprintResampler::buildFilter()
+{
+    step = sourceRate > 0.0 ? sourceRate / outputSampleRate : 1.0;
+    
+    // Cut off just below the Nyquist frequency of the lower rate
+    const double cutoff = 0.45 / juce::jmax(step, 1.0);  // Cycles per input sample
+    halfLength = (int) std::ceil(zeroCrossings * juce::jmax(step, 1.0));
+    numTaps = (2 * halfLength + dotProductLanes - 1) / dotProductLanes * dotProductLanes;
+    
+    filter.assign((size_t) (numPhases * numTaps), 0.0f);
+    
+    for (int phase = 0; phase < numPhases; ++phase)
+    {
+        float* taps = filter.data() + phase * numTaps;
+        double sum = 0.0;
+        
+        for (int tap = 0; tap < numTaps; ++tap)
+        {
+            // Distance of this tap's input sample from the output position
+            const double t = tap - (halfLength - 1) - (double) phase / numPhases;
+            const double x = t / halfLength;
+            
+            if (std::abs(x) >= 1.0)
+                continue;
+            
+            const double sinc = t == 0.0 ? 1.0 : std::sin(juce::MathConstants<double>::twoPi * cutoff * t)
+                                                     / (juce::MathConstants<double>::twoPi * cutoff * t);
+            const double blackman = 0.42 + 0.5 * std::cos(juce::MathConstants<double>::pi * x)
+                                         + 0.08 * std::cos(juce::MathConstants<double>::twoPi * x);
+            
+            taps[tap] = (float) (sinc * blackman);
+            sum += taps[tap];
+        }
+        
+        // Unity gain at DC for every phase
+        if (sum > 0.0)
+            juce::FloatVectorOperations::multiply(taps, (float) (1.0 / sum), numTaps);
+    }
+}
+
+int FingerprintResampler::process(const juce::AudioBuffer<float>& block, int numSamples)
+{
+    const int numChannels = juce::jmin(channels, block.getNumChannels());
+    
+    if (numChannels <= 0 || numSamples <= 0)
+        return 0;
+    
+    // Downmix after whatever the filter has not consumed yet
+    if ((int) input.size() < numBuffered + numSamples)
+        input.resize((size_t) (numBuffered + numSamples));
+    
+    float* mono = input.data() + numBuffered;
+    const float gain = 1.0f / (float) numChannels;
+    
+    juce::FloatVectorOperations::copyWithMultiply(mono, block.getReadPointer(0), gain, numSamples);
+    
+    for (int channel = 1; channel < numChannels; ++channel)
+        juce::FloatVectorOperations::addWithMultiply(mono, block.getReadPointer(channel), gain, numSamples);
+    
+    numBuffered += numSamples;
+    
+    // Evaluate the filter at each output position whose taps are all buffered
+    const auto maxOutput = (size_t) (numBuffered / step) + 2;
+    
+    if (resampled.size() < maxOutput)
+        resampled.resize(maxOutput);
+    
+    int numOutput = 0;
+    
+    for (;;)
+    {
+        auto base = (int) position;
+        int phase = juce::roundToInt((position - base) * numPhases);
+        
+        if (phase == numPhases)
+        {
+            ++base;
+            phase = 0;
+        }
+        
+        const int start = base - (halfLength - 1);
+        
+        if (start + numTaps > numBuffered)
+            break;
+        
+        resampled[(size_t) numOutput++] = dotProduct(input.data() + start, filter.data() + phase * numTaps, numTaps);
+        position += step;
+    }
+    
+    // Keep only the input the next output still needs
+    const int consumed = juce::jlimit(0, numBuffered, (int) position - (halfLength - 1));
+    
+    if (consumed > 0)
+    {
+        std::memmove(input.data(), input.data() + consumed, (size_t) (numBuffered - consumed) * sizeof(float));
+        numBuffered -= consumed;
+        position -= consumed;
+    }
+    
+    // Clamp to [-1, 1] and convert to 16-bit
+    juce::FloatVectorOperations::clip(resampled.data(), resampled.data(), -1.0f, 1.0f, numOutput);
+    juce::FloatVectorOperations::multiply(resampled.data(), 32767.0f, numOutput);
+    
+    if ((int) output.size() < numOutput)
+        output.resize((size_t) numOutput);
+    
+    for (int i = 0; i < numOutput; ++i)
+        output[(size_t) i] = (int16_t) juce::roundToInt(resampled[(size_t) i]);
+    
+    return numOutput;
+}
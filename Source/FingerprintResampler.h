@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <vector>
+
+//==============================================================================
+/**
+    Front end for Chromaprint: downmixes decoded blocks to mono, low-passes and
+    resamples them to 11025 Hz and converts the result to 16-bit PCM, so that
+    Chromaprint is fed the few samples it actually fingerprints instead of the
+    full-rate interleaved stream it would otherwise downmix and resample itself.
+
+    Resampling is a polyphase windowed-sinc filter evaluated only at output
+    positions: each output sample is one dot product of the buffered input with
+    the nearest of numPhases precomputed filter phases. The downmix, clipping
+    and scaling use FloatVectorOperations, and the dot product runs in
+    dotProductLanes independent sums that the compiler keeps in vector registers.
+
+    All buffers are kept between streams; the filter is rebuilt only when the
+    source sample rate changes.
+*/
+class FingerprintResampler
+{
+public:
+    //==============================================================================
+    FingerprintResampler();
+    
+    /**
+     * Start a new stream, dropping anything left over from the last one.
+     * @param sourceSampleRate Sample rate of the blocks that will be processed
+     * @param numChannels Channels to downmix (extra channels in a block are ignored)
+     */
+    void prepare(double sourceSampleRate, int numChannels);
+    
+    /**
+     * Downmix, filter and resample the first numSamples of a block.
+     * @return Number of 16-bit mono samples now available from getOutput()
+     */
+    int process(const juce::AudioBuffer<float>& block, int numSamples);
+    
+    /** Output of the last process() call, valid until the next one. */
+    const int16_t* getOutput() const  { return output.data(); }
+    
+    static constexpr int outputSampleRate = 11025;
+    static constexpr int numPhases = 64;
+    static constexpr int zeroCrossings = 8;     // Each side of the filter, at the lower of the two rates
+    static constexpr int dotProductLanes = 8;
+
+private:
+    //==============================================================================
+    void buildFilter();
+    
+    double sourceRate = 0.0;
+    double step = 1.0;              // Input samples per output sample
+    int channels = 0;
+    int halfLength = 1;             // Filter taps before and after the output position
+    int numTaps = dotProductLanes;  // 2 * halfLength, rounded up to a multiple of dotProductLanes
+    std::vector<float> filter;      // numPhases rows of numTaps
+    
+    std::vector<float> input;       // Mono input not yet consumed by the filter
+    int numBuffered = 0;
+    double position = 0.0;          // Next output position, in samples of input
+    
+    std::vector<float> resampled;
+    std::vector<int16_t> output;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FingerprintResampler)
+};
@@ -0,0 +1,285 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+
+#include "KeyAnalyser.h"
+#include <cmath>
+
+//==============================================================================
+namespace
+{
+    // Krumhansl-Kessler probe-tone profiles, tonic first
+    const double majorProfile[12] = { 6.35, 2.23, 3.48, 2.33, 4.38, 4.09, 2.52, 5.19, 2.39, 3.66, 2.29, 2.88 };
+    const double minorProfile[12] = { 6.33, 2.68, 3.52, 5.38, 2.60, 3.53, 2.54, 4.75, 3.98, 2.69, 3.34, 3.17 };
+    
+    // Spelled the way DJ software usually does
+    const char* const majorKeyNames[12] = { "C", "Db", "D", "Eb", "E", "F", "F#", "G", "Ab", "A", "Bb", "B" };
+    const char* const minorKeyNames[12] = { "Cm", "C#m", "Dm", "Ebm", "Em", "Fm", "F#m", "Gm", "G#m", "Am", "Bbm", "Bm" };
+    
+    double correlation(const std::array<double, 12>& chroma, const double* profile, int tonic)
+    {
+        double meanChroma = 0.0, meanProfile = 0.0;
+        for (int i = 0; i < 12; ++i)
+        {
+            meanChroma += chroma[(size_t) i];
+            meanProfile += profile[i];
+        }
+        meanChroma /= 12.0;
+        meanProfile /= 12.0;
+        
+        double covariance = 0.0, varianceChroma = 0.0, varianceProfile = 0.0;
+        for (int pitchClass = 0; pitchClass < 12; ++pitchClass)
+        {
+            const double c = chroma[(size_t) pitchClass] - meanChroma;
+            const double p = profile[(pitchClass - tonic + 12) % 12] - meanProfile;
+            covariance += c * p;
+            varianceChroma += c * c;
+            varianceProfile += p * p;
+        }
+        
+        if (varianceChroma <= 0.0)
+            return 0.0;
+        
+        return covariance / std::sqrt(varianceChroma * varianceProfile);
+    }
+}
+
+//==============================================================================
+KeyAnalyser::KeyAnalyser(double maxSecondsToAnalyse)
+    : maxAnalysisSeconds(maxSecondsToAnalyse),
+      fft(fftOrder),
+      window((size_t) fftSize),
+      frame((size_t) fftSize),
+      fftBuffer((size_t) fftSize * 2)
+{
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), (size_t) fftSize,
+                                                             juce::dsp::WindowingFunction<float>::hann, false);
+}
+
+KeyAnalyser::~KeyAnalyser()
+{
+}
+
+//==============================================================================
+bool KeyAnalyser::prepare(const juce::AudioFormatReader& reader)
+{
+    key.clear();
+    confidence = 0.0;
+    chroma.fill(0.0);
+    numFrames = 0;
+    
+    if (reader.sampleRate <= 0 || reader.lengthInSamples <= 0 || reader.numChannels == 0)
+        return false;
+    
+    // Pick the segment: skip the intro, but never start so late that the segment is cut short
+    const juce::int64 length = reader.lengthInSamples;
+    segmentLength = maxAnalysisSeconds > 0.0 ? juce::jmin(length, (juce::int64) (maxAnalysisSeconds * reader.sampleRate))
+                                             : length;
+    
+    segmentStart = juce::jmin((juce::int64) (length * segmentStartFraction), length - segmentLength);
+    samplesAnalysed = 0;
+    minWindowLength = (juce::int64) (minWindowSeconds * reader.sampleRate);
+    skippingWindow = false;
+    
+    // Anti-alias, then keep every n-th sample
+    decimation = juce::jmax(1, static_cast<int>(reader.sampleRate / targetSampleRate));
+    decimationPhase = 0;
+    
+    for (auto& filter : lowPass)
+    {
+        filter.setCoefficients(juce::IIRCoefficients::makeLowPass(reader.sampleRate, lowPassFrequency));
+        filter.reset();
+    }
+    
+    // Map each FFT bin in the analysed range to its nearest pitch class
+    const double analysisRate = reader.sampleRate / decimation;
+    binPitchClass.assign((size_t) fftSize / 2 + 1, -1);
+    
+    for (size_t bin = 1; bin < binPitchClass.size(); ++bin)
+    {
+        const double frequency = bin * analysisRate / fftSize;
+        
+        if (frequency >= minFrequency && frequency <= maxFrequency)
+        {
+            const int midiNote = juce::roundToInt(69.0 + 12.0 * std::log2(frequency / 440.0));
+            binPitchClass[bin] = midiNote % 12;
+        }
+    }
+    
+    frameFill = 0;
+    return true;
+}
+
+void KeyAnalyser::beginWindow(juce::int64 startSample, juce::int64 numSamples)
+{
+    // Every window is cut into frames of its own
+    skippingWindow = numSamples < minWindowLength || startSample + numSamples <= segmentStart;
+    decimationPhase = 0;
+    frameFill = 0;
+    
+    for (auto& filter : lowPass)
+        filter.reset();
+}
+
+void KeyAnalyser::processBlock(const juce::AudioBuffer<float>& block, int numSamples, juce::int64 startSample)
+{
+    if (skippingWindow)
+        return;
+    
+    // Only audio past the start of the segment is analysed, up to the segment's length
+    const int offset = static_cast<int>(juce::jlimit((juce::int64) 0, (juce::int64) numSamples, segmentStart - startSample));
+    const int count = static_cast<int>(juce::jmin((juce::int64) (numSamples - offset), segmentLength - samplesAnalysed));
+    
+    if (count <= 0)
+        return;
+    
+    samplesAnalysed += count;
+    
+    const int numChannels = block.getNumChannels();
+    const float gain = 1.0f / (float) numChannels;
+    
+    if ((int) mono.size() < count)
+        mono.resize((size_t) count);
+    
+    juce::FloatVectorOperations::copyWithMultiply(mono.data(), block.getReadPointer(0, offset), gain, count);
+    
+    for (int channel = 1; channel < numChannels; ++channel)
+        juce::FloatVectorOperations::addWithMultiply(mono.data(), block.getReadPointer(channel, offset), gain, count);
+    
+    for (auto& filter : lowPass)
+        filter.processSamples(mono.data(), count);
+    
+    for (int i = 0; i < count; ++i)
+    {
+        if (decimationPhase++ == 0)
+        {
+            frame[(size_t) frameFill++] = mono[(size_t) i];
+            
+            if (frameFill == fftSize)
+            {
+                processFrame();
+                
+                std::copy(frame.begin() + hopSize, frame.end(), frame.begin());
+                frameFill = fftSize - hopSize;
+            }
+        }
+        
+        if (decimationPhase == decimation)
+            decimationPhase = 0;
+    }
+}
+
+void KeyAnalyser::processFrame()
+{
+    juce::FloatVectorOperations::multiply(fftBuffer.data(), frame.data(), window.data(), fftSize);
+    juce::FloatVectorOperations::clear(fftBuffer.data() + fftSize, fftSize);
+    
+    fft.performFrequencyOnlyForwardTransform(fftBuffer.data(), true);
+    
+    std::array<double, 12> frameChroma {};
+    
+    for (size_t bin = 0; bin < binPitchClass.size(); ++bin)
+    {
+        if (binPitchClass[bin] >= 0)
+            frameChroma[(size_t) binPitchClass[bin]] += fftBuffer[bin];
+    }
+    
+    // Normalise each frame so loud passages do not outweigh the rest; skip silence
+    double peak = 0.0;
+    for (auto value : frameChroma)
+        peak = juce::jmax(peak, value);
+    
+    if (peak < 1.0e-3)
+        return;
+    
+    for (size_t pitchClass = 0; pitchClass < 12; ++pitchClass)
+        chroma[pitchClass] += frameChroma[pitchClass] / peak;
+    
+    ++numFrames;
+}
+
+bool KeyAnalyser::wantsMoreAudio() const
+{
+    return samplesAnalysed < segmentLength;
+}
+
+bool KeyAnalyser::isConfident()
+{
+    if (numFrames == 0)
+        return false;
+    
+    double estimatedConfidence = 0.0;
+    return estimateKey(chroma, estimatedConfidence).isNotEmpty() && estimatedConfidence >= confidentAbove;
+}
+
+bool KeyAnalyser::finish()
+{
+    if (numFrames == 0)
+        return false;
+    
+    key = estimateKey(chroma, confidence);
+    
+    if (key.isEmpty())
+        return false;
+    
+    DBG("[KeyAnalyser] " << key << " (confidence " << juce::String(confidence, 2)
+        << ") from " << numFrames << " chroma frames");
+    
+    return true;
+}
+
+//==============================================================================
+juce::String KeyAnalyser::estimateKey(const std::array<double, 12>& chromaToMatch, double& outConfidence)
+{
+    double best = -2.0, secondBest = -2.0;
+    juce::String bestKey;
+    
+    for (int tonic = 0; tonic < 12; ++tonic)
+    {
+        const double scores[2] = { correlation(chromaToMatch, majorProfile, tonic),
+                                   correlation(chromaToMatch, minorProfile, tonic) };
+        
+        for (int mode = 0; mode < 2; ++mode)
+        {
+            if (scores[mode] > best)
+            {
+                secondBest = best;
+                best = scores[mode];
+                bestKey = mode == 0 ? majorKeyNames[tonic] : minorKeyNames[tonic];
+            }
+            else if (scores[mode] > secondBest)
+            {
+                secondBest = scores[mode];
+            }
+        }
+    }
+    
+    // A flat chroma correlates with nothing
+    if (best <= 0.0)
+    {
+        outConfidence = 0.0;
+        return {};
+    }
+    
+    outConfidence = juce::jlimit(0.0, 1.0, best - secondBest);
+    return bestKey;
+}
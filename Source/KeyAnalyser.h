@@ -0,0 +1,126 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+
+#pragma once
+
+#include "AnalysisPipeline.h"
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <vector>
+
+//==============================================================================
+/**
+    Detects a track's musical key while it streams through the AnalysisPipeline.
+
+    Two minutes of audio (by default), starting after the intro, are
+    low-passed, decimated to about 5.5 kHz and cut into FFT frames. Spectral
+    energy between C2 and about 1.8 kHz is folded into a 12-bin chromagram,
+    which is correlated with the Krumhansl-Kessler major and minor profiles in
+    all 24 transpositions. The best match is reported in the notation the
+    exporters use ("C", "F#m", "Bbm", ...).
+
+    When a long file is decoded in windows, the two minutes are gathered from
+    whichever windows lie past the intro.
+*/
+class KeyAnalyser : public AnalysisConsumer
+{
+public:
+    //==============================================================================
+    /**
+     * @param maxSecondsToAnalyse Length of the analysed segment; 0 analyses the whole track
+     */
+    explicit KeyAnalyser(double maxSecondsToAnalyse = defaultAnalysisSeconds);
+    ~KeyAnalyser() override;
+    
+    bool prepare(const juce::AudioFormatReader& reader) override;
+    void beginWindow(juce::int64 startSample, juce::int64 numSamples) override;
+    void processBlock(const juce::AudioBuffer<float>& block, int numSamples, juce::int64 startSample) override;
+    bool wantsMoreAudio() const override;
+    bool isConfident() override;
+    bool finish() override;
+    
+    /** The key of the last file (e.g. "Am"), or empty if none was found. */
+    const juce::String& getKey() const  { return key; }
+    
+    /** How far the best key's correlation stands above the runner-up (0-1). */
+    double getConfidence() const        { return confidence; }
+    
+    /**
+     * Match a 12-bin chroma vector (index 0 = C) against the key profiles.
+     * @param chroma Energy per pitch class
+     * @param outConfidence Receives the margin over the second-best key
+     * @return The key name, or empty if the chroma is flat
+     */
+    static juce::String estimateKey(const std::array<double, 12>& chroma, double& outConfidence);
+    
+    static constexpr double defaultAnalysisSeconds = 120.0;
+    
+    // The analysed segment starts this far into the track, skipping beat-only intros
+    static constexpr double segmentStartFraction = 0.15;
+    
+    // A sampled file is decoded further while the confidence is below this
+    static constexpr double confidentAbove = 0.05;
+    
+    // Windows shorter than this (slivers left between sections) are not worth a chroma frame
+    static constexpr double minWindowSeconds = 5.0;
+
+private:
+    //==============================================================================
+    void processFrame();
+    
+    static constexpr double targetSampleRate = 5512.5;
+    static constexpr double lowPassFrequency = 2000.0;
+    static constexpr double minFrequency = 65.4;    // C2
+    static constexpr double maxFrequency = 1800.0;
+    static constexpr int fftOrder = 12;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 2;
+    
+    const double maxAnalysisSeconds;
+    
+    juce::dsp::FFT fft;
+    std::vector<float> window;
+    std::vector<int> binPitchClass;     // -1 for bins outside the analysed range
+    
+    juce::IIRFilter lowPass[2];
+    int decimation = 1;
+    int decimationPhase = 0;
+    juce::int64 segmentStart = 0;
+    juce::int64 segmentLength = 0;
+    juce::int64 samplesAnalysed = 0;
+    juce::int64 minWindowLength = 0;
+    bool skippingWindow = false;
+    
+    std::vector<float> mono;
+    std::vector<float> frame;
+    int frameFill = 0;
+    std::vector<float> fftBuffer;
+    
+    std::array<double, 12> chroma {};
+    int numFrames = 0;
+    
+    juce::String key;
+    double confidence = 0.0;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (KeyAnalyser)
+};
@@ -0,0 +1,473 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+
+#include "LoudnessAnalyser.h"
+#include <algorithm>
+#include <cmath>
+
+//==============================================================================
+namespace
+{
+    // BS.1770 block loudness from a mean-square energy
+    double energyToLoudness(double energy)
+    {
+        return -0.691 + 10.0 * std::log10(energy);
+    }
+    
+    double loudnessToEnergy(double loudness)
+    {
+        return std::pow(10.0, (loudness + 0.691) / 10.0);
+    }
+    
+    // Mean energy of the blocks above the absolute gate and `relativeGate` LU below their mean
+    double gatedMeanEnergy(const std::vector<double>& energies, double relativeGate, std::vector<double>* survivors = nullptr)
+    {
+        const double absoluteThreshold = loudnessToEnergy(-70.0);
+        
+        double sum = 0.0;
+        int count = 0;
+        for (auto energy : energies)
+        {
+            if (energy > absoluteThreshold)
+            {
+                sum += energy;
+                ++count;
+            }
+        }
+        
+        if (count == 0)
+            return 0.0;
+        
+        const double threshold = juce::jmax(absoluteThreshold, sum / count * std::pow(10.0, relativeGate / 10.0));
+        
+        sum = 0.0;
+        count = 0;
+        for (auto energy : energies)
+        {
+            if (energy > threshold)
+            {
+                sum += energy;
+                ++count;
+                
+                if (survivors != nullptr)
+                    survivors->push_back(energy);
+            }
+        }
+        
+        return count > 0 ? sum / count : 0.0;
+    }
+    
+    // Mean of `length` consecutive 100 ms energies, sliding by one block
+    std::vector<double> slidingMean(const std::vector<float>& blockEnergies, int length)
+    {
+        std::vector<double> means;
+        
+        if ((int) blockEnergies.size() < length)
+            return means;
+        
+        double sum = 0.0;
+        for (int i = 0; i < length; ++i)
+            sum += blockEnergies[(size_t) i];
+        
+        means.push_back(sum / length);
+        
+        for (size_t i = (size_t) length; i < blockEnergies.size(); ++i)
+        {
+            sum += blockEnergies[i] - blockEnergies[i - (size_t) length];
+            means.push_back(juce::jmax(0.0, sum) / length);
+        }
+        
+        return means;
+    }
+}
+
+//==============================================================================
+LoudnessAnalyser::LoudnessAnalyser()
+{
+}
+
+LoudnessAnalyser::~LoudnessAnalyser()
+{
+}
+
+//==============================================================================
+bool LoudnessAnalyser::prepare(const juce::AudioFormatReader& reader)
+{
+    integratedLoudness = 0.0;
+    loudnessRange = 0.0;
+    truePeakDecibels = 0.0;
+    
+    if (reader.sampleRate <= 0 || reader.numChannels == 0)
+        return false;
+    
+    const double sampleRate = reader.sampleRate;
+    const int numChannels = juce::jmin((int) reader.numChannels, maxChannels);
+    
+    // K-weighting: a high shelf for the head, then the RLB high-pass, both
+    // derived for this sample rate from the BS.1770 analogue prototypes
+    double k = std::tan(juce::MathConstants<double>::pi * 1681.974450955533 / sampleRate);
+    double q = 0.7071752369554196;
+    const double vh = std::pow(10.0, 3.999843853973347 / 20.0);
+    const double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    
+    shelf.b0 = (float) ((vh + vb * k / q + k * k) / a0);
+    shelf.b1 = (float) (2.0 * (k * k - vh) / a0);
+    shelf.b2 = (float) ((vh - vb * k / q + k * k) / a0);
+    shelf.a1 = (float) (2.0 * (k * k - 1.0) / a0);
+    shelf.a2 = (float) ((1.0 - k / q + k * k) / a0);
+    
+    k = std::tan(juce::MathConstants<double>::pi * 38.13547087602444 / sampleRate);
+    q = 0.5003270373238773;
+    a0 = 1.0 + k / q + k * k;
+    
+    // The reference filter's numerator is not normalised by a0
+    highPass.b0 = 1.0f;
+    highPass.b1 = -2.0f;
+    highPass.b2 = 1.0f;
+    highPass.a1 = (float) (2.0 * (k * k - 1.0) / a0);
+    highPass.a2 = (float) ((1.0 - k / q + k * k) / a0);
+    
+    channels.clear();
+    channels.resize((size_t) numChannels);
+    
+    for (int i = 0; i < numChannels; ++i)
+    {
+        auto& channel = channels[(size_t) i];
+        channel.history.assign(tapsPerPhase - 1, 0.0f);
+        
+        // 5.0 and 5.1 layouts: surrounds count 1.41x, the LFE not at all
+        if (numChannels == 6)
+            channel.weight = i == 3 ? 0.0f : (i >= 4 ? 1.41f : 1.0f);
+        else if (numChannels == 5)
+            channel.weight = i >= 3 ? 1.41f : 1.0f;
+    }
+    
+    subBlockLength = juce::roundToInt(sampleRate * 0.1);
+    subBlockFill = 0;
+    subBlockEnergy = 0.0;
+    settling = false;
+    nextSample = 0;
+    blockEnergies.clear();
+    blockEnergies.reserve((size_t) (reader.lengthInSamples / juce::jmax(1, subBlockLength)) + 1);
+    
+    // Windowed-sinc interpolator, split into one short filter per output phase
+    oversampling = sampleRate < 96000.0 ? 4 : (sampleRate < 192000.0 ? 2 : 1);
+    const int numTaps = oversampling * tapsPerPhase;
+    interpolationTaps.assign((size_t) numTaps, 0.0f);
+    interpolationGain = 1.0f;
+    
+    for (int phase = 0; phase < oversampling; ++phase)
+    {
+        double sum = 0.0;
+        
+        for (int tap = 0; tap < tapsPerPhase; ++tap)
+        {
+            const int i = tap * oversampling + phase;
+            const double t = (i - (numTaps - 1) / 2.0) / oversampling;
+            const double sinc = t == 0.0 ? 1.0 : std::sin(juce::MathConstants<double>::pi * t) / (juce::MathConstants<double>::pi * t);
+            const double x = juce::MathConstants<double>::twoPi * (i + 0.5) / numTaps;
+            const double blackman = 0.42 - 0.5 * std::cos(x) + 0.08 * std::cos(2.0 * x);
+            
+            interpolationTaps[(size_t) (phase * tapsPerPhase + tap)] = (float) (sinc * blackman);
+            sum += sinc * blackman;
+        }
+        
+        // Unity gain at DC for every phase
+        float absoluteSum = 0.0f;
+        for (int tap = 0; tap < tapsPerPhase; ++tap)
+        {
+            auto& value = interpolationTaps[(size_t) (phase * tapsPerPhase + tap)];
+            value /= (float) sum;
+            absoluteSum += std::abs(value);
+        }
+        
+        interpolationGain = juce::jmax(interpolationGain, absoluteSum);
+    }
+    
+    truePeak = 0.0f;
+    return true;
+}
+
+void LoudnessAnalyser::beginWindow(juce::int64 startSample, juce::int64)
+{
+    if (startSample == nextSample)
+        return;
+    
+    // Audio on either side of a jump is unrelated, so nothing carries over
+    for (auto& channel : channels)
+    {
+        std::fill(std::begin(channel.shelfState), std::end(channel.shelfState), 0.0f);
+        std::fill(std::begin(channel.highPassState), std::end(channel.highPassState), 0.0f);
+        channel.history.clear();
+    }
+    
+    subBlockFill = 0;
+    subBlockEnergy = 0.0;
+    settling = true;
+}
+
+void LoudnessAnalyser::processBlock(const juce::AudioBuffer<float>& block, int numSamples, juce::int64 startSample)
+{
+    nextSample = startSample + numSamples;
+    
+    const int numChannels = juce::jmin((int) channels.size(), block.getNumChannels());
+    
+    for (int c = 0; c < numChannels; ++c)
+        addToTruePeak(c, block.getReadPointer(c), numSamples);
+    
+    // Cut the block where 100 ms blocks end
+    for (int position = 0; position < numSamples;)
+    {
+        const int run = juce::jmin(numSamples - position, subBlockLength - subBlockFill);
+        
+        subBlockEnergy += addKWeightedEnergy(block, position, run);
+        subBlockFill += run;
+        position += run;
+        
+        if (subBlockFill == subBlockLength)
+        {
+            if (!settling)
+                blockEnergies.push_back((float) (subBlockEnergy / subBlockLength));
+            
+            settling = false;
+            subBlockEnergy = 0.0;
+            subBlockFill = 0;
+        }
+    }
+}
+
+double LoudnessAnalyser::addKWeightedEnergy(const juce::AudioBuffer<float>& block, int start, int count)
+{
+    // Mono and stereo get their own instantiations, so their filter state stays in registers
+    switch (juce::jmin((int) channels.size(), block.getNumChannels()))
+    {
+        case 1:  return addKWeightedEnergy<1>(block, start, count);
+        case 2:  return addKWeightedEnergy<2>(block, start, count);
+        default: return addKWeightedEnergy<0>(block, start, count);
+    }
+}
+
+template <int fixedChannels>
+double LoudnessAnalyser::addKWeightedEnergy(const juce::AudioBuffer<float>& block, int start, int count)
+{
+    constexpr int capacity = fixedChannels > 0 ? fixedChannels : maxChannels;
+    const int numChannels = fixedChannels > 0 ? fixedChannels
+                                              : juce::jmin((int) channels.size(), block.getNumChannels());
+    const Biquad s = shelf, h = highPass;
+    
+    const float* input[capacity] = {};
+    float z[capacity][4] = {};
+    float sums[capacity] = {};
+    
+    for (int c = 0; c < numChannels; ++c)
+    {
+        const auto& channel = channels[(size_t) c];
+        input[c] = block.getReadPointer(c, start);
+        z[c][0] = channel.shelfState[0];
+        z[c][1] = channel.shelfState[1];
+        z[c][2] = channel.highPassState[0];
+        z[c][3] = channel.highPassState[1];
+    }
+    
+    // Both filters (transposed direct form II) and the squaring for every channel in one
+    // pass; the channels' recursions are independent, so the CPU overlaps them
+    for (int i = 0; i < count; ++i)
+    {
+        for (int c = 0; c < numChannels; ++c)
+        {
+            const float x = input[c][i];
+            
+            const float shelved = s.b0 * x + z[c][0];
+            z[c][0] = s.b1 * x - s.a1 * shelved + z[c][1];
+            z[c][1] = s.b2 * x - s.a2 * shelved;
+            
+            const float weighted = h.b0 * shelved + z[c][2];
+            z[c][2] = h.b1 * shelved - h.a1 * weighted + z[c][3];
+            z[c][3] = h.b2 * shelved - h.a2 * weighted;
+            
+            sums[c] += weighted * weighted;
+        }
+    }
+    
+    double energy = 0.0;
+    
+    for (int c = 0; c < numChannels; ++c)
+    {
+        auto& channel = channels[(size_t) c];
+        channel.shelfState[0] = z[c][0];
+        channel.shelfState[1] = z[c][1];
+        channel.highPassState[0] = z[c][2];
+        channel.highPassState[1] = z[c][3];
+        
+        energy += channel.weight * (double) sums[c];
+    }
+    
+    return energy;
+}
+
+void LoudnessAnalyser::addToTruePeak(int channelIndex, const float* samples, int numSamples)
+{
+    const auto range = juce::FloatVectorOperations::findMinAndMax(samples, numSamples);
+    const float blockPeak = juce::jmax(-range.getStart(), range.getEnd());
+    truePeak = juce::jmax(truePeak, blockPeak);
+    
+    if (oversampling == 1)
+        return;
+    
+    auto& history = channels[(size_t) channelIndex].history;
+    const int historyLength = tapsPerPhase - 1;
+    
+    // After a jump, hold the first sample so the step from silence cannot ring
+    if (history.empty())
+        history.assign((size_t) historyLength, numSamples > 0 ? samples[0] : 0.0f);
+    
+    truePeakInput.resize((size_t) (historyLength + numSamples));
+    std::copy(history.begin(), history.end(), truePeakInput.begin());
+    std::copy(samples, samples + numSamples, truePeakInput.begin() + historyLength);
+    
+    if ((int) interpolated.size() < truePeakChunkSize)
+        interpolated.resize((size_t) truePeakChunkSize);
+    
+    const float* input = truePeakInput.data() + historyLength;
+    
+    for (int chunk = 0; chunk < numSamples; chunk += truePeakChunkSize)
+    {
+        const int length = juce::jmin(truePeakChunkSize, numSamples - chunk);
+        
+        // Every interpolated value is a weighted sum of these samples, so it can
+        // exceed their peak by at most the taps' absolute sum
+        const auto inputRange = juce::FloatVectorOperations::findMinAndMax(input + chunk - historyLength,
+                                                                           length + historyLength);
+        
+        if (juce::jmax(-inputRange.getStart(), inputRange.getEnd()) * interpolationGain <= truePeak)
+            continue;
+        
+        // Each output phase is a short FIR; with the tap count fixed the compiler
+        // keeps the taps in registers and vectorises across output samples
+        for (int phase = 0; phase < oversampling; ++phase)
+        {
+            float taps[tapsPerPhase];
+            std::copy_n(interpolationTaps.data() + phase * tapsPerPhase, tapsPerPhase, taps);
+            
+            const float* source = input + chunk;
+            float* output = interpolated.data();
+            
+            for (int i = 0; i < length; ++i)
+            {
+                float sum = 0.0f;
+                
+                for (int tap = 0; tap < tapsPerPhase; ++tap)
+                    sum += taps[tap] * source[i - tap];
+                
+                output[i] = sum;
+            }
+            
+            const auto phaseRange = juce::FloatVectorOperations::findMinAndMax(interpolated.data(), length);
+            truePeak = juce::jmax(truePeak, -phaseRange.getStart(), phaseRange.getEnd());
+        }
+    }
+    
+    // Keep the newest samples for the start of the next block
+    if (numSamples >= historyLength)
+    {
+        std::copy(samples + numSamples - historyLength, samples + numSamples, history.begin());
+    }
+    else
+    {
+        std::copy(history.begin() + numSamples, history.end(), history.begin());
+        std::copy(samples, samples + numSamples, history.end() - numSamples);
+    }
+}
+
+bool LoudnessAnalyser::finish()
+{
+    measure(blockEnergies, integratedLoudness, loudnessRange);
+    truePeakDecibels = juce::Decibels::gainToDecibels((double) truePeak, -100.0);
+    
+    if (integratedLoudness >= 0.0)
+        return false;
+    
+    DBG("[LoudnessAnalyser] " << juce::String(integratedLoudness, 1) << " LUFS, LRA "
+        << juce::String(loudnessRange, 1) << " LU, true peak " << juce::String(truePeakDecibels, 1) << " dBTP");
+    
+    return true;
+}
+
+//==============================================================================
+void LoudnessAnalyser::measure(const std::vector<float>& energies, double& outIntegrated, double& outRange)
+{
+    outIntegrated = 0.0;
+    outRange = 0.0;
+    
+    // Integrated: 400 ms momentary blocks with 75% overlap, gated 10 LU below their mean
+    const double integratedEnergy = gatedMeanEnergy(slidingMean(energies, 4), -10.0);
+    
+    if (integratedEnergy <= 0.0)
+        return;
+    
+    outIntegrated = energyToLoudness(integratedEnergy);
+    
+    // Range: 3 s short-term blocks, gated 20 LU below their mean, 10th to 95th percentile
+    std::vector<double> shortTerm;
+    gatedMeanEnergy(slidingMean(energies, 30), -20.0, &shortTerm);
+    
+    if (shortTerm.size() < 2)
+        return;
+    
+    std::sort(shortTerm.begin(), shortTerm.end());
+    
+    auto percentile = [&shortTerm](double fraction)
+    {
+        return energyToLoudness(shortTerm[(size_t) juce::roundToInt(fraction * (double) (shortTerm.size() - 1))]);
+    };
+    
+    outRange = percentile(0.95) - percentile(0.10);
+}
+
+double LoudnessAnalyser::getReplayGain(double loudnessLufs, double truePeakDb)
+{
+    return juce::jmin(referenceLoudness - loudnessLufs, peakCeiling - truePeakDb);
+}
+
+bool LoudnessAnalyser::getAlbumGain(const std::vector<DatabaseManager::Track>& tracks, double& outGainDb)
+{
+    double weightedEnergy = 0.0, totalDuration = 0.0;
+    double albumPeak = -100.0;
+    
+    for (const auto& track : tracks)
+    {
+        if (track.loudnessLufs >= 0.0 || track.duration <= 0.0)
+            continue;
+        
+        weightedEnergy += track.duration * std::pow(10.0, track.loudnessLufs / 10.0);
+        totalDuration += track.duration;
+        albumPeak = juce::jmax(albumPeak, track.truePeakDb);
+    }
+    
+    if (totalDuration <= 0.0)
+        return false;
+    
+    outGainDb = getReplayGain(10.0 * std::log10(weightedEnergy / totalDuration), albumPeak);
+    return true;
+}
@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+
+#pragma once
+
+#include "AnalysisPipeline.h"
+#include "DatabaseManager.h"
+#include <vector>
+
+//==============================================================================
+/**
+    Measures loudness as defined by EBU R128 / ITU-R BS.1770 while a track
+    streams through the AnalysisPipeline:
+
+    - Integrated loudness (LUFS): K-weighted mean square over 400 ms blocks,
+      gated at -70 LUFS and then 10 LU below the ungated mean
+    - Loudness range (LU): spread between the 10th and 95th percentile of
+      3-second short-term loudness, gated at -70 LUFS and 20 LU below the mean
+    - True peak (dBTP): the highest sample of a 4x oversampled signal (2x at
+      96 kHz and above)
+
+    One kernel K-weights all channels of a block side by side (so the filters'
+    dependency chains overlap) and sums their energy in the same pass; the
+    result is reduced to 100 ms energies that the gating works on. The
+    true-peak interpolator runs as vector multiply-adds over 64-sample chunks,
+    skipping any chunk that provably cannot raise the peak.
+
+    Gating, loudness range and true peak are only meaningful over every sample,
+    so the result is only kept when the pipeline decoded the whole file. The
+    filters restart whenever a window jumps, and the first 100 ms block after a
+    restart is left out while they settle.
+*/
+class LoudnessAnalyser : public AnalysisConsumer
+{
+public:
+    //==============================================================================
+    LoudnessAnalyser();
+    ~LoudnessAnalyser() override;
+    
+    bool prepare(const juce::AudioFormatReader& reader) override;
+    void beginWindow(juce::int64 startSample, juce::int64 numSamples) override;
+    void processBlock(const juce::AudioBuffer<float>& block, int numSamples, juce::int64 startSample) override;
+    bool wantsMoreAudio() const override { return true; }
+    bool finish() override;
+    
+    /** Integrated loudness of the last file in LUFS (0 if it was silent). */
+    double getIntegratedLoudness() const  { return integratedLoudness; }
+    
+    /** Loudness range of the last file in LU. */
+    double getLoudnessRange() const       { return loudnessRange; }
+    
+    /** True peak of the last file in dBTP. */
+    double getTruePeak() const            { return truePeakDecibels; }
+    
+    //==============================================================================
+    /** ReplayGain 2.0 reference level. */
+    static constexpr double referenceLoudness = -18.0;
+    
+    /** Gains are limited so the true peak stays below this. */
+    static constexpr double peakCeiling = -1.0;
+    
+    /**
+     * The gain that brings audio to the reference loudness without pushing its
+     * true peak over the ceiling.
+     */
+    static double getReplayGain(double loudnessLufs, double truePeakDb);
+    
+    /**
+     * The album gain for a set of analysed tracks: their loudness is combined by
+     * energy, weighted by duration, and limited by the loudest true peak.
+     * Tracks without a loudness measurement are ignored.
+     * @return False if none of the tracks has been analysed
+     */
+    static bool getAlbumGain(const std::vector<DatabaseManager::Track>& tracks, double& outGainDb);
+    
+    /**
+     * Integrated loudness and loudness range from K-weighted mean-square
+     * energies of consecutive 100 ms blocks (already channel-weighted).
+     */
+    static void measure(const std::vector<float>& blockEnergies, double& outIntegrated, double& outRange);
+
+private:
+    //==============================================================================
+    double addKWeightedEnergy(const juce::AudioBuffer<float>& block, int start, int count);
+    void addToTruePeak(int channel, const float* samples, int numSamples);
+    
+    template <int fixedChannels>
+    double addKWeightedEnergy(const juce::AudioBuffer<float>& block, int start, int count);
+    
+    static constexpr int maxChannels = 8;
+    static constexpr int tapsPerPhase = 12;
+    static constexpr int truePeakChunkSize = 64;
+    
+    // Normalised biquad coefficients (a0 == 1)
+    struct Biquad
+    {
+        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+    };
+    
+    struct ChannelState
+    {
+        float shelfState[2] = {};
+        float highPassState[2] = {};
+        float weight = 1.0f;
+        std::vector<float> history;     // Last tapsPerPhase - 1 raw samples, for oversampling; empty after a jump
+    };
+    
+    Biquad shelf, highPass;
+    std::vector<ChannelState> channels;
+    
+    int subBlockLength = 0;
+    int subBlockFill = 0;
+    bool settling = false;              // The current 100 ms block follows a jump
+    juce::int64 nextSample = 0;         // Where the last block ended
+    double subBlockEnergy = 0.0;
+    std::vector<float> blockEnergies;
+    
+    int oversampling = 4;
+    std::vector<float> interpolationTaps;   // Phase-major: tapsPerPhase taps per phase
+    float interpolationGain = 1.0f;         // Largest sum of absolute taps of any phase
+    std::vector<float> truePeakInput, interpolated;
+    float truePeak = 0.0f;
+    
+    double integratedLoudness = 0.0;
+    double loudnessRange = 0.0;
+    double truePeakDecibels = 0.0;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoudnessAnalyser)
+};
@@ -32,6 +32,9 @@ MainComponent::MainComponent()
     
     // Enable keyboard focus for shortcuts
     setWantsKeyboardFocus(true);
+    
+    // Hear mouse events from every child, so analysis backs off while the UI is in use
+    addMouseListener(this, true);
 
     // Setup title label
     titleLabel.setText ("uniQuE-ui Library Manager", juce::dontSendNotification);
@@ -83,6 +86,15 @@ MainComponent::MainComponent()
     newPlaylistButton.setTooltip ("Create a new playlist/virtual folder (Ctrl+N)");
     addAndMakeVisible (newPlaylistButton);
     
+    statsButton.setButtonText ("Stats");
+    statsButton.setClickingTogglesState (true);
+    statsButton.onClick = [this] { toggleStatsPanel(); };
+    statsButton.setTooltip ("Show where analysis time goes, per stage, and the import throughput");
+    addAndMakeVisible (statsButton);
+    
+    // Analysis stats panel, hidden until the Stats button is toggled on
+    addChildComponent (statsPanel);
+    
     // Setup progress bar
     addAndMakeVisible (progressBar);
     
@@ -106,6 +118,7 @@ MainComponent::MainComponent()
 MainComponent::~MainComponent()
 {
     stopTimer();
+    removeMouseListener(this);
     if (analysisWorker)
         analysisWorker->stopWorker();
     
@@ -397,11 +410,14 @@ void MainComponent::updateProgress()
     if (analysisWorker)
     {
         int pendingJobs = analysisWorker->getPendingJobCount();
+        int activeJobs = static_cast<int>(analysisWorker->getActiveJobs().size());
         bool isProcessing = analysisWorker->isProcessing();
         
         if (pendingJobs > 0 || isProcessing)
         {
-            currentStatus = "Processing: " + juce::String(pendingJobs) + " jobs remaining";
+            currentStatus = "Processing: " + juce::String(pendingJobs) + " jobs remaining ("
+                          + juce::String(activeJobs) + " of " + juce::String(analysisWorker->getNumThreads())
+                          + " workers busy)";
         }
         else
         {
@@ -416,6 +432,9 @@ void MainComponent::timerCallback()
 {
     updateProgress();
     
+    if (statsPanel.isVisible() && analysisWorker)
+        statsPanel.setSnapshot(analysisWorker->getStats().getSnapshot());
+    
     // Check if onboarding is complete and switch to main interface
     if (onboardingComponent && onboardingComponent->isComplete() && showOnboarding)
     {
@@ -456,6 +475,8 @@ void MainComponent::refreshLibrary()
 
 bool MainComponent::keyPressed(const juce::KeyPress& key)
 {
+    noteUserActivity();
+    
     // Ctrl+F or Cmd+F: Focus search box
     if (key == juce::KeyPress('f', juce::ModifierKeys::commandModifier, 0))
     {
@@ -494,6 +515,72 @@ bool MainComponent::keyPressed(const juce::KeyPress& key)
     return Component::keyPressed(key);
 }
 
+void MainComponent::mouseDown(const juce::MouseEvent&)
+{
+    noteUserActivity();
+}
+
+void MainComponent::mouseDrag(const juce::MouseEvent&)
+{
+    noteUserActivity();
+}
+
+void MainComponent::mouseWheelMove(const juce::MouseEvent&, const juce::MouseWheelDetails&)
+{
+    noteUserActivity();
+}
+
+bool MainComponent::isInterestedInFileDrag(const juce::StringArray& files)
+{
+    for (const auto& path : files)
+    {
+        if (FileScanner::isSupportedAudioFile(juce::File(path)))
+            return true;
+    }
+    
+    return false;
+}
+
+void MainComponent::filesDropped(const juce::StringArray& files, int, int)
+{
+    if (!fileScanner || !databaseManager || !databaseManager->isOpen())
+        return;
+    
+    int filesQueued = 0;
+    
+    for (const auto& path : files)
+    {
+        juce::File file(path);
+        
+        // Tracks already in the library have been analysed
+        if (databaseManager->getTrackByPath(file.getFullPathName()).id != 0)
+            continue;
+        
+        // Queued ahead of any scan; a file already waiting in the queue is moved up instead
+        if (fileScanner->enqueueFile(file, DatabaseManager::jobPriorityInteractive))
+            ++filesQueued;
+    }
+    
+    if (filesQueued > 0)
+        showToast("Analysing " + juce::String(filesQueued) + " dropped file(s).", ToastNotification::Type::Info);
+}
+
+void MainComponent::toggleStatsPanel()
+{
+    statsPanel.setVisible(statsButton.getToggleState());
+    
+    if (statsPanel.isVisible() && analysisWorker)
+        statsPanel.setSnapshot(analysisWorker->getStats().getSnapshot());
+    
+    resized();
+}
+
+void MainComponent::noteUserActivity()
+{
+    if (analysisWorker)
+        analysisWorker->getResourceGovernor().noteUserActivity();
+}
+
 void MainComponent::showToast(const juce::String& message, ToastNotification::Type type)
 {
     if (toastNotification)
@@ -683,7 +770,9 @@ void MainComponent::resized()
         titleLabel.setBounds(topBar.removeFromLeft(250).reduced(10, 10));
         
         // Buttons on the right
-        auto buttonArea = topBar.removeFromRight(580).reduced(5);
+        auto buttonArea = topBar.removeFromRight(650).reduced(5);
+        statsButton.setBounds(buttonArea.removeFromRight(65));
+        buttonArea.removeFromRight(5);
         newPlaylistButton.setBounds(buttonArea.removeFromRight(120));
         buttonArea.removeFromRight(5);
         exportButton.setBounds(buttonArea.removeFromRight(160));
@@ -706,6 +795,13 @@ void MainComponent::resized()
         // Main content area
         auto contentArea = bounds.reduced(5);
         
+        // Stats panel along the bottom when shown
+        if (statsPanel.isVisible())
+        {
+            statsPanel.setBounds(contentArea.removeFromBottom(AnalysisStatsComponent::getPreferredHeight()));
+            contentArea.removeFromBottom(5); // Spacing
+        }
+        
         // Left side: playlist tree (30% width)
         if (playlistTree)
         {
@@ -26,6 +26,7 @@
 #include "DatabaseManager.h"
 #include "FileScanner.h"
 #include "AnalysisWorker.h"
+#include "AnalysisStatsComponent.h"
 #include "LibraryTableComponent.h"
 #include "PlaylistTreeComponent.h"
 #include "OnboardingComponent.h"
@@ -39,6 +40,7 @@
     It will be the container for the music library interface and all related UI components.
 */
 class MainComponent  : public juce::Component,
+                       public juce::FileDragAndDropTarget,
                        private juce::Timer
 {
 public:
@@ -50,6 +52,15 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
     bool keyPressed (const juce::KeyPress& key) override;
+    
+    // Mouse events from any child; they only tell the analysis governor the UI is busy
+    void mouseDown (const juce::MouseEvent&) override;
+    void mouseDrag (const juce::MouseEvent&) override;
+    void mouseWheelMove (const juce::MouseEvent&, const juce::MouseWheelDetails&) override;
+    
+    // Audio files dropped on the window that are not in the library yet are analysed first
+    bool isInterestedInFileDrag (const juce::StringArray& files) override;
+    void filesDropped (const juce::StringArray& files, int x, int y) override;
 
 private:
     //==============================================================================
@@ -61,12 +72,14 @@ private:
     juce::TextButton recentDirsButton;
     juce::TextButton exportButton;
     juce::TextButton newPlaylistButton;
+    juce::TextButton statsButton;
     juce::Label progressLabel;
     
     std::unique_ptr<LibraryTableComponent> libraryTable;
     std::unique_ptr<PlaylistTreeComponent> playlistTree;
     std::unique_ptr<OnboardingComponent> onboardingComponent;
     std::unique_ptr<ToastNotification> toastNotification;
+    AnalysisStatsComponent statsPanel;
     
     // Backend components
     std::unique_ptr<DatabaseManager> databaseManager;
@@ -99,6 +112,8 @@ private:
     void saveRecentDirectories();
     void addRecentDirectory(const juce::String& path);
     void showRecentDirectoriesMenu();
+    void noteUserActivity();
+    void toggleStatsPanel();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
 };
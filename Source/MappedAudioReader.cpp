@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+
+#include "MappedAudioReader.h"
+
+#if JUCE_LINUX || JUCE_MAC
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    juce::int64 getBytesPerFrame(const juce::AudioFormatReader& reader)
+    {
+        return juce::jmax((juce::int64) 1, (juce::int64) reader.numChannels * reader.bitsPerSample / 8);
+    }
+
+    // JUCE keeps the data chunk's position protected; a derived class may still
+    // name the member, and the pointer to it works on any mapped reader
+    struct DataChunkAccess : juce::MemoryMappedAudioFormatReader
+    {
+        static juce::int64 getFilePosition(const juce::MemoryMappedAudioFormatReader& reader, juce::int64 sample)
+        {
+            return (reader.*(&DataChunkAccess::sampleToFilePos))(sample);
+        }
+    };
+}
+
+//==============================================================================
+std::unique_ptr<juce::AudioFormatReader> MappedAudioReader::createReaderFor(juce::AudioFormatManager& formatManager,
+                                                                            const juce::File& file)
+{
+    if (auto* format = formatManager.findFormatForFileExtension(file.getFileExtension()))
+    {
+        // Only PCM formats implement this; the rest return nullptr
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(format->createMemoryMappedReader(file));
+
+        if (mapped != nullptr && mapped->lengthInSamples > 0 && mapped->mapEntireFile())
+            return mapped;
+    }
+
+    return std::unique_ptr<juce::AudioFormatReader>(formatManager.createReaderFor(file));
+}
+
+bool MappedAudioReader::isMemoryMapped(const juce::AudioFormatReader& reader)
+{
+    return dynamic_cast<const juce::MemoryMappedAudioFormatReader*>(&reader) != nullptr;
+}
+
+juce::int64 MappedAudioReader::getPrefetchSamples(const juce::AudioFormatReader& reader)
+{
+    return juce::jmax((juce::int64) 1, prefetchBytes / getBytesPerFrame(reader));
+}
+
+void MappedAudioReader::prefetch(juce::AudioFormatReader& reader, juce::int64 startSample, juce::int64 numSamples)
+{
+    auto* mapped = dynamic_cast<juce::MemoryMappedAudioFormatReader*>(&reader);
+
+    if (mapped == nullptr || numSamples <= 0)
+        return;
+
+   #if JUCE_LINUX || JUCE_MAC
+    // Chunks after the sample data (id3, LIST) are common, so ask the reader where it starts
+    const auto& file = mapped->getFile();
+    const auto offset = DataChunkAccess::getFilePosition(*mapped, startSample);
+    const auto length = DataChunkAccess::getFilePosition(*mapped, startSample + numSamples) - offset;
+
+    const int fd = open(file.getFullPathName().toRawUTF8(), O_RDONLY);
+
+    if (fd < 0)
+        return;
+
+   #if JUCE_LINUX
+    posix_fadvise(fd, (off_t) offset, (off_t) length, POSIX_FADV_WILLNEED);
+   #else
+    radvisory advice { (off_t) offset, (int) juce::jmin(length, (juce::int64) std::numeric_limits<int>::max()) };
+    fcntl(fd, F_RDADVISE, &advice);
+   #endif
+
+    close(fd);
+   #else
+    juce::ignoreUnused(mapped, startSample);
+   #endif
+}
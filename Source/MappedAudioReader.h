@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <memory>
+
+//==============================================================================
+/**
+    Opens audio files for sequential analysis. Uncompressed PCM formats (WAV,
+    AIFF) are read through a MemoryMappedAudioFormatReader over the whole file,
+    so samples are converted straight from the page cache instead of being
+    copied through a stream buffer first. Other formats get the format's normal
+    stream reader.
+
+    prefetch() asks the OS to read the next part of a mapped file ahead of the
+    decoder. JUCE does not expose the address of its mapping, so rather than
+    madvise() this advises the file range itself: posix_fadvise(WILLNEED) on
+    Linux and F_RDADVISE on macOS, which fill the page cache the mapping is
+    served from. It does nothing on Windows or for stream readers.
+*/
+class MappedAudioReader
+{
+public:
+    //==============================================================================
+    /**
+     * Create a reader for a file, memory-mapped if its format supports it.
+     * @param formatManager Formats to try; the file extension picks the format
+     *                      for mapping, and content sniffing is the fallback
+     * @param file The audio file
+     * @return The reader, or nullptr if no format could open the file
+     */
+    static std::unique_ptr<juce::AudioFormatReader> createReaderFor(juce::AudioFormatManager& formatManager,
+                                                                    const juce::File& file);
+
+    /** True if the reader came from createReaderFor() with a mapped file. */
+    static bool isMemoryMapped(const juce::AudioFormatReader& reader);
+
+    /**
+     * Hint that the given samples will be read soon, in order. Returns at once;
+     * the OS reads the range in the background.
+     * @param reader A reader from createReaderFor()
+     * @param startSample First sample that will be read
+     * @param numSamples Number of samples that will be read
+     */
+    static void prefetch(juce::AudioFormatReader& reader, juce::int64 startSample, juce::int64 numSamples);
+
+    /** Bytes prefetched at a time by readers that walk a file sequentially. */
+    static constexpr juce::int64 prefetchBytes = 8 * 1024 * 1024;
+
+    /** Number of samples of this reader that fit in prefetchBytes. */
+    static juce::int64 getPrefetchSamples(const juce::AudioFormatReader& reader);
+
+private:
+    MappedAudioReader() = delete;
+};
@@ -230,6 +230,10 @@ void PlaylistTreeComponent::PlaylistItem::itemDropped(const juce::DragAndDropTar
                     if (databaseManager.addFolderTrackLink(link, linkId))
                     {
                         successCount++;
+                        
+                        // Tracks going into a playlist are likely to be played soon
+                        databaseManager.bumpJobPriority(databaseManager.getTrack(trackId).filePath,
+                                                        DatabaseManager::jobPriorityPlaylist);
                     }
                 }
                 else
@@ -214,8 +214,11 @@ juce::XmlElement* RekordboxExporter::createTrackElement(const DatabaseManager::T
     trackElement->setAttribute("Genre", track.genre);
     trackElement->setAttribute("Kind", juce::File(track.filePath).getFileExtension().toUpperCase() + " File");
     
-    if (track.bpm > 0)
-        trackElement->setAttribute("AverageBpm", track.bpm);
+    // Prefer the fractional tempo so beatgrids do not drift over long tracks
+    const double bpm = track.bpmPrecise > 0.0 ? track.bpmPrecise : static_cast<double>(track.bpm);
+    
+    if (bpm > 0.0)
+        trackElement->setAttribute("AverageBpm", juce::String(bpm, 2));
     
     if (!track.key.isEmpty())
         trackElement->setAttribute("Tonality", convertKeyToRekordbox(track.key));
@@ -230,39 +233,34 @@ juce::XmlElement* RekordboxExporter::createTrackElement(const DatabaseManager::T
     // Advanced cue point support - export all cue points from database
     auto cuePoints = databaseManager.getCuePointsForTrack(track.id);
     
-    if (cuePoints.empty())
-    {
-        // If no cue points, add a basic tempo marker at the start
-        auto* tempoElement = new juce::XmlElement("TEMPO");
-        tempoElement->setAttribute("Inizio", "0.000");
-        if (track.bpm > 0)
-            tempoElement->setAttribute("Bpm", juce::String(static_cast<double>(track.bpm), 2));
-        trackElement->addChildElement(tempoElement);
-    }
-    else
+    for (const auto& cue : cuePoints)
     {
-        // Export all cue points
-        for (const auto& cue : cuePoints)
+        if (cue.type == 0 || cue.type == 1)  // Memory cue or Hot cue
         {
-            if (cue.type == 0 || cue.type == 1)  // Memory cue or Hot cue
-            {
-                auto* cueElement = new juce::XmlElement("POSITION_MARK");
-                cueElement->setAttribute("Name", cue.name.isEmpty() ? "CUE" : cue.name);
-                cueElement->setAttribute("Type", cue.type);  // 0=Memory, 1=Hot Cue
-                cueElement->setAttribute("Start", juce::String(cue.position, 3));
-                cueElement->setAttribute("Num", cue.hotCueNumber);
-                if (cue.color.isNotEmpty())
-                    cueElement->setAttribute("Red", cue.color);
-                trackElement->addChildElement(cueElement);
-            }
+            auto* cueElement = new juce::XmlElement("POSITION_MARK");
+            cueElement->setAttribute("Name", cue.name.isEmpty() ? "CUE" : cue.name);
+            cueElement->setAttribute("Type", cue.type);  // 0=Memory, 1=Hot Cue
+            cueElement->setAttribute("Start", juce::String(cue.position, 3));
+            cueElement->setAttribute("Num", cue.hotCueNumber);
+            if (cue.color.isNotEmpty())
+                cueElement->setAttribute("Red", cue.color);
+            trackElement->addChildElement(cueElement);
         }
-        
-        // Add tempo marker if BPM is available
-        if (track.bpm > 0)
+    }
+    
+    // One TEMPO per grid marker. Without an analysed grid none is written, so
+    // rekordbox builds its own instead of trusting a guessed first beat.
+    DatabaseManager::BeatGrid beatGrid;
+    
+    if (databaseManager.getBeatGrid(track.id, beatGrid))
+    {
+        for (const auto& marker : beatGrid.markers)
         {
             auto* tempoElement = new juce::XmlElement("TEMPO");
-            tempoElement->setAttribute("Inizio", "0.000");
-            tempoElement->setAttribute("Bpm", juce::String(static_cast<double>(track.bpm), 2));
+            tempoElement->setAttribute("Inizio", juce::String(marker.position, 3));
+            tempoElement->setAttribute("Bpm", juce::String(marker.bpm, 2));
+            tempoElement->setAttribute("Metro", "4/4");
+            tempoElement->setAttribute("Battito", marker.beat);
             trackElement->addChildElement(tempoElement);
         }
     }
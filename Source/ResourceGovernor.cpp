@@ -0,0 +1,177 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+#include "ResourceGovernor.h"
+
+#if JUCE_WINDOWS
+#include <windows.h>
+#elif JUCE_MAC
+#include <IOKit/ps/IOPowerSources.h>
+#include <IOKit/ps/IOPSKeys.h>
+#endif
+
+//==============================================================================
+ResourceGovernor::ResourceGovernor(int numWorkersToGovern)
+    : numWorkers(juce::jmax(1, numWorkersToGovern)),
+      appliedPriority((size_t) numWorkers, juce::Thread::Priority::normal)
+{
+}
+
+void ResourceGovernor::setPreviewActive(bool isPlaying)
+{
+    previewActive = isPlaying;
+}
+
+void ResourceGovernor::noteUserActivity()
+{
+    // Zero means "never", so skip it when the counter wraps
+    lastUserActivity = juce::jmax((juce::uint32) 1, juce::Time::getMillisecondCounter());
+}
+
+//==============================================================================
+ResourceGovernor::Budget ResourceGovernor::getBudget() const
+{
+    Budget budget;
+    budget.maxActiveWorkers = numWorkers;
+    
+    auto restrict = [&budget](int workers, juce::Thread::Priority priority)
+    {
+        budget.maxActiveWorkers = juce::jmin(budget.maxActiveWorkers, juce::jmax(1, workers));
+        
+        if ((int) priority < (int) budget.priority)
+            budget.priority = priority;
+    };
+    
+    const auto lastActivity = lastUserActivity.load();
+    
+    if (lastActivity != 0 && juce::Time::getMillisecondCounter() - lastActivity < (juce::uint32) userActivityHoldMs)
+        restrict(numWorkers - 1, juce::Thread::Priority::low);
+    
+    if (onBattery())
+        restrict(numWorkers / 2, juce::Thread::Priority::low);
+    
+    if (previewActive)
+    {
+        restrict(1, juce::Thread::Priority::background);
+        budget.maxBytesPerSecond = previewBytesPerSecond;
+    }
+    
+    return budget;
+}
+
+void ResourceGovernor::waitForTurn(int workerIndex, juce::int64 numBytes, const CancellationToken* cancellation)
+{
+    auto* thread = juce::Thread::getCurrentThread();
+    
+    // A paused worker whose job is shut down or preempted must let go of it promptly
+    while (!CancellationToken::shouldStop(cancellation))
+    {
+        const auto budget = getBudget();
+        
+        if (thread != nullptr && juce::isPositiveAndBelow(workerIndex, numWorkers)
+            && appliedPriority[(size_t) workerIndex] != budget.priority)
+        {
+            thread->setPriority(budget.priority);
+            appliedPriority[(size_t) workerIndex] = budget.priority;
+        }
+        
+        int waitMs = 0;
+        
+        if (!budget.admits(workerIndex))
+        {
+            // Sit out until the budget grows again
+            waitMs = pollIntervalMs;
+        }
+        else if (budget.maxBytesPerSecond > 0)
+        {
+            const juce::ScopedLock lock(ioLock);
+            
+            // Refill the bucket, allowing bursts of a quarter second
+            const auto now = juce::Time::getMillisecondCounter();
+            const double rate = (double) budget.maxBytesPerSecond;
+            
+            if (lastRefill != 0)
+                ioAllowance = juce::jmin(rate * 0.25, ioAllowance + rate * (now - lastRefill) / 1000.0);
+            
+            lastRefill = now;
+            
+            if (ioAllowance < 0.0)
+                waitMs = juce::jlimit(1, pollIntervalMs, (int) std::ceil(-ioAllowance * 1000.0 / rate));
+            else
+                ioAllowance -= (double) numBytes;
+        }
+        
+        if (waitMs == 0)
+            return;
+        
+        // Waiting on the thread itself lets stopping the pool or preemption wake it
+        if (thread != nullptr)
+            thread->wait(waitMs);
+        else
+            juce::Thread::sleep(waitMs);
+    }
+}
+
+//==============================================================================
+bool ResourceGovernor::onBattery() const
+{
+    const auto now = juce::Time::getMillisecondCounter();
+    
+    if (!batteryPolled || now - lastBatteryPoll > (juce::uint32) batteryPollMs)
+    {
+        batteryCached = isOnBatteryPower();
+        lastBatteryPoll = now;
+        batteryPolled = true;
+    }
+    
+    return batteryCached;
+}
+
+bool ResourceGovernor::isOnBatteryPower()
+{
+   #if JUCE_WINDOWS
+    SYSTEM_POWER_STATUS status;
+    return GetSystemPowerStatus(&status) && status.ACLineStatus == 0;
+   #elif JUCE_MAC
+    auto info = IOPSCopyPowerSourcesInfo();
+    
+    if (info == nullptr)
+        return false;
+    
+    const bool battery = CFStringCompare(IOPSGetProvidingPowerSourceType(info), CFSTR(kIOPMBatteryPowerKey), 0)
+                             == kCFCompareEqualTo;
+    CFRelease(info);
+    return battery;
+   #elif JUCE_LINUX
+    // Any battery reporting that it discharges means the mains are gone
+    for (const auto& supply : juce::File("/sys/class/power_supply").findChildFiles(juce::File::findDirectories, false))
+    {
+        if (supply.getChildFile("type").loadFileAsString().trim() == "Battery"
+            && supply.getChildFile("status").loadFileAsString().trim() == "Discharging")
+            return true;
+    }
+    
+    return false;
+   #else
+    return false;
+   #endif
+}
@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "CancellationToken.h"
+#include <atomic>
+#include <vector>
+
+//==============================================================================
+/**
+    Decides how much of the machine the analysis workers may use, so background
+    imports never make the audio preview glitch or the UI lag.
+
+    It weighs three inputs and applies the strictest budget among them:
+
+    - Preview playing: one worker at background priority, disk reads capped
+    - Recent UI interaction: one worker fewer, at low priority
+    - Running on battery: half the workers, at low priority
+
+    Workers call waitForTurn() before every read. Workers over the budget wait
+    there, mid-job if needed, until the budget grows again. The call also
+    applies the budget's thread priority and paces reads to its byte rate.
+*/
+class ResourceGovernor
+{
+public:
+    //==============================================================================
+    /** What the workers may use right now. */
+    struct Budget
+    {
+        int maxActiveWorkers = 1;
+        juce::Thread::Priority priority = juce::Thread::Priority::normal;
+        juce::int64 maxBytesPerSecond = 0;  // Summed over all workers; 0 for no limit
+        
+        /** Whether the worker with this pool index may work; the others wait in waitForTurn(). */
+        bool admits(int workerIndex) const  { return workerIndex < maxActiveWorkers; }
+    };
+    
+    //==============================================================================
+    /** @param numWorkers The size of the worker pool being governed */
+    explicit ResourceGovernor(int numWorkers);
+    
+    /** Report whether an audio preview is playing. Safe to call from any thread. */
+    void setPreviewActive(bool isPlaying);
+    bool isPreviewActive() const  { return previewActive; }
+    
+    /** Report a mouse or keyboard event; the UI counts as busy for userActivityHoldMs. */
+    void noteUserActivity();
+    
+    /** The budget for the current state. */
+    Budget getBudget() const;
+    
+    /**
+     * Called by a worker thread before it reads numBytes from disk. Blocks while
+     * the worker is over the budget or reads run ahead of the byte rate, and
+     * returns early once the calling thread is asked to exit or the token is cancelled.
+     * @param workerIndex The worker's index in the pool, from 0
+     * @param numBytes Bytes about to be read (an estimate is fine)
+     * @param cancellation The running job's token, or nullptr between jobs (not owned)
+     */
+    void waitForTurn(int workerIndex, juce::int64 numBytes, const CancellationToken* cancellation = nullptr);
+    
+    /** True if the machine is running on battery; false if unknown. */
+    static bool isOnBatteryPower();
+    
+    //==============================================================================
+    static constexpr int userActivityHoldMs = 3000;
+    static constexpr int batteryPollMs = 30000;
+    static constexpr int pollIntervalMs = 100;
+    static constexpr juce::int64 previewBytesPerSecond = 4 * 1024 * 1024;
+
+private:
+    //==============================================================================
+    bool onBattery() const;
+    
+    const int numWorkers;
+    std::atomic<bool> previewActive{false};
+    std::atomic<juce::uint32> lastUserActivity{0};
+    
+    // Battery state is cached between polls
+    mutable std::atomic<bool> batteryCached{false};
+    mutable std::atomic<juce::uint32> lastBatteryPoll{0};
+    mutable std::atomic<bool> batteryPolled{false};
+    
+    // Token bucket shared by all workers; a read may leave it in debt
+    juce::CriticalSection ioLock;
+    double ioAllowance = 0.0;
+    juce::uint32 lastRefill = 0;
+    
+    // Only touched by each worker's own thread
+    std::vector<juce::Thread::Priority> appliedPriority;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResourceGovernor)
+};
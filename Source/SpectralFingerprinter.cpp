@@ -0,0 +1,212 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+
+#include "SpectralFingerprinter.h"
+
+//==============================================================================
+SpectralFingerprinter::SpectralFingerprinter()
+    : fft(fftOrder),
+      window((size_t) fftSize),
+      frame((size_t) fftSize),
+      fftBuffer((size_t) fftSize * 2)
+{
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), (size_t) fftSize,
+                                                             juce::dsp::WindowingFunction<float>::hann, false);
+
+    // Band edges spaced evenly in log frequency, each band at least one bin wide
+    const double binWidth = (double) FingerprintResampler::outputSampleRate / fftSize;
+
+    for (int band = 0; band <= numBands; ++band)
+    {
+        const double frequency = minFrequency * std::pow(maxFrequency / minFrequency, (double) band / numBands);
+        bandEdges[(size_t) band] = juce::roundToInt(frequency / binWidth);
+
+        if (band > 0)
+            bandEdges[(size_t) band] = juce::jmax(bandEdges[(size_t) band], bandEdges[(size_t) band - 1] + 1);
+    }
+
+    // A Hann-windowed sine of amplitude A peaks at A * fftSize / 4 in its bin
+    silenceEnergy = juce::square(juce::Decibels::decibelsToGain(silenceDecibels) * fftSize / 4.0f);
+}
+
+SpectralFingerprinter::~SpectralFingerprinter()
+{
+}
+
+//==============================================================================
+bool SpectralFingerprinter::prepare(const juce::AudioFormatReader& reader)
+{
+    fingerprint.clear();
+    frameFill = 0;
+    hasPreviousFrame = false;
+    samplesFed = 0;
+
+    if (reader.sampleRate <= 0 || reader.lengthInSamples <= 0 || reader.numChannels == 0)
+        return false;
+
+    samplesWanted = juce::jmin(reader.lengthInSamples, (juce::int64) (maxSeconds * reader.sampleRate));
+    resampler.prepare(reader.sampleRate, static_cast<int>(reader.numChannels));
+    return true;
+}
+
+void SpectralFingerprinter::beginWindow(juce::int64 startSample, juce::int64)
+{
+    // Frames must be evenly spaced from the start of the file, so stop at the first jump
+    if (startSample != samplesFed)
+        samplesWanted = samplesFed;
+}
+
+void SpectralFingerprinter::processBlock(const juce::AudioBuffer<float>& block, int numSamples, juce::int64)
+{
+    const int samplesToFeed = static_cast<int>(juce::jmin((juce::int64) numSamples, samplesWanted - samplesFed));
+
+    if (samplesToFeed <= 0)
+        return;
+
+    samplesFed += samplesToFeed;
+
+    const int numResampled = resampler.process(block, samplesToFeed);
+    const int16_t* resampled = resampler.getOutput();
+
+    for (int i = 0; i < numResampled; ++i)
+    {
+        frame[(size_t) frameFill++] = resampled[i] / 32768.0f;
+
+        if (frameFill == fftSize)
+        {
+            processFrame();
+
+            std::copy(frame.begin() + hopSize, frame.end(), frame.begin());
+            frameFill = fftSize - hopSize;
+        }
+    }
+}
+
+bool SpectralFingerprinter::wantsMoreAudio() const
+{
+    return samplesFed < samplesWanted;
+}
+
+bool SpectralFingerprinter::finish()
+{
+    DBG("[SpectralFingerprinter] " << (int) fingerprint.size() << " frames fingerprinted");
+    return fingerprint.size() >= (size_t) minOverlapFrames;
+}
+
+void SpectralFingerprinter::processFrame()
+{
+    juce::FloatVectorOperations::multiply(fftBuffer.data(), frame.data(), window.data(), fftSize);
+    juce::FloatVectorOperations::clear(fftBuffer.data() + fftSize, fftSize);
+
+    fft.performFrequencyOnlyForwardTransform(fftBuffer.data(), true);
+
+    std::array<float, numBands> energy {};
+    float totalEnergy = 0.0f;
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        for (int bin = bandEdges[(size_t) band]; bin < bandEdges[(size_t) band + 1]; ++bin)
+            energy[(size_t) band] += fftBuffer[(size_t) bin] * fftBuffer[(size_t) bin];
+
+        totalEnergy += energy[(size_t) band];
+    }
+
+    const bool silent = totalEnergy < silenceEnergy;
+
+    // The first frame of the track, or after silence, only provides the reference for the next
+    if (hasPreviousFrame && !silent)
+    {
+        juce::uint32 word = 0;
+
+        for (int band = 0; band < numBands - 1; ++band)
+        {
+            const float difference = (energy[(size_t) band] - energy[(size_t) band + 1])
+                                   - (previousEnergy[(size_t) band] - previousEnergy[(size_t) band + 1]);
+
+            if (difference > 0.0f)
+                word |= (juce::uint32) 1 << band;
+        }
+
+        fingerprint.push_back(word);
+    }
+    else if (!fingerprint.empty())
+    {
+        // Leading silence is dropped; anywhere else the frame keeps its place in time
+        fingerprint.push_back(silentWord);
+    }
+
+    previousEnergy = energy;
+    hasPreviousFrame = !silent;
+}
+
+//==============================================================================
+double SpectralFingerprinter::getBitErrorRate(const std::vector<juce::uint32>& a, const std::vector<juce::uint32>& b,
+                                              int maxOffsetFrames)
+{
+    double best = 1.0;
+
+    for (int offset = -maxOffsetFrames; offset <= maxOffsetFrames; ++offset)
+    {
+        // Frame i of a lines up with frame i + offset of b
+        const int first = juce::jmax(0, -offset);
+        const int last = juce::jmin((int) a.size(), (int) b.size() - offset);
+        const int overlap = last - first;
+
+        if (overlap < minOverlapFrames)
+            continue;
+
+        const int differingBits = countDifferingBits(a.data() + first, b.data() + first + offset, overlap);
+        best = juce::jmin(best, differingBits / (32.0 * overlap));
+    }
+
+    return best;
+}
+
+bool SpectralFingerprinter::isDegenerate(juce::uint32 word)
+{
+    const int numBits = juce::countNumberOfBits(word);
+    return numBits < minWordBits || numBits > 32 - minWordBits;
+}
+
+int SpectralFingerprinter::countDifferingBits(const juce::uint32* a, const juce::uint32* b, int numWords)
+{
+    constexpr int lanes = popcountLanes;
+    int counts[lanes] = {};
+    int i = 0;
+
+    for (; i + lanes <= numWords; i += lanes)
+    {
+        for (int lane = 0; lane < lanes; ++lane)
+            counts[lane] += juce::countNumberOfBits(a[i + lane] ^ b[i + lane]);
+    }
+
+    int total = 0;
+
+    for (int lane = 0; lane < lanes; ++lane)
+        total += counts[lane];
+
+    for (; i < numWords; ++i)
+        total += juce::countNumberOfBits(a[i] ^ b[i]);
+
+    return total;
+}
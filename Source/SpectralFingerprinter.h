@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+
+#pragma once
+
+#include "AnalysisPipeline.h"
+#include "FingerprintResampler.h"
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <vector>
+
+//==============================================================================
+/**
+    Built-in audio fingerprint for duplicate detection, available on every
+    platform whether or not Chromaprint is installed.
+
+    The first two minutes of a track are resampled to 11025 Hz mono and cut
+    into 186 ms frames every 46 ms. Each frame's energy is measured in 33
+    logarithmically spaced bands between 300 and 2000 Hz, and every frame
+    yields one 32-bit word: bit m is set when the energy difference between
+    bands m and m + 1 grew since the previous frame. Those differences of
+    differences survive re-encoding, resampling and level changes, so two
+    copies of a recording give words that differ in only a few bits.
+
+    Silence says nothing about a recording, so frames quieter than
+    silenceDecibels in those bands are not fingerprinted: leading silence is
+    left out, so the fingerprint starts where the music does, and later silent
+    frames (and the first frame after them) keep their place as silentWord.
+
+    Fingerprints are compared by bit error rate: the fraction of differing
+    bits (the Hamming distance over the number of bits compared), at the best
+    of a few frame offsets so encoder delay does not matter.
+*/
+class SpectralFingerprinter : public AnalysisConsumer
+{
+public:
+    //==============================================================================
+    SpectralFingerprinter();
+    ~SpectralFingerprinter() override;
+
+    bool prepare(const juce::AudioFormatReader& reader) override;
+    void beginWindow(juce::int64 startSample, juce::int64 numSamples) override;
+    void processBlock(const juce::AudioBuffer<float>& block, int numSamples, juce::int64 startSample) override;
+    bool wantsMoreAudio() const override;
+    bool finish() override;
+
+    /** One 32-bit word per frame of the last file; empty if it was too short. */
+    const std::vector<juce::uint32>& getFingerprint() const  { return fingerprint; }
+
+    /**
+     * Fraction of differing bits between two fingerprints, at the frame offset
+     * (up to maxOffsetFrames either way) where they agree best.
+     * @return 0 for identical audio, about 0.5 for unrelated audio, and 1 if
+     *         the fingerprints overlap by fewer than minOverlapFrames
+     */
+    static double getBitErrorRate(const std::vector<juce::uint32>& a, const std::vector<juce::uint32>& b,
+                                  int maxOffsetFrames = defaultMaxOffsetFrames);
+
+    /**
+     * Number of differing bits between two runs of words (the Hamming distance).
+     * Counted in popcountLanes independent lanes, so the compiler can vectorise it.
+     */
+    static int countDifferingBits(const juce::uint32* a, const juce::uint32* b, int numWords);
+
+    /**
+     * True for words that tell nothing about the audio: silentWord, and the
+     * near-empty or near-full words of frames so stationary that almost no
+     * band difference changed. Every track has them, so they must not be
+     * used to look tracks up.
+     */
+    static bool isDegenerate(juce::uint32 word);
+
+    /** Copies of the same recording stay well below this bit error rate. */
+    static constexpr double matchThreshold = 0.3;
+
+    static constexpr juce::uint32 silentWord = 0;
+    static constexpr float silenceDecibels = -60.0f;    // Quieter frames (as a sine level, dBFS) are silent
+    static constexpr int minWordBits = 3;               // Fewer set (or clear) bits make a word degenerate
+
+    static constexpr double maxSeconds = 120.0;
+    static constexpr int defaultMaxOffsetFrames = 8;    // About 370 ms
+    static constexpr int minOverlapFrames = 64;         // About 3 seconds
+    static constexpr int popcountLanes = 8;
+
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 4;
+    static constexpr int numBands = 33;
+    static constexpr double minFrequency = 300.0;
+    static constexpr double maxFrequency = 2000.0;
+
+private:
+    //==============================================================================
+    void processFrame();
+
+    juce::dsp::FFT fft;
+    std::vector<float> window;
+    std::array<int, numBands + 1> bandEdges {};    // First FFT bin of each band, then the end of the last
+    float silenceEnergy = 0.0f;                     // Summed band energy of a frame at silenceDecibels
+
+    FingerprintResampler resampler;
+    juce::int64 samplesWanted = 0;
+    juce::int64 samplesFed = 0;
+
+    std::vector<float> frame;
+    int frameFill = 0;
+    std::vector<float> fftBuffer;
+
+    std::array<float, numBands> previousEnergy {};
+    bool hasPreviousFrame = false;
+
+    std::vector<juce::uint32> fingerprint;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectralFingerprinter)
+};
@@ -0,0 +1,1190 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+
+#include "TagReader.h"
+#include <cstring>
+#include <string>
+
+//==============================================================================
+namespace
+{
+    uint32_t readBE32(const uint8_t* p)  { return (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 8 | p[3]; }
+    uint32_t readBE24(const uint8_t* p)  { return (uint32_t) p[0] << 16 | (uint32_t) p[1] << 8 | p[2]; }
+    uint32_t readBE16(const uint8_t* p)  { return (uint32_t) p[0] << 8 | p[1]; }
+    uint32_t readLE32(const uint8_t* p)  { return (uint32_t) p[3] << 24 | (uint32_t) p[2] << 16 | (uint32_t) p[1] << 8 | p[0]; }
+    
+    uint64_t readBE64(const uint8_t* p)  { return (uint64_t) readBE32(p) << 32 | readBE32(p + 4); }
+    
+    // ID3v2 sizes store 7 bits per byte
+    uint32_t readSyncSafe32(const uint8_t* p)
+    {
+        return (uint32_t) (p[0] & 0x7f) << 21 | (uint32_t) (p[1] & 0x7f) << 14
+             | (uint32_t) (p[2] & 0x7f) << 7 | (uint32_t) (p[3] & 0x7f);
+    }
+    
+    bool matches(const uint8_t* p, const char* id, size_t length = 4)
+    {
+        return std::memcmp(p, id, length) == 0;
+    }
+    
+    //==============================================================================
+    void appendUTF8(std::string& out, uint32_t codePoint)
+    {
+        if (codePoint < 0x80)
+        {
+            out += (char) codePoint;
+        }
+        else if (codePoint < 0x800)
+        {
+            out += (char) (0xc0 | (codePoint >> 6));
+            out += (char) (0x80 | (codePoint & 0x3f));
+        }
+        else if (codePoint < 0x10000)
+        {
+            out += (char) (0xe0 | (codePoint >> 12));
+            out += (char) (0x80 | ((codePoint >> 6) & 0x3f));
+            out += (char) (0x80 | (codePoint & 0x3f));
+        }
+        else
+        {
+            out += (char) (0xf0 | (codePoint >> 18));
+            out += (char) (0x80 | ((codePoint >> 12) & 0x3f));
+            out += (char) (0x80 | ((codePoint >> 6) & 0x3f));
+            out += (char) (0x80 | (codePoint & 0x3f));
+        }
+    }
+    
+    juce::String fromStdString(const std::string& utf8)
+    {
+        return juce::String::fromUTF8(utf8.data(), (int) utf8.size()).trim();
+    }
+    
+    juce::String decodeLatin1(const uint8_t* p, size_t size)
+    {
+        std::string utf8;
+        for (size_t i = 0; i < size && p[i] != 0; ++i)
+            appendUTF8(utf8, p[i]);
+        
+        return fromStdString(utf8);
+    }
+    
+    bool isValidUTF8(const uint8_t* p, size_t size)
+    {
+        for (size_t i = 0; i < size;)
+        {
+            const uint8_t c = p[i];
+            const size_t extra = c < 0x80 ? 0 : (c >> 5) == 0x6 ? 1 : (c >> 4) == 0xe ? 2 : (c >> 3) == 0x1e ? 3 : 4;
+            
+            if (extra == 4 || i + extra >= size + (extra == 0 ? 1 : 0))
+                return extra == 0;
+            
+            for (size_t k = 1; k <= extra; ++k)
+            {
+                if ((p[i + k] & 0xc0) != 0x80)
+                    return false;
+            }
+            
+            i += extra + 1;
+        }
+        
+        return true;
+    }
+    
+    juce::String decodeUTF8(const uint8_t* p, size_t size)
+    {
+        size_t length = 0;
+        while (length < size && p[length] != 0)
+            ++length;
+        
+        return fromStdString(std::string((const char*) p, length));
+    }
+    
+    // RIFF and AIFF text has no declared encoding: UTF-8 if it is valid, else Latin-1
+    juce::String decodeLegacyText(const uint8_t* p, size_t size)
+    {
+        size_t length = 0;
+        while (length < size && p[length] != 0)
+            ++length;
+        
+        return isValidUTF8(p, length) ? decodeUTF8(p, length) : decodeLatin1(p, length);
+    }
+    
+    juce::String decodeUTF16(const uint8_t* p, size_t size, bool bigEndian)
+    {
+        std::string utf8;
+        
+        for (size_t i = 0; i + 1 < size; i += 2)
+        {
+            uint32_t unit = bigEndian ? readBE16(p + i) : (uint32_t) (p[i] | p[i + 1] << 8);
+            
+            if (unit == 0)
+                break;
+            
+            // Combine surrogate pairs
+            if (unit >= 0xd800 && unit < 0xdc00 && i + 3 < size)
+            {
+                uint32_t low = bigEndian ? readBE16(p + i + 2) : (uint32_t) (p[i + 2] | p[i + 3] << 8);
+                
+                if (low >= 0xdc00 && low < 0xe000)
+                {
+                    unit = 0x10000 + ((unit - 0xd800) << 10) + (low - 0xdc00);
+                    i += 2;
+                }
+            }
+            
+            appendUTF8(utf8, unit);
+        }
+        
+        return fromStdString(utf8);
+    }
+    
+    //==============================================================================
+    /**
+        Splits the body of an ID3v2 text frame (encoding byte, then one or more
+        terminated strings) into its strings.
+    */
+    std::vector<juce::String> decodeId3TextValues(const uint8_t* body, size_t size)
+    {
+        std::vector<juce::String> values;
+        
+        if (size < 1)
+            return values;
+        
+        const uint8_t encoding = body[0];
+        const bool wide = (encoding == 1 || encoding == 2);
+        const uint8_t* p = body + 1;
+        const size_t length = size - 1;
+        
+        size_t start = 0;
+        
+        while (start < length)
+        {
+            // Find the terminator (a zero byte, or a zero UTF-16 code unit)
+            size_t end = start;
+            if (wide)
+            {
+                while (end + 1 < length && (p[end] != 0 || p[end + 1] != 0))
+                    end += 2;
+                
+                end = juce::jmin(end, length);
+            }
+            else
+            {
+                while (end < length && p[end] != 0)
+                    ++end;
+            }
+            
+            const uint8_t* text = p + start;
+            size_t textSize = end - start;
+            
+            switch (encoding)
+            {
+                case 0:
+                    values.push_back(decodeLatin1(text, textSize));
+                    break;
+                
+                case 1:
+                {
+                    // UTF-16 with byte order mark (little endian if it is missing)
+                    bool bigEndian = false;
+                    if (textSize >= 2 && ((text[0] == 0xfe && text[1] == 0xff) || (text[0] == 0xff && text[1] == 0xfe)))
+                    {
+                        bigEndian = text[0] == 0xfe;
+                        text += 2;
+                        textSize -= 2;
+                    }
+                    values.push_back(decodeUTF16(text, textSize, bigEndian));
+                    break;
+                }
+                
+                case 2:
+                    values.push_back(decodeUTF16(text, textSize, true));
+                    break;
+                
+                default:
+                    values.push_back(decodeUTF8(text, textSize));
+                    break;
+            }
+            
+            start = end + (wide ? 2 : 1);
+        }
+        
+        return values;
+    }
+    
+    juce::String decodeId3Text(const uint8_t* body, size_t size)
+    {
+        for (const auto& value : decodeId3TextValues(body, size))
+        {
+            if (value.isNotEmpty())
+                return value;
+        }
+        
+        return {};
+    }
+    
+    // Reverse ID3v2 unsynchronisation (every 0xff 0x00 pair was written for a 0xff)
+    std::vector<uint8_t> removeUnsynchronisation(const uint8_t* p, size_t size)
+    {
+        std::vector<uint8_t> out;
+        out.reserve(size);
+        
+        for (size_t i = 0; i < size; ++i)
+        {
+            out.push_back(p[i]);
+            
+            if (p[i] == 0xff && i + 1 < size && p[i + 1] == 0x00)
+                ++i;
+        }
+        
+        return out;
+    }
+    
+    //==============================================================================
+    bool setIfEmpty(juce::String& field, const juce::String& value)
+    {
+        if (value.isEmpty())
+            return false;
+        
+        if (field.isEmpty())
+            field = value;
+        
+        return true;
+    }
+    
+    bool setBpmIfEmpty(double& bpm, const juce::String& value)
+    {
+        const double parsed = value.getDoubleValue();
+        
+        if (parsed <= 0.0 || parsed > 999.0)
+            return false;
+        
+        if (bpm <= 0.0)
+            bpm = parsed;
+        
+        return true;
+    }
+    
+    /**
+        ID3v2 genres may be a plain name, an ID3v1 number ("17"), or a number in
+        parentheses optionally followed by a refinement ("(17)" or "(17)Rock").
+    */
+    juce::String resolveId3Genre(const juce::String& genre)
+    {
+        const std::string text = genre.toStdString();
+        
+        auto isNumber = [](const std::string& s)
+        {
+            return !s.empty() && s.size() <= 3 && s.find_first_not_of("0123456789") == std::string::npos;
+        };
+        
+        if (isNumber(text))
+        {
+            auto name = TagReader::getId3v1Genre(std::stoi(text));
+            return name.isNotEmpty() ? name : genre;
+        }
+        
+        if (text.size() > 2 && text[0] == '(')
+        {
+            const auto close = text.find(')');
+            
+            if (close != std::string::npos)
+            {
+                const auto refinement = text.substr(close + 1);
+                if (!refinement.empty())
+                    return fromStdString(refinement);
+                
+                const auto number = text.substr(1, close - 1);
+                if (isNumber(number))
+                    return TagReader::getId3v1Genre(std::stoi(number));
+            }
+        }
+        
+        return genre;
+    }
+    
+    std::string toUpperASCII(const uint8_t* p, size_t size)
+    {
+        std::string out((const char*) p, size);
+        for (auto& c : out)
+        {
+            if (c >= 'a' && c <= 'z')
+                c = (char) (c - 'a' + 'A');
+        }
+        return out;
+    }
+    
+    // Shared by Vorbis comments, TXXX frames and MP4 freeform items
+    bool applyNamedField(const std::string& upperName, const juce::String& value, TagReader::Tags& tags)
+    {
+        if (upperName == "TITLE")                           return setIfEmpty(tags.title, value);
+        if (upperName == "ARTIST")                          return setIfEmpty(tags.artist, value);
+        if (upperName == "ALBUM")                           return setIfEmpty(tags.album, value);
+        if (upperName == "GENRE")                           return setIfEmpty(tags.genre, value);
+        if (upperName == "BPM" || upperName == "TEMPO")     return setBpmIfEmpty(tags.bpm, value);
+        if (upperName == "INITIALKEY" || upperName == "KEY") return setIfEmpty(tags.key, value);
+        
+        return false;
+    }
+    
+    //==============================================================================
+    /**
+        Calls fn(type, payload, payloadSize) for each MP4 atom in a buffer.
+        Handles 64-bit sizes and the size-0 "extends to the end" form.
+    */
+    template <typename Callback>
+    void forEachAtom(const uint8_t* data, size_t size, Callback&& fn)
+    {
+        size_t pos = 0;
+        
+        while (pos + 8 <= size)
+        {
+            uint64_t atomSize = readBE32(data + pos);
+            size_t headerSize = 8;
+            
+            if (atomSize == 1)
+            {
+                if (pos + 16 > size)
+                    return;
+                
+                atomSize = readBE64(data + pos + 8);
+                headerSize = 16;
+            }
+            else if (atomSize == 0)
+            {
+                atomSize = size - pos;
+            }
+            
+            if (atomSize < headerSize || atomSize > size - pos)
+                return;
+            
+            fn(data + pos + 4, data + pos + headerSize, (size_t) atomSize - headerSize);
+            pos += (size_t) atomSize;
+        }
+    }
+    
+    /** The payload of the first 'data' atom inside an ilst item, and its type code. */
+    bool findMp4Data(const uint8_t* item, size_t size, const uint8_t*& payload, size_t& payloadSize, uint32_t& type)
+    {
+        bool found = false;
+        
+        forEachAtom(item, size, [&](const uint8_t* atomType, const uint8_t* body, size_t bodySize)
+        {
+            // data atoms start with a type/flags word and a locale word
+            if (!found && matches(atomType, "data") && bodySize >= 8)
+            {
+                type = readBE32(body) & 0xffffff;
+                payload = body + 8;
+                payloadSize = bodySize - 8;
+                found = true;
+            }
+        });
+        
+        return found;
+    }
+    
+    bool parseMp4Ilst(const uint8_t* data, size_t size, TagReader::Tags& tags)
+    {
+        bool found = false;
+        
+        forEachAtom(data, size, [&](const uint8_t* type, const uint8_t* item, size_t itemSize)
+        {
+            const uint8_t* payload = nullptr;
+            size_t payloadSize = 0;
+            uint32_t dataType = 0;
+            
+            if (matches(type, "----"))
+            {
+                // iTunes freeform item: mean, name, data
+                std::string name;
+                forEachAtom(item, itemSize, [&](const uint8_t* childType, const uint8_t* body, size_t bodySize)
+                {
+                    if (matches(childType, "name") && bodySize > 4)
+                        name = toUpperASCII(body + 4, bodySize - 4);
+                });
+                
+                if (findMp4Data(item, itemSize, payload, payloadSize, dataType))
+                    found |= applyNamedField(name, decodeUTF8(payload, payloadSize), tags);
+                
+                return;
+            }
+            
+            if (!findMp4Data(item, itemSize, payload, payloadSize, dataType))
+                return;
+            
+            // Text items are UTF-8 (type 1); tmpo and gnre are big-endian integers
+            if (matches(type, "\xa9nam"))
+                found |= setIfEmpty(tags.title, decodeUTF8(payload, payloadSize));
+            else if (matches(type, "\xa9" "ART"))
+                found |= setIfEmpty(tags.artist, decodeUTF8(payload, payloadSize));
+            else if (matches(type, "\xa9" "alb"))
+                found |= setIfEmpty(tags.album, decodeUTF8(payload, payloadSize));
+            else if (matches(type, "\xa9gen"))
+                found |= setIfEmpty(tags.genre, decodeUTF8(payload, payloadSize));
+            else if (matches(type, "gnre") && payloadSize >= 2)
+                found |= setIfEmpty(tags.genre, TagReader::getId3v1Genre((int) readBE16(payload) - 1));
+            else if (matches(type, "tmpo") && payloadSize >= 2 && readBE16(payload) > 0)
+                found |= setBpmIfEmpty(tags.bpm, juce::String((int) readBE16(payload)));
+        });
+        
+        return found;
+    }
+    
+    bool parseMp4Meta(const uint8_t* data, size_t size, TagReader::Tags& tags)
+    {
+        // ISO meta atoms carry a version/flags word before their children; QuickTime ones do not
+        if (size >= 12 && !matches(data + 4, "hdlr"))
+        {
+            data += 4;
+            size -= 4;
+        }
+        
+        bool found = false;
+        
+        forEachAtom(data, size, [&](const uint8_t* type, const uint8_t* body, size_t bodySize)
+        {
+            if (matches(type, "ilst"))
+                found |= parseMp4Ilst(body, bodySize, tags);
+        });
+        
+        return found;
+    }
+    
+    //==============================================================================
+    const char* const id3v1Genres[] =
+    {
+        "Blues", "Classic Rock", "Country", "Dance", "Disco", "Funk", "Grunge", "Hip-Hop",
+        "Jazz", "Metal", "New Age", "Oldies", "Other", "Pop", "R&B", "Rap",
+        "Reggae", "Rock", "Techno", "Industrial", "Alternative", "Ska", "Death Metal", "Pranks",
+        "Soundtrack", "Euro-Techno", "Ambient", "Trip-Hop", "Vocal", "Jazz+Funk", "Fusion", "Trance",
+        "Classical", "Instrumental", "Acid", "House", "Game", "Sound Clip", "Gospel", "Noise",
+        "Alternative Rock", "Bass", "Soul", "Punk", "Space", "Meditative", "Instrumental Pop", "Instrumental Rock",
+        "Ethnic", "Gothic", "Darkwave", "Techno-Industrial", "Electronic", "Pop-Folk", "Eurodance", "Dream",
+        "Southern Rock", "Comedy", "Cult", "Gangsta", "Top 40", "Christian Rap", "Pop/Funk", "Jungle",
+        "Native American", "Cabaret", "New Wave", "Psychedelic", "Rave", "Showtunes", "Trailer", "Lo-Fi",
+        "Tribal", "Acid Punk", "Acid Jazz", "Polka", "Retro", "Musical", "Rock & Roll", "Hard Rock",
+        
+        // Winamp extensions
+        "Folk", "Folk-Rock", "National Folk", "Swing", "Fast Fusion", "Bebop", "Latin", "Revival",
+        "Celtic", "Bluegrass", "Avantgarde", "Gothic Rock", "Progressive Rock", "Psychedelic Rock", "Symphonic Rock", "Slow Rock",
+        "Big Band", "Chorus", "Easy Listening", "Acoustic", "Humour", "Speech", "Chanson", "Opera",
+        "Chamber Music", "Sonata", "Symphony", "Booty Bass", "Primus", "Porn Groove", "Satire", "Slow Jam",
+        "Club", "Tango", "Samba", "Folklore", "Ballad", "Power Ballad", "Rhythmic Soul", "Freestyle",
+        "Duet", "Punk Rock", "Drum Solo", "A Cappella", "Euro-House", "Dance Hall", "Goa", "Drum & Bass",
+        "Club-House", "Hardcore", "Terror", "Indie", "BritPop", "Afro-Punk", "Polsk Punk", "Beat",
+        "Christian Gangsta Rap", "Heavy Metal", "Black Metal", "Crossover", "Contemporary Christian", "Christian Rock", "Merengue", "Salsa",
+        "Thrash Metal", "Anime", "JPop", "Synthpop"
+    };
+}
+
+//==============================================================================
+bool TagReader::Tags::isEmpty() const
+{
+    return title.isEmpty() && artist.isEmpty() && album.isEmpty()
+        && genre.isEmpty() && key.isEmpty() && bpm <= 0.0;
+}
+
+//==============================================================================
+TagReader::TagReader()
+{
+}
+
+TagReader::~TagReader()
+{
+}
+
+juce::String TagReader::getId3v1Genre(int genreNumber)
+{
+    if (juce::isPositiveAndBelow(genreNumber, (int) (sizeof(id3v1Genres) / sizeof(id3v1Genres[0]))))
+        return id3v1Genres[genreNumber];
+    
+    return {};
+}
+
+//==============================================================================
+bool TagReader::readTags(const juce::File& audioFile, Tags& outTags)
+{
+    outTags = Tags();
+    file = audioFile;
+    fileSize = audioFile.getSize();
+    lastError.clear();
+    
+    if (fileSize < 12)
+    {
+        lastError = "File too small to contain tags: " + audioFile.getFileName();
+        return false;
+    }
+    
+    // Map the head of the file once; most tags are read from here without further I/O setup
+    headSize = juce::jmin(fileSize, headRegionSize);
+    headMapping = std::make_unique<juce::MemoryMappedFile>(audioFile, juce::Range<juce::int64>(0, headSize),
+                                                           juce::MemoryMappedFile::readOnly);
+    
+    if (headMapping->getData() != nullptr && headMapping->getRange().getStart() == 0)
+    {
+        headData = static_cast<const uint8_t*>(headMapping->getData());
+        headSize = juce::jmin(headSize, headMapping->getRange().getLength());
+    }
+    else
+    {
+        headMapping.reset();
+        headData = nullptr;
+    }
+    
+    auto header = read(0, 12);
+    
+    if (header.size < 12)
+    {
+        lastError = "Could not read: " + audioFile.getFileName();
+        return false;
+    }
+    
+    const uint8_t* h = header.data;
+    juce::int64 offset = 0;
+    
+    // ID3v2 at the start (MP3; some FLAC and AAC files too)
+    if (matches(h, "ID3", 3) && h[3] >= 2 && h[3] <= 4)
+    {
+        const juce::int64 tagSize = 10 + (juce::int64) readSyncSafe32(h + 6) + ((h[5] & 0x10) != 0 ? 10 : 0);
+        auto tag = read(0, juce::jmin(tagSize, maxTagSize));
+        parseId3v2(tag.data, tag.size, outTags);
+        offset = tagSize;
+    }
+    
+    if (offset == 0 && matches(h + 4, "ftyp"))
+        readMp4(outTags);
+    else if (offset == 0 && matches(h, "OggS"))
+        readOgg(outTags);
+    else if (offset == 0 && matches(h, "RIFF") && matches(h + 8, "WAVE"))
+        readRiff(outTags);
+    else if (offset == 0 && matches(h, "FORM") && (matches(h + 8, "AIFF") || matches(h + 8, "AIFC")))
+        readAiff(outTags);
+    else
+    {
+        auto marker = read(offset, 4);
+        if (marker.size == 4 && matches(marker.data, "fLaC"))
+            readFlac(offset, outTags);
+    }
+    
+    // ID3v1 in the last 128 bytes only fills in what the richer tags left empty
+    auto footer = read(fileSize - 128, 128);
+    parseId3v1(footer.data, footer.size, outTags);
+    
+    headMapping.reset();
+    headData = nullptr;
+    
+    return !outTags.isEmpty();
+}
+
+bool TagReader::findAudioPayload(const juce::File& audioFile, juce::Range<juce::int64>& outRange)
+{
+    file = audioFile;
+    fileSize = audioFile.getSize();
+    lastError.clear();
+    outRange = { 0, juce::jmax((juce::int64) 0, fileSize) };
+    
+    auto header = read(0, 12);
+    
+    if (header.size < 12)
+    {
+        lastError = "File too small to contain tags: " + audioFile.getFileName();
+        return false;
+    }
+    
+    const uint8_t* h = header.data;
+    
+    if (matches(h + 4, "ftyp"))
+        return findMp4Atom("mdat", outRange);
+    
+    if (matches(h, "RIFF") && matches(h + 8, "WAVE"))
+        return findChunk("data", false, outRange);
+    
+    if (matches(h, "FORM") && (matches(h + 8, "AIFF") || matches(h + 8, "AIFC")))
+        return findChunk("SSND", true, outRange);
+    
+    if (matches(h, "OggS"))
+    {
+        lastError = "Ogg comments are interleaved with the audio: " + audioFile.getFileName();
+        return false;
+    }
+    
+    // MP3 and FLAC: the audio follows any ID3v2 tag (and FLAC's metadata blocks)...
+    juce::int64 start = 0;
+    
+    if (matches(h, "ID3", 3) && h[3] >= 2 && h[3] <= 4)
+        start = 10 + (juce::int64) readSyncSafe32(h + 6) + ((h[5] & 0x10) != 0 ? 10 : 0);
+    
+    auto marker = read(start, 4);
+    
+    if (marker.size == 4 && matches(marker.data, "fLaC"))
+    {
+        start += 4;
+        
+        for (int i = 0; i < maxChunks; ++i)
+        {
+            auto blockHeader = read(start, 4);
+            if (blockHeader.size < 4)
+                return false;
+            
+            start += 4 + (juce::int64) readBE24(blockHeader.data + 1);
+            
+            if ((blockHeader.data[0] & 0x80) != 0)
+                break;
+        }
+    }
+    
+    // ...and runs up to an ID3v1 and/or APEv2 tag at the end
+    juce::int64 end = fileSize;
+    
+    auto id3v1 = read(end - 128, 3);
+    if (id3v1.size == 3 && matches(id3v1.data, "TAG", 3))
+        end -= 128;
+    
+    auto apeFooter = read(end - 32, 32);
+    if (apeFooter.size == 32 && matches(apeFooter.data, "APETAGEX", 8))
+    {
+        // The size covers the items and footer; a header adds another 32 bytes
+        const bool hasHeader = (apeFooter.data[23] & 0x80) != 0;
+        end -= (juce::int64) readLE32(apeFooter.data + 12) + (hasHeader ? 32 : 0);
+    }
+    
+    if (start >= end)
+    {
+        lastError = "No audio found between the tags: " + audioFile.getFileName();
+        return false;
+    }
+    
+    outRange = { start, end };
+    return true;
+}
+
+TagReader::Bytes TagReader::read(juce::int64 offset, juce::int64 length)
+{
+    Bytes bytes;
+    
+    if (offset < 0 || offset >= fileSize || length <= 0)
+        return bytes;
+    
+    length = juce::jmin(length, fileSize - offset);
+    
+    // Served from the head mapping
+    if (headData != nullptr && offset + length <= headSize)
+    {
+        bytes.data = headData + offset;
+        bytes.size = (size_t) length;
+        return bytes;
+    }
+    
+    bytes.mapping = std::make_unique<juce::MemoryMappedFile>(file, juce::Range<juce::int64>(offset, offset + length),
+                                                             juce::MemoryMappedFile::readOnly);
+    
+    // JUCE rounds the mapped start down to a page boundary
+    auto mappedRange = bytes.mapping->getRange();
+    
+    if (bytes.mapping->getData() != nullptr && mappedRange.getStart() <= offset && mappedRange.getEnd() > offset)
+    {
+        bytes.data = static_cast<const uint8_t*>(bytes.mapping->getData()) + (offset - mappedRange.getStart());
+        bytes.size = (size_t) juce::jmin(length, mappedRange.getEnd() - offset);
+        return bytes;
+    }
+    
+    // Mapping can fail (network shares, exotic filesystems); fall back to a plain read
+    bytes.mapping.reset();
+    
+    juce::FileInputStream stream(file);
+    
+    if (stream.failedToOpen() || !stream.setPosition(offset))
+        return bytes;
+    
+    bytes.copy.resize((size_t) length);
+    const int numRead = stream.read(bytes.copy.data(), (int) length);
+    
+    bytes.data = bytes.copy.data();
+    bytes.size = (size_t) juce::jmax(0, numRead);
+    return bytes;
+}
+
+//==============================================================================
+bool TagReader::readMp4(Tags& tags)
+{
+    // moov may sit after the audio data
+    juce::Range<juce::int64> moovRange;
+    
+    if (!findMp4Atom("moov", moovRange))
+        return false;
+    
+    auto moov = read(moovRange.getStart(), juce::jmin(moovRange.getLength(), maxTagSize));
+    return parseMp4Moov(moov.data, moov.size, tags);
+}
+
+bool TagReader::findMp4Atom(const char* id, juce::Range<juce::int64>& outRange)
+{
+    juce::int64 pos = 0;
+    
+    // Walk the top-level atoms by their headers
+    for (int i = 0; i < maxChunks && pos + 8 <= fileSize; ++i)
+    {
+        auto header = read(pos, 16);
+        if (header.size < 8)
+            return false;
+        
+        juce::int64 atomSize = readBE32(header.data);
+        juce::int64 headerSize = 8;
+        
+        if (atomSize == 1 && header.size >= 16)
+        {
+            atomSize = (juce::int64) readBE64(header.data + 8);
+            headerSize = 16;
+        }
+        else if (atomSize == 0)
+        {
+            atomSize = fileSize - pos;
+        }
+        
+        if (atomSize < headerSize)
+            return false;
+        
+        if (matches(header.data + 4, id))
+        {
+            outRange = { pos + headerSize, juce::jmin(fileSize, pos + atomSize) };
+            return true;
+        }
+        
+        pos += atomSize;
+    }
+    
+    return false;
+}
+
+bool TagReader::findChunk(const char* id, bool bigEndian, juce::Range<juce::int64>& outRange)
+{
+    juce::int64 pos = 12;
+    
+    for (int i = 0; i < maxChunks && pos + 8 <= fileSize; ++i)
+    {
+        auto header = read(pos, 8);
+        if (header.size < 8)
+            return false;
+        
+        const juce::int64 chunkSize = bigEndian ? readBE32(header.data + 4) : readLE32(header.data + 4);
+        
+        if (matches(header.data, id))
+        {
+            outRange = { pos + 8, juce::jmin(fileSize, pos + 8 + chunkSize) };
+            return true;
+        }
+        
+        // Chunks are padded to an even size
+        pos += 8 + chunkSize + (chunkSize & 1);
+    }
+    
+    return false;
+}
+
+bool TagReader::readFlac(juce::int64 offset, Tags& tags)
+{
+    juce::int64 pos = offset + 4;
+    
+    for (int i = 0; i < maxChunks; ++i)
+    {
+        auto header = read(pos, 4);
+        if (header.size < 4)
+            return false;
+        
+        const bool isLast = (header.data[0] & 0x80) != 0;
+        const int blockType = header.data[0] & 0x7f;
+        const juce::int64 blockSize = readBE24(header.data + 1);
+        
+        if (blockType == 4)  // VORBIS_COMMENT
+        {
+            auto block = read(pos + 4, blockSize);
+            return parseVorbisComment(block.data, block.size, tags);
+        }
+        
+        if (isLast)
+            return false;
+        
+        pos += 4 + blockSize;
+    }
+    
+    return false;
+}
+
+bool TagReader::readOgg(Tags& tags)
+{
+    // The comment header is the second packet of the first logical stream
+    std::vector<uint8_t> packet;
+    int packetIndex = 0;
+    juce::int64 pos = 0;
+    
+    for (int page = 0; page < maxChunks && pos + 27 <= fileSize; ++page)
+    {
+        auto header = read(pos, 27 + 255);
+        if (header.size < 27 || !matches(header.data, "OggS"))
+            return false;
+        
+        const int numSegments = header.data[26];
+        if (header.size < (size_t) (27 + numSegments))
+            return false;
+        
+        const uint8_t* lacing = header.data + 27;
+        juce::int64 bodySize = 0;
+        for (int s = 0; s < numSegments; ++s)
+            bodySize += lacing[s];
+        
+        auto body = read(pos + 27 + numSegments, bodySize);
+        size_t bodyPos = 0;
+        
+        for (int s = 0; s < numSegments && bodyPos + lacing[s] <= body.size; ++s)
+        {
+            if (packetIndex == 1 && (juce::int64) packet.size() < maxTagSize)
+                packet.insert(packet.end(), body.data + bodyPos, body.data + bodyPos + lacing[s]);
+            
+            bodyPos += lacing[s];
+            
+            // A lacing value below 255 ends the packet
+            if (lacing[s] < 255)
+            {
+                if (packetIndex == 1)
+                {
+                    if (packet.size() > 7 && matches(packet.data(), "\x03vorbis", 7))
+                        return parseVorbisComment(packet.data() + 7, packet.size() - 7, tags);
+                    
+                    if (packet.size() > 8 && matches(packet.data(), "OpusTags", 8))
+                        return parseVorbisComment(packet.data() + 8, packet.size() - 8, tags);
+                    
+                    return false;
+                }
+                
+                ++packetIndex;
+            }
+        }
+        
+        pos += 27 + numSegments + bodySize;
+    }
+    
+    return false;
+}
+
+bool TagReader::readRiff(Tags& tags)
+{
+    bool found = false;
+    juce::int64 pos = 12;
+    
+    for (int i = 0; i < maxChunks && pos + 8 <= fileSize; ++i)
+    {
+        auto header = read(pos, 8);
+        if (header.size < 8)
+            break;
+        
+        const juce::int64 chunkSize = readLE32(header.data + 4);
+        
+        if (matches(header.data, "LIST"))
+        {
+            auto list = read(pos + 8, juce::jmin(chunkSize, maxTagSize));
+            found |= parseRiffInfo(list.data, list.size, tags);
+        }
+        else if (matches(header.data, "id3 ") || matches(header.data, "ID3 "))
+        {
+            auto tag = read(pos + 8, juce::jmin(chunkSize, maxTagSize));
+            found |= parseId3v2(tag.data, tag.size, tags);
+        }
+        
+        // Chunks are padded to an even size
+        pos += 8 + chunkSize + (chunkSize & 1);
+    }
+    
+    return found;
+}
+
+bool TagReader::readAiff(Tags& tags)
+{
+    bool found = false;
+    juce::int64 pos = 12;
+    
+    for (int i = 0; i < maxChunks && pos + 8 <= fileSize; ++i)
+    {
+        auto header = read(pos, 8);
+        if (header.size < 8)
+            break;
+        
+        const juce::int64 chunkSize = readBE32(header.data + 4);
+        
+        if (matches(header.data, "ID3 ") || matches(header.data, "id3 "))
+        {
+            auto tag = read(pos + 8, juce::jmin(chunkSize, maxTagSize));
+            found |= parseId3v2(tag.data, tag.size, tags);
+        }
+        else if (matches(header.data, "NAME") || matches(header.data, "AUTH"))
+        {
+            auto text = read(pos + 8, juce::jmin(chunkSize, (juce::int64) 1024));
+            auto& field = matches(header.data, "NAME") ? tags.title : tags.artist;
+            found |= setIfEmpty(field, decodeLegacyText(text.data, text.size));
+        }
+        
+        pos += 8 + chunkSize + (chunkSize & 1);
+    }
+    
+    return found;
+}
+
+//==============================================================================
+bool TagReader::parseId3v2(const uint8_t* data, size_t size, Tags& tags)
+{
+    if (data == nullptr || size < 10 || !matches(data, "ID3", 3))
+        return false;
+    
+    const int version = data[3];
+    const uint8_t flags = data[5];
+    
+    if (version < 2 || version > 4)
+        return false;
+    
+    const size_t tagEnd = juce::jmin(size, (size_t) readSyncSafe32(data + 6) + 10);
+    const uint8_t* p = data + 10;
+    size_t length = tagEnd - 10;
+    
+    // Before 2.4, unsynchronisation applies to the whole tag
+    std::vector<uint8_t> resynchronised;
+    if ((flags & 0x80) != 0 && version < 4)
+    {
+        resynchronised = removeUnsynchronisation(p, length);
+        p = resynchronised.data();
+        length = resynchronised.size();
+    }
+    
+    size_t pos = 0;
+    
+    // Skip the extended header
+    if ((flags & 0x40) != 0 && version >= 3)
+    {
+        if (length < 4)
+            return false;
+        
+        pos = version == 4 ? readSyncSafe32(p) : readBE32(p) + 4;
+    }
+    
+    const size_t frameHeaderSize = version == 2 ? 6 : 10;
+    bool found = false;
+    
+    while (pos + frameHeaderSize <= length)
+    {
+        const uint8_t* frame = p + pos;
+        
+        // Padding
+        if (frame[0] == 0)
+            break;
+        
+        size_t frameSize = version == 2 ? readBE24(frame + 3)
+                         : version == 4 ? readSyncSafe32(frame + 4)
+                         : readBE32(frame + 4);
+        const uint32_t frameFlags = version == 2 ? 0 : readBE16(frame + 8);
+        
+        pos += frameHeaderSize;
+        
+        if (frameSize > length - pos)
+            break;
+        
+        const uint8_t* body = p + pos;
+        size_t bodySize = frameSize;
+        pos += frameSize;
+        
+        std::vector<uint8_t> frameResynchronised;
+        
+        if (version == 4)
+        {
+            if ((frameFlags & 0x000c) != 0)  // Compressed or encrypted
+                continue;
+            
+            if ((frameFlags & 0x0040) != 0 && bodySize >= 1)  // Group id byte
+            {
+                ++body;
+                --bodySize;
+            }
+            
+            if ((frameFlags & 0x0001) != 0 && bodySize >= 4)  // Data length indicator
+            {
+                body += 4;
+                bodySize -= 4;
+            }
+            
+            if ((frameFlags & 0x0002) != 0)
+            {
+                frameResynchronised = removeUnsynchronisation(body, bodySize);
+                body = frameResynchronised.data();
+                bodySize = frameResynchronised.size();
+            }
+        }
+        else if (version == 3)
+        {
+            if ((frameFlags & 0x00c0) != 0)  // Compressed or encrypted
+                continue;
+            
+            if ((frameFlags & 0x0020) != 0 && bodySize >= 1)  // Group id byte
+            {
+                ++body;
+                --bodySize;
+            }
+        }
+        
+        auto is = [frame, version](const char* id, const char* id22)
+        {
+            return version == 2 ? matches(frame, id22, 3) : matches(frame, id);
+        };
+        
+        if (is("TIT2", "TT2"))
+            found |= setIfEmpty(tags.title, decodeId3Text(body, bodySize));
+        else if (is("TPE1", "TP1"))
+            found |= setIfEmpty(tags.artist, decodeId3Text(body, bodySize));
+        else if (is("TALB", "TAL"))
+            found |= setIfEmpty(tags.album, decodeId3Text(body, bodySize));
+        else if (is("TCON", "TCO"))
+            found |= setIfEmpty(tags.genre, resolveId3Genre(decodeId3Text(body, bodySize)));
+        else if (is("TBPM", "TBP"))
+            found |= setBpmIfEmpty(tags.bpm, decodeId3Text(body, bodySize));
+        else if (is("TKEY", "TKE"))
+            found |= setIfEmpty(tags.key, decodeId3Text(body, bodySize));
+        else if (is("TXXX", "TXX"))
+        {
+            // User-defined text: description, then value
+            auto values = decodeId3TextValues(body, bodySize);
+            
+            if (values.size() >= 2)
+            {
+                auto name = values[0].toStdString();
+                found |= applyNamedField(toUpperASCII((const uint8_t*) name.data(), name.size()), values[1], tags);
+            }
+        }
+    }
+    
+    return found;
+}
+
+bool TagReader::parseId3v1(const uint8_t* data, size_t size, Tags& tags)
+{
+    if (data == nullptr || size < 128 || !matches(data, "TAG", 3))
+        return false;
+    
+    bool found = false;
+    found |= setIfEmpty(tags.title,  decodeLatin1(data + 3, 30));
+    found |= setIfEmpty(tags.artist, decodeLatin1(data + 33, 30));
+    found |= setIfEmpty(tags.album,  decodeLatin1(data + 63, 30));
+    found |= setIfEmpty(tags.genre,  getId3v1Genre(data[127]));
+    
+    return found;
+}
+
+bool TagReader::parseVorbisComment(const uint8_t* data, size_t size, Tags& tags)
+{
+    if (data == nullptr || size < 8)
+        return false;
+    
+    // Vendor string, then the number of comments; all lengths are little endian
+    size_t pos = 4 + (size_t) readLE32(data);
+    if (pos + 4 > size)
+        return false;
+    
+    const uint32_t numComments = readLE32(data + pos);
+    pos += 4;
+    
+    bool found = false;
+    
+    for (uint32_t i = 0; i < numComments && pos + 4 <= size; ++i)
+    {
+        const size_t commentSize = readLE32(data + pos);
+        pos += 4;
+        
+        if (commentSize > size - pos)
+            break;
+        
+        const uint8_t* comment = data + pos;
+        pos += commentSize;
+        
+        // NAME=value, where the name is case-insensitive ASCII
+        const auto* equals = static_cast<const uint8_t*>(std::memchr(comment, '=', commentSize));
+        if (equals == nullptr)
+            continue;
+        
+        const size_t nameSize = (size_t) (equals - comment);
+        found |= applyNamedField(toUpperASCII(comment, nameSize),
+                                 decodeUTF8(equals + 1, commentSize - nameSize - 1), tags);
+    }
+    
+    return found;
+}
+
+bool TagReader::parseMp4Moov(const uint8_t* data, size_t size, Tags& tags)
+{
+    if (data == nullptr)
+        return false;
+    
+    bool found = false;
+    
+    // iTunes puts the tags in moov/udta/meta/ilst; some writers use moov/meta/ilst
+    forEachAtom(data, size, [&](const uint8_t* type, const uint8_t* body, size_t bodySize)
+    {
+        if (matches(type, "meta"))
+        {
+            found |= parseMp4Meta(body, bodySize, tags);
+        }
+        else if (matches(type, "udta"))
+        {
+            forEachAtom(body, bodySize, [&](const uint8_t* childType, const uint8_t* child, size_t childSize)
+            {
+                if (matches(childType, "meta"))
+                    found |= parseMp4Meta(child, childSize, tags);
+            });
+        }
+    });
+    
+    return found;
+}
+
+bool TagReader::parseRiffInfo(const uint8_t* data, size_t size, Tags& tags)
+{
+    if (data == nullptr || size < 4 || !matches(data, "INFO"))
+        return false;
+    
+    bool found = false;
+    size_t pos = 4;
+    
+    while (pos + 8 <= size)
+    {
+        const uint8_t* id = data + pos;
+        const size_t textSize = juce::jmin((size_t) readLE32(data + pos + 4), size - pos - 8);
+        const uint8_t* text = data + pos + 8;
+        
+        if (matches(id, "INAM"))
+            found |= setIfEmpty(tags.title, decodeLegacyText(text, textSize));
+        else if (matches(id, "IART"))
+            found |= setIfEmpty(tags.artist, decodeLegacyText(text, textSize));
+        else if (matches(id, "IPRD"))
+            found |= setIfEmpty(tags.album, decodeLegacyText(text, textSize));
+        else if (matches(id, "IGNR"))
+            found |= setIfEmpty(tags.genre, decodeLegacyText(text, textSize));
+        
+        pos += 8 + textSize + (textSize & 1);
+    }
+    
+    return found;
+}
@@ -0,0 +1,158 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/**
+    TagReader reads embedded metadata (title, artist, album, genre, BPM and key)
+    straight from a file's tag structures, without creating a decoder:
+
+    - ID3v2.2 to 2.4 (MP3, and the id3 chunks of WAV/AIFF files) and ID3v1
+    - FLAC metadata blocks and Ogg Vorbis/Opus comment packets
+    - MP4/M4A ilst atoms, including iTunes freeform items
+    - RIFF INFO lists in WAV files, and NAME/AUTH chunks in AIFF files
+
+    Only the regions holding tags are memory-mapped: the start and end of the
+    file, plus the moov atom or chunk headers of MP4 and RIFF files. Only the
+    pages that are actually parsed are read from disk, so large embedded artwork
+    and the audio data itself cost nothing.
+*/
+class TagReader
+{
+public:
+    //==============================================================================
+    struct Tags
+    {
+        juce::String title;
+        juce::String artist;
+        juce::String album;
+        juce::String genre;
+        juce::String key;      // As tagged, e.g. "Am", "8A" or "A minor"
+        double bpm = 0.0;      // 0 if untagged
+        
+        bool isEmpty() const;
+    };
+    
+    //==============================================================================
+    TagReader();
+    ~TagReader();
+    
+    /**
+     * Read the tags of a file. When a file carries several tags (e.g. ID3v2 and
+     * ID3v1) the richer one wins and the other only fills in missing fields.
+     * @param audioFile The file to read
+     * @param outTags Receives the tags (cleared first)
+     * @return True if any tag field was found
+     */
+    bool readTags(const juce::File& audioFile, Tags& outTags);
+    
+    /**
+     * Find the byte range of a file that holds its audio, leaving out the tag
+     * structures: ID3v2, ID3v1 and APEv2 tags around MP3 and FLAC audio, FLAC
+     * metadata blocks, everything but the data/SSND chunk of WAV and AIFF files,
+     * and everything but the mdat atom of MP4 files. A hash of this range stays
+     * the same when a file is re-tagged.
+     * @param audioFile The file to inspect
+     * @param outRange Receives the audio range, or the whole file if tags cannot
+     *                 be separated from the audio (Ogg pages carry both)
+     * @return True if the tags were excluded, false if outRange is the whole file
+     */
+    bool findAudioPayload(const juce::File& audioFile, juce::Range<juce::int64>& outRange);
+    
+    /**
+     * Get the last error message.
+     */
+    juce::String getLastError() const { return lastError; }
+    
+    //==============================================================================
+    // Parsers for in-memory tag data. Each only fills fields that are still
+    // empty and returns true if it found at least one.
+    
+    /** A complete ID3v2 tag, starting with its "ID3" header. */
+    static bool parseId3v2(const uint8_t* data, size_t size, Tags& tags);
+    
+    /** The last 128 bytes of a file, starting with "TAG". */
+    static bool parseId3v1(const uint8_t* data, size_t size, Tags& tags);
+    
+    /** A Vorbis comment block (vendor string, then the comment list), as used by FLAC, Vorbis and Opus. */
+    static bool parseVorbisComment(const uint8_t* data, size_t size, Tags& tags);
+    
+    /** The payload of an MP4 moov atom (its child atoms). */
+    static bool parseMp4Moov(const uint8_t* data, size_t size, Tags& tags);
+    
+    /** The payload of a RIFF LIST chunk of type INFO (starting with "INFO"). */
+    static bool parseRiffInfo(const uint8_t* data, size_t size, Tags& tags);
+    
+    /**
+     * Look up an ID3v1 genre number (including the Winamp extensions).
+     * @return The genre name, or an empty string if the number is unknown
+     */
+    static juce::String getId3v1Genre(int genreNumber);
+
+private:
+    //==============================================================================
+    // A view of part of the file, either inside the mapped head region, in its
+    // own mapping, or (if mapping fails) copied into memory
+    struct Bytes
+    {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        std::unique_ptr<juce::MemoryMappedFile> mapping;
+        std::vector<uint8_t> copy;
+    };
+    
+    Bytes read(juce::int64 offset, juce::int64 length);
+    
+    // Payload of the first chunk with the given id in a RIFF or AIFF file, or of
+    // the first top-level atom in an MP4 file
+    bool findChunk(const char* id, bool bigEndian, juce::Range<juce::int64>& outRange);
+    bool findMp4Atom(const char* id, juce::Range<juce::int64>& outRange);
+    
+    bool readMp4(Tags& tags);
+    bool readFlac(juce::int64 offset, Tags& tags);
+    bool readOgg(Tags& tags);
+    bool readRiff(Tags& tags);
+    bool readAiff(Tags& tags);
+    
+    juce::File file;
+    juce::int64 fileSize = 0;
+    std::unique_ptr<juce::MemoryMappedFile> headMapping;
+    const uint8_t* headData = nullptr;
+    juce::int64 headSize = 0;
+    juce::String lastError;
+    
+    // The start of the file is mapped once; most tags live entirely inside it
+    static constexpr juce::int64 headRegionSize = 256 * 1024;
+    
+    // Upper bounds that keep corrupt size fields from mapping absurd ranges
+    static constexpr juce::int64 maxTagSize = 64 * 1024 * 1024;
+    static constexpr int maxChunks = 1024;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TagReader)
+};
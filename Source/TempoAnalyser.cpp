@@ -0,0 +1,363 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+
+#include "TempoAnalyser.h"
+#include <cmath>
+
+//==============================================================================
+TempoAnalyser::TempoAnalyser()
+    : fft(fftOrder),
+      window((size_t) fftSize),
+      frame((size_t) fftSize),
+      fftBuffer((size_t) fftSize * 2),
+      magnitudes((size_t) numBins),
+      previousMagnitudes((size_t) numBins)
+{
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), (size_t) fftSize,
+                                                             juce::dsp::WindowingFunction<float>::hann, false);
+}
+
+TempoAnalyser::~TempoAnalyser()
+{
+}
+
+//==============================================================================
+bool TempoAnalyser::prepare(const juce::AudioFormatReader& reader)
+{
+    bpm = 0.0;
+    confidence = 0.0;
+    envelope.clear();
+    leadingEnvelope.clear();
+    leadingFrames = -1;
+    
+    if (reader.sampleRate <= 0 || reader.lengthInSamples <= 0 || reader.numChannels == 0)
+        return false;
+    
+    // Decimate by an integer factor to land at (or just above) the analysis rate
+    decimation = juce::jmax(1, static_cast<int>(reader.sampleRate / targetSampleRate));
+    frameRate = reader.sampleRate / decimation / hopSize;
+    
+    // Each envelope value compares a frame with the one a hop before it (the first
+    // value, the second frame with the first). A transient raises the flux most while
+    // it crosses three quarters into the frames, where the window is steepest.
+    firstFrameTime = (hopSize + fftSize * 3 / 4 - hopSize / 2) * decimation / reader.sampleRate;
+    
+    samplesWanted = juce::jmin(reader.lengthInSamples, (juce::int64) (maxAnalysisSeconds * reader.sampleRate));
+    samplesSeen = 0;
+    minWindowLength = (juce::int64) (minWindowSeconds * reader.sampleRate);
+    nextSample = 0;
+    skippingWindow = false;
+    
+    decimatorSum = 0.0;
+    decimatorCount = 0;
+    frameFill = 0;
+    hasPreviousFrame = false;
+    
+    envelope.reserve((size_t) (samplesWanted / decimation / hopSize) + 1);
+    return true;
+}
+
+void TempoAnalyser::beginWindow(juce::int64 startSample, juce::int64 numSamples)
+{
+    if (startSample == nextSample)
+        return;
+    
+    // Start afresh after a gap, without a flux spike from comparing unrelated frames
+    if (leadingFrames < 0)
+        leadingFrames = (int) envelope.size();
+    
+    skippingWindow = numSamples < minWindowLength;
+    decimatorSum = 0.0;
+    decimatorCount = 0;
+    frameFill = 0;
+    hasPreviousFrame = false;
+}
+
+void TempoAnalyser::processBlock(const juce::AudioBuffer<float>& block, int numSamples, juce::int64 startSample)
+{
+    if (skippingWindow)
+        return;
+    
+    nextSample = startSample + numSamples;
+    
+    const int samplesToUse = static_cast<int>(juce::jmin((juce::int64) numSamples, samplesWanted - samplesSeen));
+    
+    if (samplesToUse <= 0)
+        return;
+    
+    samplesSeen += samplesToUse;
+    
+    // Downmix to mono
+    const int numChannels = block.getNumChannels();
+    const float gain = 1.0f / (float) numChannels;
+    
+    if ((int) mono.size() < samplesToUse)
+        mono.resize((size_t) samplesToUse);
+    
+    juce::FloatVectorOperations::copyWithMultiply(mono.data(), block.getReadPointer(0), gain, samplesToUse);
+    
+    for (int channel = 1; channel < numChannels; ++channel)
+        juce::FloatVectorOperations::addWithMultiply(mono.data(), block.getReadPointer(channel), gain, samplesToUse);
+    
+    // Average groups of `decimation` samples (a box low-pass), then frame every hopSize outputs
+    for (int i = 0; i < samplesToUse; ++i)
+    {
+        decimatorSum += mono[(size_t) i];
+        
+        if (++decimatorCount < decimation)
+            continue;
+        
+        frame[(size_t) frameFill++] = static_cast<float>(decimatorSum / decimation);
+        decimatorSum = 0.0;
+        decimatorCount = 0;
+        
+        if (frameFill == fftSize)
+        {
+            processFrame();
+            
+            std::copy(frame.begin() + hopSize, frame.end(), frame.begin());
+            frameFill = fftSize - hopSize;
+        }
+    }
+}
+
+void TempoAnalyser::processFrame()
+{
+    juce::FloatVectorOperations::multiply(fftBuffer.data(), frame.data(), window.data(), fftSize);
+    juce::FloatVectorOperations::clear(fftBuffer.data() + fftSize, fftSize);
+    
+    fft.performFrequencyOnlyForwardTransform(fftBuffer.data(), true);
+    
+    // Log compression makes quiet onsets count as much as loud ones
+    const float compression = 1000.0f / (float) fftSize;
+    
+    for (int bin = 0; bin < numBins; ++bin)
+        magnitudes[(size_t) bin] = std::log1p(compression * fftBuffer[(size_t) bin]);
+    
+    if (hasPreviousFrame)
+    {
+        // Spectral flux: the summed energy increase across all bins
+        float* difference = fftBuffer.data();
+        juce::FloatVectorOperations::subtract(difference, magnitudes.data(), previousMagnitudes.data(), numBins);
+        juce::FloatVectorOperations::max(difference, difference, 0.0f, numBins);
+        
+        float flux = 0.0f;
+        for (int bin = 0; bin < numBins; ++bin)
+            flux += difference[bin];
+        
+        envelope.push_back(flux);
+    }
+    
+    std::swap(magnitudes, previousMagnitudes);
+    hasPreviousFrame = true;
+}
+
+bool TempoAnalyser::wantsMoreAudio() const
+{
+    return samplesSeen < samplesWanted;
+}
+
+bool TempoAnalyser::isConfident()
+{
+    // More audio cannot help once the analysis limit is reached
+    if (!wantsMoreAudio())
+        return true;
+    
+    double estimatedBpm = 0.0, estimatedConfidence = 0.0;
+    return estimateTempo(envelope, frameRate, estimatedBpm, estimatedConfidence)
+        && estimatedConfidence >= confidentAbove;
+}
+
+bool TempoAnalyser::finish()
+{
+    leadingEnvelope.assign(envelope.begin(), envelope.begin() + (leadingFrames < 0 ? (int) envelope.size() : leadingFrames));
+    
+    if (!estimateTempo(envelope, frameRate, bpm, confidence) || confidence < minConfidence)
+    {
+        bpm = 0.0;
+        confidence = 0.0;
+        return false;
+    }
+    
+    DBG("[TempoAnalyser] " << juce::String(bpm, 2) << " BPM (confidence " << juce::String(confidence, 2)
+        << ") from " << (int) envelope.size() << " onset frames");
+    
+    return true;
+}
+
+//==============================================================================
+bool TempoAnalyser::estimateTempo(const std::vector<float>& onsets, double rate,
+                                  double& outBpm, double& outConfidence)
+{
+    constexpr int numMultiples = 4;
+    
+    const int n = (int) onsets.size();
+    const double longestPeriod = rate * 60.0 / minBpm;
+    const int maxLag = static_cast<int>(std::ceil(longestPeriod * numMultiples)) + 1;
+    
+    if (rate <= 0.0 || n < maxLag * 2)
+        return false;
+    
+    // Remove the slowly varying level (about a second) so only the pulse remains
+    const int smoothing = juce::jmax(1, juce::roundToInt(rate));
+    std::vector<double> cumulative((size_t) n + 1, 0.0);
+    
+    for (int i = 0; i < n; ++i)
+        cumulative[(size_t) i + 1] = cumulative[(size_t) i] + onsets[(size_t) i];
+    
+    std::vector<float> pulse((size_t) n);
+    double mean = 0.0;
+    
+    for (int i = 0; i < n; ++i)
+    {
+        const int start = juce::jmax(0, i - smoothing / 2);
+        const int end = juce::jmin(n, i + smoothing / 2 + 1);
+        const double localMean = (cumulative[(size_t) end] - cumulative[(size_t) start]) / (end - start);
+        
+        pulse[(size_t) i] = (float) juce::jmax(0.0, onsets[(size_t) i] - localMean);
+        mean += pulse[(size_t) i];
+    }
+    
+    juce::FloatVectorOperations::add(pulse.data(), (float) (-mean / n), n);
+    
+    auto correlate = [&pulse, n](int lag)
+    {
+        const float* a = pulse.data();
+        const float* b = pulse.data() + lag;
+        const int count = n - lag;
+        
+        float sum = 0.0f;
+        for (int i = 0; i < count; ++i)
+            sum += a[i] * b[i];
+        
+        return (double) sum / count;
+    };
+    
+    // Normalised autocorrelation up to the longest lag the comb can reach
+    std::vector<double> autocorrelation((size_t) maxLag + 1);
+    
+    for (int lag = 0; lag <= maxLag; ++lag)
+        autocorrelation[(size_t) lag] = correlate(lag);
+    
+    const double energy = autocorrelation[0];
+    
+    if (energy <= 0.0)
+        return false;
+    
+    for (auto& value : autocorrelation)
+        value /= energy;
+    
+    auto autocorrelationAt = [&autocorrelation](double lag)
+    {
+        const int index = static_cast<int>(lag);
+        const double fraction = lag - index;
+        return autocorrelation[(size_t) index] * (1.0 - fraction) + autocorrelation[(size_t) index + 1] * fraction;
+    };
+    
+    // Average correlation at one to four beat periods
+    auto combScore = [&](double candidateBpm)
+    {
+        const double period = rate * 60.0 / candidateBpm;
+        double score = 0.0;
+        
+        for (int multiple = 1; multiple <= numMultiples; ++multiple)
+            score += autocorrelationAt(period * multiple);
+        
+        return score / numMultiples;
+    };
+    
+    // Halving or doubling a tempo fits the pulse almost as well, so prefer the
+    // octave nearest to typical dance tempos (hip-hop at 90 stays 90, drum and bass at 174 stays 174)
+    auto tempoPrior = [](double candidateBpm)
+    {
+        constexpr double preferredBpm = 125.0;
+        constexpr double widthInOctaves = 1.0;
+        const double octaves = std::log2(candidateBpm / preferredBpm) / widthInOctaves;
+        return std::exp(-0.5 * octaves * octaves);
+    };
+    
+    constexpr double step = 0.01;
+    const int numCandidates = static_cast<int>((maxBpm - minBpm) / step) + 1;
+    std::vector<double> weighted((size_t) numCandidates);
+    int best = 0;
+    
+    for (int i = 0; i < numCandidates; ++i)
+    {
+        const double candidateBpm = minBpm + i * step;
+        weighted[(size_t) i] = combScore(candidateBpm) * tempoPrior(candidateBpm);
+        
+        if (weighted[(size_t) i] > weighted[(size_t) best])
+            best = i;
+    }
+    
+    if (weighted[(size_t) best] <= 0.0)
+        return false;
+    
+    // Parabolic interpolation between grid points
+    double offset = 0.0;
+    
+    if (best > 0 && best < numCandidates - 1)
+    {
+        const double left = weighted[(size_t) best - 1];
+        const double centre = weighted[(size_t) best];
+        const double right = weighted[(size_t) best + 1];
+        const double denominator = left - 2.0 * centre + right;
+        
+        if (denominator < 0.0)
+            offset = 0.5 * (left - right) / denominator;
+    }
+    
+    const double coarseBpm = minBpm + (best + offset) * step;
+    outConfidence = juce::jlimit(0.0, 1.0, combScore(coarseBpm));
+    
+    // The comb only sees a few beats, which limits precision to a few tenths of
+    // a BPM. Follow the correlation peak out to ever larger beat multiples: each
+    // doubling halves the error of the period estimate.
+    double period = rate * 60.0 / coarseBpm;
+    
+    for (int multiple = numMultiples * 2; period * multiple + 2.0 < n / 2; multiple *= 2)
+    {
+        const int centre = juce::roundToInt(period * multiple);
+        double values[5];
+        int peak = 2;
+        
+        for (int i = 0; i < 5; ++i)
+        {
+            values[i] = correlate(centre + i - 2);
+            if (values[i] > values[peak])
+                peak = i;
+        }
+        
+        // A peak at the edge of the window means the pulse drifted; keep what we have
+        if (peak == 0 || peak == 4)
+            break;
+        
+        const double denominator = values[peak - 1] - 2.0 * values[peak] + values[peak + 1];
+        const double peakOffset = denominator < 0.0 ? 0.5 * (values[peak - 1] - values[peak + 1]) / denominator : 0.0;
+        
+        period = (centre + peak - 2 + peakOffset) / multiple;
+    }
+    
+    outBpm = rate * 60.0 / period;
+    return true;
+}
@@ -0,0 +1,142 @@
+/*
+  ==============================================================================
+
+    uniQuE-ui Library Manager
+    Copyright (C) 2025 uniQuE-ui
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  ==============================================================================
+*/
+
+
+#pragma once
+
+#include "AnalysisPipeline.h"
+#include <juce_dsp/juce_dsp.h>
+#include <vector>
+
+//==============================================================================
+/**
+    Estimates a track's tempo while it streams through the AnalysisPipeline.
+
+    The audio is downmixed and decimated to roughly 11 kHz, then a spectral-flux
+    onset envelope is built from short FFT frames (log-compressed magnitudes,
+    positive differences only). The envelope's autocorrelation is scored with a
+    comb over the first four beat multiples on a fine BPM grid, weighted towards
+    typical dance tempos to settle octave ambiguities, which yields a fractional
+    BPM and a 0-1 confidence.
+
+    At the analysis rate one FFT of 1024 points covers every 128 input samples,
+    so the cost is a small fraction of decoding.
+*/
+class TempoAnalyser : public AnalysisConsumer
+{
+public:
+    //==============================================================================
+    TempoAnalyser();
+    ~TempoAnalyser() override;
+    
+    bool prepare(const juce::AudioFormatReader& reader) override;
+    void beginWindow(juce::int64 startSample, juce::int64 numSamples) override;
+    void processBlock(const juce::AudioBuffer<float>& block, int numSamples, juce::int64 startSample) override;
+    bool wantsMoreAudio() const override;
+    bool isConfident() override;
+    bool finish() override;
+    
+    /** The tempo of the last file in BPM, or 0 if none was found or it was too uncertain. */
+    double getBpm() const         { return bpm; }
+    
+    /** How clearly the tempo stood out, from 0 (no pulse) to 1 (metronome). */
+    double getConfidence() const  { return confidence; }
+    
+    /**
+     * The onset envelope of the last file, one value per analysis frame, from the
+     * start of the file up to the first skipped part (for beat tracking).
+     */
+    const std::vector<float>& getOnsetEnvelope() const  { return leadingEnvelope; }
+    
+    /** Onset envelope frames per second. */
+    double getFrameRate() const                         { return frameRate; }
+    
+    /** The time in seconds that the first onset envelope frame stands for. */
+    double getFirstFrameTime() const                    { return firstFrameTime; }
+    
+    /**
+     * Estimate a tempo from an onset envelope.
+     * @param envelope Onset strength per frame
+     * @param frameRate Envelope frames per second
+     * @param outBpm Receives the tempo in BPM
+     * @param outConfidence Receives the confidence (0-1)
+     * @return False if the envelope is too short or has no periodicity
+     */
+    static bool estimateTempo(const std::vector<float>& envelope, double frameRate,
+                              double& outBpm, double& outConfidence);
+    
+    static constexpr double minBpm = 60.0;
+    static constexpr double maxBpm = 200.0;
+    
+    // Below this the "tempo" is most likely noise (speech, ambient), so none is reported
+    static constexpr double minConfidence = 0.1;
+    
+    // Only this much audio is analysed; tempo rarely changes after that
+    static constexpr double maxAnalysisSeconds = 300.0;
+    
+    // A sampled file is decoded further while the confidence is below this
+    static constexpr double confidentAbove = 0.3;
+    
+    // Windows shorter than this (slivers left between sections) hold too few frames to help
+    static constexpr double minWindowSeconds = 5.0;
+
+private:
+    //==============================================================================
+    void processFrame();
+    
+    static constexpr double targetSampleRate = 11025.0;
+    static constexpr int fftOrder = 10;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numBins = fftSize / 2 + 1;
+    static constexpr int hopSize = 128;
+    
+    juce::dsp::FFT fft;
+    std::vector<float> window;
+    
+    int decimation = 1;
+    double frameRate = 0.0;
+    double firstFrameTime = 0.0;
+    juce::int64 samplesWanted = 0;
+    juce::int64 samplesSeen = 0;
+    juce::int64 minWindowLength = 0;
+    juce::int64 nextSample = 0;        // Where the last block ended
+    bool skippingWindow = false;
+    
+    std::vector<float> mono;           // Downmixed input block
+    double decimatorSum = 0.0;         // Partial average of the next decimated sample
+    int decimatorCount = 0;
+    
+    std::vector<float> frame;          // The last fftSize decimated samples
+    int frameFill = 0;
+    
+    std::vector<float> fftBuffer;
+    std::vector<float> magnitudes, previousMagnitudes;
+    bool hasPreviousFrame = false;
+    
+    std::vector<float> envelope;
+    int leadingFrames = -1;            // Frames before the first gap, -1 while there is none
+    std::vector<float> leadingEnvelope;
+    double bpm = 0.0;
+    double confidence = 0.0;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TempoAnalyser)
+};
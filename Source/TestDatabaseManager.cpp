@@ -130,10 +130,14 @@ int main()
     job.dateCreated = juce::Time::getCurrentTime();
     job.progress = 0;
     
+    int jobAvailableSignals = 0;
+    dbManager.setJobAvailableCallback([&jobAvailableSignals](int) { ++jobAvailableSignals; });
+    
     int64_t jobId = 0;
     assert(dbManager.addJob(job, jobId));
     assert(jobId > 0);
-    std::cout << "✓ Job added with ID: " << jobId << std::endl;
+    assert(jobAvailableSignals == 1);
+    std::cout << "✓ Job added with ID: " << jobId << " (workers signalled)" << std::endl;
     
     // Test 9: Update job
     std::cout << "\nTest 9: Update job..." << std::endl;
@@ -145,6 +149,8 @@ int main()
     auto updatedJob = dbManager.getJob(jobId);
     assert(updatedJob.status == "running");
     assert(updatedJob.progress == 50);
+    assert(jobAvailableSignals == 1);  // Claiming work must not wake other workers
+    dbManager.setJobAvailableCallback(nullptr);
     std::cout << "✓ Job updated successfully" << std::endl;
     
     // Test 10: Search tracks
@@ -173,6 +179,55 @@ int main()
     assert(allTracks.size() == 2);
     std::cout << "✓ Transaction committed successfully, total tracks: " << allTracks.size() << std::endl;
     
+    // Test 12: Waveform overview round trip
+    std::cout << "\nTest 12: Waveform overview..." << std::endl;
+    DatabaseManager::WaveformOverview overview;
+    overview.trackId = trackId;
+    overview.duration = 240.0;
+    overview.minMax = { -127, 127, -64, 32, 0, 0 };
+    assert(dbManager.saveWaveformOverview(overview));
+    
+    DatabaseManager::WaveformOverview storedOverview;
+    assert(dbManager.getWaveformOverview(trackId, storedOverview));
+    assert(storedOverview.getNumBins() == 3);
+    assert(storedOverview.minMax == overview.minMax);
+    assert(!dbManager.getWaveformOverview(trackId2, storedOverview));
+    std::cout << "✓ Waveform overview stored with " << storedOverview.getNumBins() << " bins" << std::endl;
+    
+    // Test 13: Priority scheduling
+    std::cout << "\nTest 13: Priority scheduling..." << std::endl;
+    auto makeAnalysisJob = [](const juce::String& path, int priority)
+    {
+        DatabaseManager::Job analysisJob;
+        analysisJob.jobType = "analyze_audio";
+        analysisJob.status = "pending";
+        analysisJob.filePath = path;
+        analysisJob.parameters = "{}";
+        analysisJob.dateCreated = juce::Time::getCurrentTime();
+        analysisJob.priority = priority;
+        return analysisJob;
+    };
+    
+    int64_t backgroundA = 0, backgroundB = 0, interactiveC = 0;
+    assert(dbManager.enqueueJob(makeAnalysisJob("/music/a.mp3", DatabaseManager::jobPriorityBackground), backgroundA));
+    assert(dbManager.enqueueJob(makeAnalysisJob("/music/b.mp3", DatabaseManager::jobPriorityBackground), backgroundB));
+    assert(dbManager.enqueueJob(makeAnalysisJob("/music/c.mp3", DatabaseManager::jobPriorityInteractive), interactiveC));
+    
+    DatabaseManager::Job claimed;
+    assert(dbManager.claimNextJob(claimed) && claimed.id == interactiveC);
+    
+    // Re-enqueueing a queued file at a higher priority bumps the existing job
+    int64_t requeuedId = 0;
+    assert(dbManager.enqueueJob(makeAnalysisJob("/music/b.mp3", DatabaseManager::jobPriorityPlaylist), requeuedId));
+    assert(requeuedId == 0);
+    assert(dbManager.getJob(backgroundB).priority == DatabaseManager::jobPriorityPlaylist);
+    assert(!dbManager.bumpJobPriority("/music/b.mp3", DatabaseManager::jobPriorityBackground));  // Never lowers
+    
+    assert(dbManager.claimNextJob(claimed) && claimed.id == backgroundB);
+    assert(dbManager.claimNextJob(claimed) && claimed.id == backgroundA);
+    assert(!dbManager.claimNextJob(claimed));
+    std::cout << "✓ Interactive and bumped jobs were claimed before background work" << std::endl;
+    
     // Cleanup
     std::cout << "\nCleaning up..." << std::endl;
     dbManager.close();
@@ -13,7 +13,22 @@
 #include "../Source/DatabaseManager.h"
 #include "../Source/FileScanner.h"
 #include "../Source/AnalysisWorker.h"
+#include "../Source/AnalysisPolicy.h"
+#include "../Source/CancellationToken.h"
+#include "../Source/ResourceGovernor.h"
+#include "../Source/AnalysisStats.h"
+#include "../Source/BeatGridAnalyser.h"
+#include "../Source/FileHasher.h"
+#include "../Source/TagReader.h"
+#include "../Source/TempoAnalyser.h"
+#include "../Source/KeyAnalyser.h"
+#include "../Source/LoudnessAnalyser.h"
+#include "../Source/MappedAudioReader.h"
+#include "../Source/FingerprintResampler.h"
+#include "../Source/SpectralFingerprinter.h"
+#include "../Source/FingerprintIndex.h"
 #include <iostream>
+#include <cmath>
 
 int main()
 {
@@ -77,6 +92,47 @@ int main()
         return 1;
     }
     
+    // Rescanning the same folder must not queue the same files again
+    std::cout << "\nTest 3b: Rescan does not duplicate pending jobs..." << std::endl;
+    int filesRequeued = scanner.scanDirectory(testDir, true);
+    auto pendingAfterRescan = dbManager.getJobsByStatus("pending");
+    
+    if (filesRequeued != 0 || pendingAfterRescan.size() != pendingJobs.size())
+    {
+        std::cerr << "Error: Rescan created duplicate jobs!" << std::endl;
+        return 1;
+    }
+    std::cout << "✓ Rescan queued " << filesRequeued << " new jobs" << std::endl;
+    
+    // Moving a library track must relink it rather than queue a new analysis job
+    std::cout << "\nTest 3c: Moved file is relinked..." << std::endl;
+    juce::File originalFile = testDir.getChildFile("moved_track.wav");
+    originalFile.replaceWithText("not really audio, but unique content");
+    
+    DatabaseManager::Track movedTrack;
+    movedTrack.filePath = originalFile.getFullPathName();
+    movedTrack.title = "Moved Track";
+    movedTrack.fileSize = originalFile.getSize();
+    movedTrack.fileIdentity = FileHasher::getFileIdentity(originalFile);
+    movedTrack.dateAdded = juce::Time::getCurrentTime();
+    movedTrack.lastModified = juce::Time::getCurrentTime();
+    
+    int64_t movedTrackId = 0;
+    dbManager.addTrack(movedTrack, movedTrackId);
+    
+    juce::File movedFile = testDir.getChildFile("subfolder/renamed_track.wav");
+    originalFile.moveFileTo(movedFile);
+    
+    int queuedAfterMove = scanner.scanDirectory(testDir, true);
+    auto relinkedTrack = dbManager.getTrack(movedTrackId);
+    
+    if (queuedAfterMove != 0 || relinkedTrack.filePath != movedFile.getFullPathName())
+    {
+        std::cerr << "Error: Moved track was not relinked!" << std::endl;
+        return 1;
+    }
+    std::cout << "✓ Track relinked to " << relinkedTrack.filePath << std::endl;
+    
     // Test AnalysisWorker (without actually processing since we don't have real audio files)
     std::cout << "\nTest 4: AnalysisWorker initialization..." << std::endl;
     AnalysisWorker worker(dbManager);
@@ -89,11 +145,642 @@ int main()
     std::cout << "✓ AnalysisWorker created" << std::endl;
     std::cout << "  Pending jobs: " << worker.getPendingJobCount() << std::endl;
     
+    // Test batched result writes
+    std::cout << "\nTest 4b: Batched result writes..." << std::endl;
+    AnalysisResultWriter writer(dbManager);
+    int savedResults = 0;
+    writer.setResultCallback([&savedResults](const AnalysisResultWriter::Result&, bool saved) {
+        if (saved)
+            ++savedResults;
+    });
+    
+    DatabaseManager::Job claimedJob;
+    if (!dbManager.claimNextJob(claimedJob))
+    {
+        std::cerr << "Error: No pending job to claim!" << std::endl;
+        return 1;
+    }
+    
+    AnalysisResultWriter::Result result;
+    result.job = claimedJob;
+    result.job.status = "completed";
+    result.job.progress = 100;
+    result.hasTrack = true;
+    result.track.filePath = claimedJob.filePath;
+    result.track.title = "Batched Track";
+    result.track.dateAdded = juce::Time::getCurrentTime();
+    result.track.lastModified = juce::Time::getCurrentTime();
+    writer.submit(result);
+    
+    if (writer.getQueuedResultCount() != 1 || !writer.flush() || savedResults != 1
+        || dbManager.getJob(claimedJob.id).status != "completed"
+        || dbManager.getTrackByPath(claimedJob.filePath).title != "Batched Track")
+    {
+        std::cerr << "Error: Batched result was not written!" << std::endl;
+        return 1;
+    }
+    std::cout << "✓ Result committed with its job by the writer" << std::endl;
+    
+    // A run that crashes leaves its job running; once the lease expires it is retried, then given up on
+    std::cout << "\nTest 4c: Expired job leases are recovered..." << std::endl;
+    DatabaseManager::Job leasedJob;
+    int requeued = 0, abandoned = 0;
+    
+    if (!dbManager.claimNextJob(leasedJob, "crashed-run", -1) || dbManager.renewJobLeases("other-run") != 0
+        || !dbManager.recoverExpiredJobs(2, requeued, abandoned) || requeued != 1 || abandoned != 0
+        || dbManager.getJob(leasedJob.id).status != "pending")
+    {
+        std::cerr << "Error: Expired job was not requeued!" << std::endl;
+        return 1;
+    }
+    
+    DatabaseManager::Job retriedJob;
+    if (!dbManager.claimNextJob(retriedJob, "crashed-run", -1) || retriedJob.id != leasedJob.id || retriedJob.attempts != 2
+        || !dbManager.recoverExpiredJobs(2, requeued, abandoned) || requeued != 0 || abandoned != 1
+        || dbManager.getJob(leasedJob.id).status != "failed")
+    {
+        std::cerr << "Error: Job was not failed after its last attempt!" << std::endl;
+        return 1;
+    }
+    std::cout << "✓ Job requeued once, then failed after " << retriedJob.attempts << " attempts" << std::endl;
+    
+    // A preempted job goes back untouched, and the thread that gave it up claims the urgent one
+    std::cout << "\nTest 4d: Preempted jobs are released..." << std::endl;
+    CancellationToken token;
+    token.cancel(CancellationToken::Reason::preempted);
+    token.cancel(CancellationToken::Reason::shutdown);
+    const auto firstReason = token.getReason();
+    token.reset();
+    
+    if (firstReason != CancellationToken::Reason::preempted || token.isCancelled())
+    {
+        std::cerr << "Error: Cancellation token kept the wrong reason!" << std::endl;
+        return 1;
+    }
+    
+    DatabaseManager::Job preemptedJob, urgentJob;
+    
+    if (!dbManager.claimNextJob(preemptedJob, "live-run") || !dbManager.releaseJob(preemptedJob.id)
+        || dbManager.getJob(preemptedJob.id).status != "pending" || dbManager.getJob(preemptedJob.id).attempts != 0
+        || dbManager.claimNextJob(urgentJob, "live-run", DatabaseManager::defaultLeaseSeconds,
+                                  DatabaseManager::jobPriorityInteractive))
+    {
+        std::cerr << "Error: Released job was not requeued as unclaimed!" << std::endl;
+        return 1;
+    }
+    
+    if (!dbManager.bumpJobPriority(preemptedJob.filePath, DatabaseManager::jobPriorityInteractive)
+        || !dbManager.claimNextJob(urgentJob, "live-run", DatabaseManager::defaultLeaseSeconds,
+                                   DatabaseManager::jobPriorityInteractive)
+        || urgentJob.id != preemptedJob.id || !dbManager.releaseJob(urgentJob.id))
+    {
+        std::cerr << "Error: Urgent claim did not take the raised job!" << std::endl;
+        return 1;
+    }
+    std::cout << "✓ Job released without using an attempt, urgent claim took it first" << std::endl;
+    
     // Test duplicate detection query
     std::cout << "\nTest 5: Duplicate detection query..." << std::endl;
     auto duplicates = dbManager.findTracksByFingerprint("test_fingerprint_123");
     std::cout << "✓ Duplicate query works (found " << duplicates.size() << " tracks)" << std::endl;
     
+    // Test content hashing
+    std::cout << "\nTest 6: File content hashing..." << std::endl;
+    juce::File hashFileA = testDir.getChildFile("hash_a.bin");
+    juce::File hashFileB = testDir.getChildFile("hash_b.bin");
+    juce::String content = juce::String::repeatedString("0123456789abcdef", 20000);
+    hashFileA.replaceWithText(content);
+    hashFileB.replaceWithText(content + "x");
+    
+    FileHasher hasher;
+    juce::String hashA1, hashA2, hashB, partialA;
+    
+    if (!hasher.hashFile(hashFileA, hashA1) || !hasher.hashFile(hashFileA, hashA2)
+        || !hasher.hashFile(hashFileB, hashB) || !hasher.hashFilePartial(hashFileA, partialA))
+    {
+        std::cerr << "Error: Hashing failed: " << hasher.getLastError() << std::endl;
+        return 1;
+    }
+    
+    if (hashA1 != hashA2 || hashA1 == hashB || partialA == hashA1
+        || !hashA1.startsWith(FileHasher::getAlgorithmName() + ":"))
+    {
+        std::cerr << "Error: Unexpected hash results!" << std::endl;
+        return 1;
+    }
+    std::cout << "✓ Hash: " << hashA1 << std::endl;
+    
+    // Test tag parsing without a decoder
+    std::cout << "\nTest 7: Tag parsing..." << std::endl;
+    std::vector<uint8_t> id3;
+    
+    auto addId3Frame = [&id3](const char* id, std::vector<uint8_t> body)
+    {
+        const auto size = (uint32_t) body.size();
+        id3.insert(id3.end(), id, id + 4);
+        id3.insert(id3.end(), { (uint8_t) (size >> 24), (uint8_t) (size >> 16), (uint8_t) (size >> 8), (uint8_t) size, 0, 0 });
+        id3.insert(id3.end(), body.begin(), body.end());
+    };
+    
+    addId3Frame("TIT2", { 0, 'I', 'n', 't', 'r', 'o' });
+    addId3Frame("TPE1", { 1, 0xff, 0xfe, 'D', 0, 'J', 0 });  // UTF-16 with BOM
+    addId3Frame("TCON", { 0, '(', '1', '8', ')' });
+    addId3Frame("TBPM", { 0, '1', '2', '8' });
+    addId3Frame("TKEY", { 0, 'A', 'm' });
+    
+    const auto frameBytes = (uint32_t) id3.size();
+    id3.insert(id3.begin(), { 'I', 'D', '3', 3, 0, 0,
+                              (uint8_t) ((frameBytes >> 21) & 0x7f), (uint8_t) ((frameBytes >> 14) & 0x7f),
+                              (uint8_t) ((frameBytes >> 7) & 0x7f), (uint8_t) (frameBytes & 0x7f) });
+    
+    TagReader::Tags tags;
+    if (!TagReader::parseId3v2(id3.data(), id3.size(), tags)
+        || tags.title != "Intro" || tags.artist != "DJ" || tags.genre != "Techno"
+        || tags.key != "Am" || tags.bpm != 128.0)
+    {
+        std::cerr << "Error: ID3v2 tag not parsed correctly!" << std::endl;
+        return 1;
+    }
+    
+    // A Vorbis comment only fills the fields the ID3 tag left empty
+    const std::string comment = "album=Night Drive";
+    std::vector<uint8_t> vorbis = { 0, 0, 0, 0, 1, 0, 0, 0, (uint8_t) comment.size(), 0, 0, 0 };
+    vorbis.insert(vorbis.end(), comment.begin(), comment.end());
+    
+    if (!TagReader::parseVorbisComment(vorbis.data(), vorbis.size(), tags)
+        || tags.album != "Night Drive" || tags.title != "Intro")
+    {
+        std::cerr << "Error: Vorbis comment not parsed correctly!" << std::endl;
+        return 1;
+    }
+    
+    juce::File taggedFile = testDir.getChildFile("tagged.mp3");
+    std::vector<uint8_t> fileBytes = id3;
+    fileBytes.resize(fileBytes.size() + 4096, 0);
+    taggedFile.replaceWithData(fileBytes.data(), fileBytes.size());
+    
+    TagReader tagReader;
+    TagReader::Tags fileTags;
+    if (!tagReader.readTags(taggedFile, fileTags) || fileTags.title != "Intro")
+    {
+        std::cerr << "Error: Tags not read from file: " << tagReader.getLastError() << std::endl;
+        return 1;
+    }
+    std::cout << "✓ Tags: " << fileTags.artist << " - " << fileTags.title << std::endl;
+    
+    // Re-tagging a copy changes its file hash but not its audio hash, which keys the analysis cache
+    std::cout << "\nTest 7b: Audio hash survives re-tagging..." << std::endl;
+    juce::File retaggedFile = testDir.getChildFile("retagged.mp3");
+    std::vector<uint8_t> retaggedBytes = { 'I', 'D', '3', 3, 0, 0, 0, 0, 0, 0 };  // Empty ID3v2 tag
+    retaggedBytes.resize(retaggedBytes.size() + 4096, 0);
+    retaggedBytes.insert(retaggedBytes.end(), { 'T', 'A', 'G' });
+    retaggedBytes.resize(retaggedBytes.size() + 125, ' ');  // ID3v1 trailer
+    retaggedFile.replaceWithData(retaggedBytes.data(), retaggedBytes.size());
+    
+    juce::Range<juce::int64> taggedAudio, retaggedAudio;
+    juce::String taggedHash, taggedAudioHash, retaggedHash, retaggedAudioHash;
+    
+    if (!tagReader.findAudioPayload(taggedFile, taggedAudio) || !tagReader.findAudioPayload(retaggedFile, retaggedAudio)
+        || taggedAudio.getLength() != 4096 || retaggedAudio != juce::Range<juce::int64>(10, 4106)
+        || !hasher.hashFile(taggedFile, taggedHash, taggedAudio, taggedAudioHash)
+        || !hasher.hashFile(retaggedFile, retaggedHash, retaggedAudio, retaggedAudioHash)
+        || taggedHash == retaggedHash || taggedAudioHash != retaggedAudioHash)
+    {
+        std::cerr << "Error: Audio hash changed with the tags!" << std::endl;
+        return 1;
+    }
+    
+    DatabaseManager::AnalysisCacheEntry cacheEntry, cachedEntry;
+    cacheEntry.audioHash = taggedAudioHash;
+    cacheEntry.duration = 0.1;
+    cacheEntry.bpm = 127.5;
+    cacheEntry.key = "8A";
+    cacheEntry.gridBpm = 127.5;
+    cacheEntry.beatGrid = { { 0.25, 127.5, 1 } };
+    
+    if (!dbManager.saveAnalysisCacheEntry(cacheEntry) || !dbManager.getAnalysisCacheEntry(retaggedAudioHash, cachedEntry)
+        || cachedEntry.bpm != 127.5 || cachedEntry.key != "8A" || cachedEntry.beatGrid.size() != 1
+        || dbManager.getAnalysisCacheEntry(taggedHash, cachedEntry))
+    {
+        std::cerr << "Error: Analysis cache entry not found by audio hash!" << std::endl;
+        return 1;
+    }
+    std::cout << "✓ Copies share audio hash " << retaggedAudioHash << std::endl;
+    
+    // Test tempo estimation on a synthetic onset envelope (one click per beat)
+    std::cout << "\nTest 8: Tempo estimation..." << std::endl;
+    const double frameRate = 86.13;
+    const double beatFrames = frameRate * 60.0 / 127.5;
+    std::vector<float> onsets((size_t) (frameRate * 60.0));
+    
+    for (size_t i = 0; i < onsets.size(); ++i)
+        onsets[i] = std::fmod((double) i, beatFrames) < 1.0 ? 1.0f : 0.0f;
+    
+    double detectedBpm = 0.0, tempoConfidence = 0.0;
+    if (!TempoAnalyser::estimateTempo(onsets, frameRate, detectedBpm, tempoConfidence)
+        || std::abs(detectedBpm - 127.5) > 0.05)
+    {
+        std::cerr << "Error: Expected 127.5 BPM, got " << detectedBpm << std::endl;
+        return 1;
+    }
+    std::cout << "✓ Tempo: " << detectedBpm << " BPM (confidence " << tempoConfidence << ")" << std::endl;
+    
+    // Test key matching on an A minor chroma (A, C, E strongest, then the rest of the scale)
+    std::cout << "\nTest 9: Key estimation..." << std::endl;
+    const std::array<double, 12> chroma { 0.8, 0.0, 0.4, 0.0, 0.9, 0.4, 0.0, 0.3, 0.1, 1.0, 0.0, 0.3 };
+    
+    double keyConfidence = 0.0;
+    auto detectedKey = KeyAnalyser::estimateKey(chroma, keyConfidence);
+    if (detectedKey != "Am")
+    {
+        std::cerr << "Error: Expected Am, got " << detectedKey << std::endl;
+        return 1;
+    }
+    std::cout << "✓ Key: " << detectedKey << " (confidence " << keyConfidence << ")" << std::endl;
+    
+    // Test 10: Loudness measurement
+    std::cout << "\nTest 10: Loudness measurement..." << std::endl;
+    const std::vector<float> blockEnergies (100, (float) std::pow(10.0, (-20.0 + 0.691) / 10.0));
+    
+    double integrated = 0.0, range = 0.0;
+    LoudnessAnalyser::measure(blockEnergies, integrated, range);
+    if (std::abs(integrated + 20.0) > 0.01 || range > 0.01)
+    {
+        std::cerr << "Error: Expected -20 LUFS with no range, got " << integrated << " LUFS, " << range << " LU" << std::endl;
+        return 1;
+    }
+    
+    const double replayGain = LoudnessAnalyser::getReplayGain(integrated, -10.0);
+    if (std::abs(replayGain - 2.0) > 0.01)
+    {
+        std::cerr << "Error: Expected 2 dB of gain, got " << replayGain << std::endl;
+        return 1;
+    }
+    std::cout << "✓ Loudness: " << integrated << " LUFS, gain " << replayGain << " dB" << std::endl;
+    
+    // Test 11: Beat grid from an onset envelope (120 BPM at 100 frames/s, bars start on the second beat)
+    std::cout << "\nTest 11: Beat grid..." << std::endl;
+    std::vector<float> beatOnsets (3000, 0.0f);
+    for (int frame = 25, beat = 0; frame < (int) beatOnsets.size(); frame += 50, ++beat)
+        beatOnsets[(size_t) frame] = beat % 4 == 1 ? 2.0f : 1.0f;
+    
+    std::vector<DatabaseManager::BeatGridMarker> markers;
+    if (!BeatGridAnalyser::analyse(beatOnsets, 100.0, 0.0, 120.0, markers) || markers.size() != 1
+        || std::abs(markers[0].position - 0.25) > 0.01 || std::abs(markers[0].bpm - 120.0) > 0.01 || markers[0].beat != 4)
+    {
+        std::cerr << "Error: Expected one marker at 0.25s, 120 BPM, beat 4" << std::endl;
+        return 1;
+    }
+    
+    DatabaseManager::BeatGrid savedGrid;
+    savedGrid.trackId = movedTrackId;
+    savedGrid.markers = markers;
+    
+    DatabaseManager::BeatGrid loadedGrid;
+    if (!dbManager.saveBeatGrid(savedGrid) || !dbManager.getBeatGrid(savedGrid.trackId, loadedGrid)
+        || loadedGrid.markers.size() != 1 || loadedGrid.markers[0].beat != 4)
+    {
+        std::cerr << "Error: Beat grid did not survive the database" << std::endl;
+        return 1;
+    }
+    std::cout << "✓ Grid marker at " << markers[0].position << "s, " << markers[0].bpm << " BPM" << std::endl;
+    
+    // Test 12: Sampling passes (a nine-minute file is sampled, a five-minute one is not)
+    std::cout << "\nTest 12: Sampling passes..." << std::endl;
+    AnalysisPolicy policy;
+    const juce::int64 longLength = 44100 * 540;
+    const auto longPasses = policy.createPasses(longLength, 44100.0);
+    
+    juce::int64 coveredLength = 0;
+    bool windowsInOrder = true;
+    for (const auto& pass : longPasses)
+    {
+        coveredLength += AnalysisPolicy::getLength(pass);
+        for (size_t i = 1; i < pass.size(); ++i)
+            windowsInOrder = windowsInOrder && pass[i].start >= pass[i - 1].getEnd();
+    }
+    
+    if (longPasses.size() != 3 || coveredLength != longLength || !windowsInOrder
+        || AnalysisPolicy::getLength(longPasses[0]) >= longLength / 2)
+    {
+        std::cerr << "Error: Expected three passes covering the file once" << std::endl;
+        return 1;
+    }
+    
+    if (policy.createPasses(44100 * 300, 44100.0).size() != 1)
+    {
+        std::cerr << "Error: Expected a five-minute file to be decoded whole" << std::endl;
+        return 1;
+    }
+    std::cout << "✓ First pass decodes " << AnalysisPolicy::getLength(longPasses[0]) * 100 / longLength
+              << "% of a nine-minute file" << std::endl;
+    
+    // Test 13: Resource governor (a playing preview leaves a single background-priority worker)
+    std::cout << "\nTest 13: Resource governor..." << std::endl;
+    ResourceGovernor governor(4);
+    governor.setPreviewActive(true);
+    const auto previewBudget = governor.getBudget();
+    governor.setPreviewActive(false);
+    const auto normalBudget = governor.getBudget();
+    
+    if (previewBudget.maxActiveWorkers != 1 || previewBudget.priority != juce::Thread::Priority::background
+        || previewBudget.maxBytesPerSecond <= 0 || normalBudget.maxActiveWorkers < 2 || normalBudget.maxBytesPerSecond != 0)
+    {
+        std::cerr << "Error: Preview did not throttle the workers" << std::endl;
+        return 1;
+    }
+    std::cout << "✓ " << normalBudget.maxActiveWorkers << " workers, 1 while previewing" << std::endl;
+    
+    // Test 14: Stage latency histogram (1 to 100 ms: mean 50.5, median within a bucket of 50)
+    std::cout << "\nTest 14: Analysis stage statistics..." << std::endl;
+    AnalysisStats stats;
+    for (int ms = 1; ms <= 100; ++ms)
+        stats.record(AnalysisStats::stageDecode, ms);
+    stats.recordFile(1024 * 1024);
+    
+    const auto statsSnapshot = stats.getSnapshot();
+    const auto& decodeStats = statsSnapshot.stages[AnalysisStats::stageDecode];
+    
+    if (decodeStats.count != 100 || std::abs(decodeStats.meanMs - 50.5) > 0.01 || decodeStats.maxMs != 100.0
+        || decodeStats.p50Ms < 25.0 || decodeStats.p50Ms > 100.0 || decodeStats.p95Ms < decodeStats.p50Ms
+        || statsSnapshot.stages[AnalysisStats::stageHash].count != 0 || statsSnapshot.filesProcessed != 1)
+    {
+        std::cerr << "Error: Stage statistics are wrong" << std::endl;
+        return 1;
+    }
+    std::cout << "✓ Decode median " << decodeStats.p50Ms << " ms, 95th percentile " << decodeStats.p95Ms << " ms" << std::endl;
+    
+    // Test 15: Memory-mapped PCM reads match the stream reader (a one-second 440 Hz stereo WAV)
+    std::cout << "\nTest 15: Memory-mapped WAV reader..." << std::endl;
+    auto wavFile = testDir.getChildFile("mapped.wav");
+    {
+        juce::WavAudioFormat wavFormat;
+        std::unique_ptr<juce::AudioFormatWriter> wavWriter(wavFormat.createWriterFor(new juce::FileOutputStream(wavFile),
+                                                                                     44100.0, 2, 16, {}, 0));
+        juce::AudioBuffer<float> tone(2, 44100);
+        for (int i = 0; i < tone.getNumSamples(); ++i)
+        {
+            const float value = 0.5f * std::sin(2.0f * juce::MathConstants<float>::pi * 440.0f * (float) i / 44100.0f);
+            tone.setSample(0, i, value);
+            tone.setSample(1, i, -value);
+        }
+        
+        if (wavWriter == nullptr || !wavWriter->writeFromAudioSampleBuffer(tone, 0, tone.getNumSamples()))
+        {
+            std::cerr << "Error: Could not write test WAV file" << std::endl;
+            return 1;
+        }
+    }
+    
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    auto mappedReader = MappedAudioReader::createReaderFor(formatManager, wavFile);
+    std::unique_ptr<juce::AudioFormatReader> streamReader(formatManager.createReaderFor(wavFile));
+    
+    if (mappedReader == nullptr || streamReader == nullptr || !MappedAudioReader::isMemoryMapped(*mappedReader)
+        || mappedReader->lengthInSamples != streamReader->lengthInSamples)
+    {
+        std::cerr << "Error: WAV file was not memory-mapped" << std::endl;
+        return 1;
+    }
+    
+    MappedAudioReader::prefetch(*mappedReader, 0, mappedReader->lengthInSamples);
+    
+    juce::AudioBuffer<float> mappedBlock(2, 4096), streamBlock(2, 4096);
+    mappedReader->read(&mappedBlock, 0, 4096, 20000, true, true);
+    streamReader->read(&streamBlock, 0, 4096, 20000, true, true);
+    
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        for (int i = 0; i < 4096; ++i)
+        {
+            if (mappedBlock.getSample(channel, i) != streamBlock.getSample(channel, i))
+            {
+                std::cerr << "Error: Mapped and stream readers disagree at sample " << 20000 + i << std::endl;
+                return 1;
+            }
+        }
+    }
+    std::cout << "✓ Mapped reader matches the stream reader, " << MappedAudioReader::getPrefetchSamples(*mappedReader)
+              << " samples per prefetch" << std::endl;
+    
+    // Test 16: Fingerprint front end (3 s of 48 kHz stereo: a 1 kHz tone passes, a 9 kHz tone is filtered out)
+    std::cout << "\nTest 16: Fingerprint resampler..." << std::endl;
+    FingerprintResampler resampler;
+    
+    auto resampleTone = [&resampler](double frequency, float& peak)
+    {
+        resampler.prepare(48000.0, 2);
+        juce::AudioBuffer<float> block(2, 8192);
+        int numOutput = 0;
+        peak = 0.0f;
+        
+        for (int start = 0; start < 48000 * 3; start += block.getNumSamples())
+        {
+            for (int i = 0; i < block.getNumSamples(); ++i)
+            {
+                const auto value = (float) (0.5 * std::sin(juce::MathConstants<double>::twoPi * frequency * (start + i) / 48000.0));
+                block.setSample(0, i, value);
+                block.setSample(1, i, value);
+            }
+            
+            const int produced = resampler.process(block, block.getNumSamples());
+            
+            for (int i = 0; i < produced; ++i)
+                peak = juce::jmax(peak, std::abs(resampler.getOutput()[i] / 32767.0f));
+            
+            numOutput += produced;
+        }
+        
+        return numOutput;
+    };
+    
+    float passPeak = 0.0f, stopPeak = 0.0f;
+    const int numResampled = resampleTone(1000.0, passPeak);
+    resampleTone(9000.0, stopPeak);
+    
+    if (std::abs(numResampled - FingerprintResampler::outputSampleRate * 3) > 64
+        || std::abs(passPeak - 0.5f) > 0.01f || stopPeak > 0.01f)
+    {
+        std::cerr << "Error: Resampled " << numResampled << " samples, peaks " << passPeak << " and " << stopPeak << std::endl;
+        return 1;
+    }
+    std::cout << "✓ " << numResampled << " samples at 11025 Hz, 9 kHz tone at " << stopPeak << " of full scale" << std::endl;
+    
+    // Test 17: Spectral fingerprint (a song matches its 48 kHz copy at half the level, not a different song)
+    std::cout << "\nTest 17: Spectral fingerprint..." << std::endl;
+    
+    // 20 seconds of chords, 24 random partials each, changing every 125 ms
+    auto writeSong = [&testDir](const juce::String& name, int seed, double sampleRate, float gain)
+    {
+        auto songFile = testDir.getChildFile(name);
+        juce::WavAudioFormat wavFormat;
+        std::unique_ptr<juce::AudioFormatWriter> songWriter(wavFormat.createWriterFor(new juce::FileOutputStream(songFile),
+                                                                                      sampleRate, 1, 16, {}, 0));
+        juce::AudioBuffer<float> song(1, static_cast<int>(sampleRate * 20.0));
+        std::vector<double> frequencies(24), amplitudes(24);
+        int chord = -1;
+        
+        for (int i = 0; i < song.getNumSamples(); ++i)
+        {
+            const double time = i / sampleRate;
+            
+            if (static_cast<int>(time * 8.0) != chord)
+            {
+                chord = static_cast<int>(time * 8.0);
+                juce::Random random(seed * 1000 + chord);
+                
+                for (size_t partial = 0; partial < frequencies.size(); ++partial)
+                {
+                    frequencies[partial] = 150.0 + random.nextDouble() * 3850.0;
+                    amplitudes[partial] = random.nextDouble();
+                }
+            }
+            
+            double value = 0.0;
+            for (size_t partial = 0; partial < frequencies.size(); ++partial)
+                value += amplitudes[partial] * std::sin(juce::MathConstants<double>::twoPi * frequencies[partial] * time);
+            
+            song.setSample(0, i, (float) (gain * 0.05 * std::exp(-4.0 * (time - chord / 8.0)) * value));
+        }
+        
+        return songWriter != nullptr && songWriter->writeFromAudioSampleBuffer(song, 0, song.getNumSamples());
+    };
+    
+    SpectralFingerprinter spectralFingerprinter;
+    
+    auto fingerprintSong = [&formatManager, &testDir, &spectralFingerprinter](const juce::String& name)
+    {
+        std::unique_ptr<juce::AudioFormatReader> songReader(formatManager.createReaderFor(testDir.getChildFile(name)));
+        
+        if (songReader == nullptr || !spectralFingerprinter.prepare(*songReader))
+            return std::vector<juce::uint32>();
+        
+        juce::AudioBuffer<float> block(1, 4096);
+        spectralFingerprinter.beginWindow(0, songReader->lengthInSamples);
+        
+        for (juce::int64 position = 0; spectralFingerprinter.wantsMoreAudio(); position += block.getNumSamples())
+        {
+            const int numSamples = static_cast<int>(juce::jmin((juce::int64) block.getNumSamples(),
+                                                               songReader->lengthInSamples - position));
+            songReader->read(&block, 0, numSamples, position, true, true);
+            spectralFingerprinter.processBlock(block, numSamples, position);
+        }
+        
+        spectralFingerprinter.finish();
+        return spectralFingerprinter.getFingerprint();
+    };
+    
+    if (!writeSong("song.wav", 1, 44100.0, 1.0f) || !writeSong("song-copy.wav", 1, 48000.0, 0.5f)
+        || !writeSong("other-song.wav", 2, 44100.0, 1.0f))
+    {
+        std::cerr << "Error: Could not write test songs" << std::endl;
+        return 1;
+    }
+    
+    const auto songBits = fingerprintSong("song.wav");
+    const auto copyBits = fingerprintSong("song-copy.wav");
+    const double copyBitErrorRate = SpectralFingerprinter::getBitErrorRate(songBits, copyBits);
+    const double otherBitErrorRate = SpectralFingerprinter::getBitErrorRate(songBits, fingerprintSong("other-song.wav"));
+    
+    if (songBits.empty() || copyBitErrorRate >= SpectralFingerprinter::matchThreshold
+        || otherBitErrorRate < SpectralFingerprinter::matchThreshold)
+    {
+        std::cerr << "Error: " << songBits.size() << " frames, bit error rates " << copyBitErrorRate
+                  << " (copy) and " << otherBitErrorRate << " (other song)" << std::endl;
+        return 1;
+    }
+    
+    DatabaseManager::AudioFingerprint savedFingerprint;
+    savedFingerprint.trackId = movedTrackId;
+    savedFingerprint.duration = 20.0;
+    savedFingerprint.bits = songBits;
+    
+    if (!dbManager.saveAudioFingerprint(savedFingerprint))
+    {
+        std::cerr << "Error: Could not save audio fingerprint" << std::endl;
+        return 1;
+    }
+    
+    DatabaseManager::AudioFingerprint loadedFingerprint;
+    const auto storedExcerpts = dbManager.getAudioFingerprintExcerpts(0, 64);
+    
+    if (!dbManager.getAudioFingerprint(movedTrackId, loadedFingerprint) || loadedFingerprint.bits != songBits
+        || storedExcerpts.size() != 1 || storedExcerpts[0].trackId != movedTrackId
+        || storedExcerpts[0].bits != std::vector<juce::uint32>(songBits.begin(), songBits.begin() + 64)
+        || !dbManager.getAudioFingerprintExcerpts(0, (int) songBits.size() + 1).empty())
+    {
+        std::cerr << "Error: Audio fingerprint did not survive the database" << std::endl;
+        return 1;
+    }
+    std::cout << "✓ " << songBits.size() << " frames, bit error rate " << copyBitErrorRate << " for the copy and "
+              << otherBitErrorRate << " for another song" << std::endl;
+    
+    // Test 18: Fingerprint index (the copy, trimmed by two seconds, is found among a thousand other tracks; silence is not)
+    std::cout << "\nTest 18: Fingerprint index..." << std::endl;
+    FingerprintIndex fingerprintIndex;
+    juce::Random indexRandom(18);
+    std::vector<juce::uint32> otherBits(400);
+    
+    for (int64_t otherTrackId = 1000; otherTrackId < 2000; ++otherTrackId)
+    {
+        for (auto& word : otherBits)
+            word = (juce::uint32) indexRandom.nextInt();
+        
+        fingerprintIndex.add(otherTrackId, otherBits);
+    }
+    
+    const auto excerpts = dbManager.getAudioFingerprintExcerpts(FingerprintIndex::excerptStartFrame,
+                                                                FingerprintIndex::excerptFrames);
+    
+    for (const auto& excerpt : excerpts)
+        fingerprintIndex.add(excerpt.trackId, excerpt.bits);
+    
+    const std::vector<juce::uint32> trimmedCopyBits(copyBits.begin() + 43, copyBits.end());
+    const auto indexMatches = fingerprintIndex.findMatches(trimmedCopyBits);
+    
+    if (excerpts.size() != 1 || (int) excerpts[0].bits.size() != FingerprintIndex::excerptFrames
+        || fingerprintIndex.getNumTracks() != 1001 || indexMatches.size() != 1 || indexMatches[0].trackId != movedTrackId)
+    {
+        std::cerr << "Error: Expected the copy to match only track " << movedTrackId << ", got "
+                  << indexMatches.size() << " matches" << std::endl;
+        return 1;
+    }
+    std::cout << "✓ Copy matched at bit error rate " << indexMatches[0].bitErrorRate << " among "
+              << fingerprintIndex.getNumTracks() << " tracks" << std::endl;
+    
+    // Every track has silence, so it is neither indexed nor looked up
+    const std::vector<juce::uint32> silentBits(400, SpectralFingerprinter::silentWord);
+    
+    if (fingerprintIndex.add(3000, silentBits) || !fingerprintIndex.findMatches(silentBits).empty())
+    {
+        std::cerr << "Error: Silence was indexed or matched" << std::endl;
+        return 1;
+    }
+    std::cout << "✓ Silence neither indexed nor matched" << std::endl;
+    
+    // A match is stored once per pair, read back from either side, and cleared by re-analysis
+    DatabaseManager::Track copyTrack;
+    copyTrack.filePath = testDir.getChildFile("song-copy.wav").getFullPathName();
+    copyTrack.title = "Song Copy";
+    copyTrack.dateAdded = juce::Time::getCurrentTime();
+    copyTrack.lastModified = juce::Time::getCurrentTime();
+    
+    int64_t copyTrackId = 0;
+    DatabaseManager::DuplicateMatch savedMatch;
+    savedMatch.duplicateId = movedTrackId;
+    savedMatch.bitErrorRate = indexMatches[0].bitErrorRate;
+    
+    if (!dbManager.addTrack(copyTrack, copyTrackId) || !dbManager.saveDuplicateMatches(copyTrackId, { savedMatch })
+        || dbManager.getAllDuplicateMatches().size() != 1 || dbManager.getDuplicateMatches(movedTrackId).size() != 1
+        || dbManager.getDuplicateMatches(movedTrackId)[0].duplicateId != copyTrackId
+        || !dbManager.saveDuplicateMatches(movedTrackId, {}) || !dbManager.getAllDuplicateMatches().empty())
+    {
+        std::cerr << "Error: Duplicate match was not stored once per pair" << std::endl;
+        return 1;
+    }
+    std::cout << "✓ Duplicate match stored and cleared" << std::endl;
+    
     // Cleanup
     std::cout << "\nCleaning up..." << std::endl;
     worker.stopWorker();
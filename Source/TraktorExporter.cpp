@@ -21,6 +21,7 @@
 */
 
 #include "TraktorExporter.h"
+#include "LoudnessAnalyser.h"
 
 //==============================================================================
 TraktorExporter::TraktorExporter(DatabaseManager& dbManager)
@@ -187,16 +188,35 @@ void TraktorExporter::writeTrackEntry(juce::XmlElement& collection,
         
         // Tempo
         auto* tempo = entry->createNewChildElement("TEMPO");
-        tempo->setAttribute("BPM", juce::String(static_cast<double>(track.bpm), 2));
+        tempo->setAttribute("BPM", juce::String(track.bpmPrecise > 0.0 ? track.bpmPrecise
+                                                                        : static_cast<double>(track.bpm), 6));
         tempo->setAttribute("BPM_QUALITY", 100);
     }
     
+    // Loudness, relative to the ReplayGain reference; Traktor's auto-gain applies the negated value
+    if (track.loudnessLufs < 0.0)
+    {
+        const auto relativeLoudness = juce::String(track.loudnessLufs - LoudnessAnalyser::referenceLoudness, 6);
+        
+        auto* loudness = entry->createNewChildElement("LOUDNESS");
+        loudness->setAttribute("PEAK_DB", juce::String(track.truePeakDb, 6));
+        loudness->setAttribute("PERCEIVED_DB", relativeLoudness);
+        loudness->setAttribute("ANALYZED_DB", relativeLoudness);
+    }
+    
     // Cue points
     auto cuePoints = databaseManager.getCuePointsForTrack(track.id);
     if (!cuePoints.empty())
     {
         writeCuePoints(*entry, cuePoints);
     }
+    
+    // Beat grid
+    DatabaseManager::BeatGrid beatGrid;
+    if (databaseManager.getBeatGrid(track.id, beatGrid))
+    {
+        writeGridMarkers(*entry, beatGrid.markers);
+    }
 }
 
 void TraktorExporter::writeCuePoints(juce::XmlElement& entry,
@@ -207,7 +227,7 @@ void TraktorExporter::writeCuePoints(juce::XmlElement& entry,
         auto* cueV2 = entry.createNewChildElement("CUE_V2");
         cueV2->setAttribute("NAME", cue.name);
         cueV2->setAttribute("TYPE", cue.type);
-        cueV2->setAttribute("START", juce::String(cue.position, 3));
+        cueV2->setAttribute("START", juce::String(cue.position * 1000.0, 3));  // Milliseconds
         
         // Traktor hotcue number (0-7)
         if (cue.hotCueNumber >= 0 && cue.hotCueNumber < 8)
@@ -223,6 +243,26 @@ void TraktorExporter::writeCuePoints(juce::XmlElement& entry,
     }
 }
 
+void TraktorExporter::writeGridMarkers(juce::XmlElement& entry,
+                                       const std::vector<DatabaseManager::BeatGridMarker>& markers)
+{
+    for (const auto& marker : markers)
+    {
+        // Traktor's grid markers sit on downbeats, so move on to the next one
+        const int beatsToDownbeat = (5 - marker.beat) % 4;
+        const double position = marker.position + beatsToDownbeat * 60.0 / marker.bpm;
+        
+        auto* cueV2 = entry.createNewChildElement("CUE_V2");
+        cueV2->setAttribute("NAME", "AutoGrid");
+        cueV2->setAttribute("DISPL_ORDER", 0);
+        cueV2->setAttribute("TYPE", 4);  // Grid marker
+        cueV2->setAttribute("START", juce::String(position * 1000.0, 3));  // Milliseconds
+        cueV2->setAttribute("LEN", 0);
+        cueV2->setAttribute("REPEATS", -1);
+        cueV2->setAttribute("HOTCUE", -1);
+    }
+}
+
 void TraktorExporter::writePlaylists(juce::XmlElement& playlists)
 {
     // Create root node
@@ -75,6 +75,7 @@ private:
                              const std::vector<DatabaseManager::Track>& tracks);
     void writeTrackEntry(juce::XmlElement& collection, const DatabaseManager::Track& track);
     void writeCuePoints(juce::XmlElement& entry, const std::vector<DatabaseManager::CuePoint>& cues);
+    void writeGridMarkers(juce::XmlElement& entry, const std::vector<DatabaseManager::BeatGridMarker>& markers);
     void writePlaylists(juce::XmlElement& playlists);
     void writePlaylistNode(juce::XmlElement& parent, const DatabaseManager::VirtualFolder& folder);
     
@@ -21,6 +21,7 @@
 */
 
 #include "WaveformComponent.h"
+#include "MappedAudioReader.h"
 
 //==============================================================================
 WaveformComponent::WaveformComponent()
@@ -47,7 +48,7 @@ bool WaveformComponent::loadAudioFile(const juce::File& audioFile)
     clear();
     
     currentFile = audioFile;
-    audioReader.reset(formatManager.createReaderFor(audioFile));
+    audioReader = MappedAudioReader::createReaderFor(formatManager, audioFile);
     
     if (audioReader == nullptr)
     {
@@ -66,6 +67,44 @@ bool WaveformComponent::loadAudioFile(const juce::File& audioFile)
     return true;
 }
 
+bool WaveformComponent::loadOverview(const DatabaseManager::WaveformOverview& overview)
+{
+    clear();
+    
+    if (overview.getNumBins() == 0)
+    {
+        lastError = "Empty waveform overview";
+        return false;
+    }
+    
+    waveformData.reserve((size_t) overview.getNumBins());
+    
+    for (int i = 0; i < overview.getNumBins(); ++i)
+    {
+        waveformData.push_back({ overview.minMax[(size_t) (2 * i)] / 127.0f,
+                                 overview.minMax[(size_t) (2 * i + 1)] / 127.0f });
+    }
+    
+    duration = overview.duration;
+    isLoaded = true;
+    repaint();
+    
+    return true;
+}
+
+bool WaveformComponent::loadTrack(const DatabaseManager& databaseManager, const DatabaseManager::Track& track)
+{
+    DatabaseManager::WaveformOverview overview;
+    
+    if (databaseManager.getWaveformOverview(track.id, overview) && loadOverview(overview))
+    {
+        currentFile = juce::File(track.filePath);
+        return true;
+    }
+    
+    return loadAudioFile(juce::File(track.filePath));
+}
+
 void WaveformComponent::clear()
 {
     audioReader.reset();
@@ -211,12 +250,23 @@ void WaveformComponent::generateWaveform()
     const int numChannels = static_cast<int>(audioReader->numChannels);
     juce::AudioBuffer<float> buffer(numChannels, static_cast<int>(samplesPerBlock));
     
+    const auto prefetchSamples = MappedAudioReader::getPrefetchSamples(*audioReader);
+    int64_t prefetchedUntil = 0;
+    
     for (int i = 0; i < targetSamples; ++i)
     {
         const int64_t startSample = i * samplesPerBlock;
         
         if (startSample < audioReader->lengthInSamples)
         {
+            // The blocks are contiguous, so a mapped file can be read ahead of them
+            if (startSample + samplesPerBlock > prefetchedUntil)
+            {
+                const auto prefetchLength = juce::jmax(prefetchSamples, samplesPerBlock);
+                MappedAudioReader::prefetch(*audioReader, startSample, prefetchLength);
+                prefetchedUntil = startSample + prefetchLength;
+            }
+            
             audioReader->read(&buffer, 0, static_cast<int>(samplesPerBlock), startSample, true, true);
             
             float minVal = 0.0f;
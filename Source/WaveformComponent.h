@@ -24,6 +24,7 @@
 
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_audio_formats/juce_audio_formats.h>
+#include "DatabaseManager.h"
 #include <vector>
 #include <functional>
 
@@ -51,6 +52,21 @@ public:
      */
     bool loadAudioFile(const juce::File& audioFile);
     
+    /**
+     * Show a precomputed waveform overview (as stored by the analysis pipeline).
+     * No audio is decoded.
+     * @param overview The overview to display
+     * @return true if the overview contained any data
+     */
+    bool loadOverview(const DatabaseManager::WaveformOverview& overview);
+    
+    /**
+     * Show a library track, using its stored overview when there is one and
+     * decoding the file only as a fallback.
+     * @return true if loading was successful
+     */
+    bool loadTrack(const DatabaseManager& databaseManager, const DatabaseManager::Track& track);
+    
     /**
      * Clear the current waveform.
      */